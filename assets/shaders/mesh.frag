@@ -0,0 +1,16 @@
+#version 450
+
+layout(location = 0) in vec3 inColor;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUV;
+
+layout(location = 0) out vec4 outFragColor;
+
+void main() {
+  // a fixed light until there are lights, the UVs tint the surface so they
+  // can be checked
+  vec3 lightDirection = normalize(vec3(0.3f, 1.f, 0.5f));
+  float diffuse = max(dot(normalize(inNormal), lightDirection), 0.f);
+  vec3 albedo = inColor * mix(vec3(0.8f), vec3(inUV, 1.f), 0.2f);
+  outFragColor = vec4(albedo * (0.2f + 0.8f * diffuse), 1.f);
+}
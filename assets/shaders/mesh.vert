@@ -0,0 +1,34 @@
+#version 450
+
+// mesh_format::Vertex, see packed_vertex_description()
+layout(location = 0) in vec3 vPosition;
+// octahedral encoding, already in [-1, 1]
+layout(location = 1) in vec2 vNormal;
+layout(location = 2) in vec2 vUV;
+layout(location = 3) in vec4 vColor;
+
+layout(location = 0) out vec3 outColor;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec2 outUV;
+
+layout(push_constant) uniform constants {
+  mat4 renderMatrix;
+  mat4 model;
+} PushConstants;
+
+// inverse of mesh_format::encode_octahedral()
+vec3 oct_decode(vec2 e) {
+  vec3 n = vec3(e, 1.f - abs(e.x) - abs(e.y));
+  // the lower half was folded over the diagonals
+  float t = max(-n.z, 0.f);
+  n.x += n.x >= 0.f ? -t : t;
+  n.y += n.y >= 0.f ? -t : t;
+  return normalize(n);
+}
+
+void main() {
+  gl_Position = PushConstants.renderMatrix * vec4(vPosition, 1.f);
+  outColor = vColor.rgb;
+  outNormal = mat3(PushConstants.model) * oct_decode(vNormal);
+  outUV = vUV;
+}
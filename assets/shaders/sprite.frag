@@ -0,0 +1,16 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 inUV;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) flat in uint inTexture;
+
+layout(location = 0) out vec4 outFragColor;
+
+// every texture of the bindless heap, the sprites of a batch may sample
+// different atlas pages
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+void main() {
+  outFragColor = texture(textures[nonuniformEXT(inTexture)], inUV) * inColor;
+}
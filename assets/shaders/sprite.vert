@@ -0,0 +1,38 @@
+#version 450
+
+// SpriteInstance, see SpriteBatcher::instance_description()
+layout(location = 0) in vec2 iPosition;
+layout(location = 1) in vec2 iSize;
+// uvMin then uvMax
+layout(location = 2) in vec4 iUVRect;
+layout(location = 3) in float iRotation;
+layout(location = 4) in vec4 iColor;
+// atlas page, in the bindless heap
+layout(location = 5) in uint iTexture;
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outColor;
+layout(location = 2) flat out uint outTexture;
+
+layout(push_constant) uniform constants {
+  // from pixels to [0, 2]
+  vec2 screenScale;
+} PushConstants;
+
+void main() {
+  // two triangles per quad
+  const vec2 corners[6] =
+      vec2[6](vec2(-0.5f, -0.5f), vec2(0.5f, -0.5f), vec2(0.5f, 0.5f),
+              vec2(-0.5f, -0.5f), vec2(0.5f, 0.5f), vec2(-0.5f, 0.5f));
+  vec2 corner = corners[gl_VertexIndex];
+
+  float s = sin(iRotation);
+  float c = cos(iRotation);
+  vec2 pixel = iPosition + mat2(c, s, -s, c) * (corner * iSize);
+
+  // Y goes down both in pixels and in Vulkan clip space
+  gl_Position = vec4(pixel * PushConstants.screenScale - 1.f, 0.f, 1.f);
+  outUV = mix(iUVRect.xy, iUVRect.zw, corner + 0.5f);
+  outColor = iColor;
+  outTexture = iTexture;
+}
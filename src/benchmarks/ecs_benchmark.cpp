@@ -0,0 +1,212 @@
+// Compares iterating entities stored by the ECS, each component in an array
+// of its own, with a plain array of structs holding every field of an
+// object. Reports JSON:
+//
+//   ./alternative-engine-ecs-benchmark --entities 262144 --output ecs.json
+//
+// The update only reads the velocity and writes the position, the other
+// fields of the structs are the cold data a game object drags along. Also
+// times a parallel query and applying a command buffer
+
+#include "../engine/core/JobSystem.hpp"
+#include "../engine/ecs/CommandBuffer.hpp"
+#include "../engine/ecs/World.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  struct Options {
+      uint32_t entities = 1 << 18;
+      uint32_t repeat = 10;
+      uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+      // "-" writes the report to stdout
+      std::string output = "ecs_benchmark.json";
+  };
+
+  struct Position {
+      float x, y, z;
+  };
+  struct Velocity {
+      float x, y, z;
+  };
+  struct Transform {
+      float matrix[16];
+  };
+  struct Health {
+      float current, max;
+  };
+  struct Name {
+      char text[32];
+  };
+
+  // the naive layout, every field of an object next to each other
+  struct GameObject {
+      Position position;
+      Velocity velocity;
+      Transform transform;
+      Health health;
+      Name name;
+  };
+
+  constexpr float DELTA_TIME = 1.f / 60.f;
+
+  void print_usage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " [--entities N] [--repeat N] [--threads N] [--output FILE]"
+              << std::endl;
+  }
+
+  bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+      auto has_value = [&]() { return i + 1 < argc; };
+
+      if (std::strcmp(argv[i], "--entities") == 0 && has_value()) {
+        options.entities = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--repeat") == 0 && has_value()) {
+        options.repeat = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--threads") == 0 && has_value()) {
+        options.threads = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--output") == 0 && has_value()) {
+        options.output = argv[++i];
+      } else {
+        return false;
+      }
+    }
+    return options.entities > 0 && options.repeat > 0 && options.threads > 0;
+  }
+
+  // best of the runs, the others were disturbed by something else
+  template <typename F> double best_ms(uint32_t repeat, F &&run) {
+    double best = 0.0;
+    for (uint32_t i = 0; i < repeat; i++) {
+      auto start = std::chrono::steady_clock::now();
+      run();
+      auto end = std::chrono::steady_clock::now();
+      double ms =
+          std::chrono::duration<double, std::milli>(end - start).count();
+      best = i == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+  }
+
+  void integrate(Position &position, const Velocity &velocity) {
+    position.x += velocity.x * DELTA_TIME;
+    position.y += velocity.y * DELTA_TIME;
+    position.z += velocity.z * DELTA_TIME;
+  }
+
+  void write_result(std::ostream &out, const char *name, double ms,
+                    double baselineMs, uint32_t entities, bool last) {
+    out << "    \"" << name << "\": {\"ms\": " << ms
+        << ", \"ns_per_entity\": " << ms * 1000000.0 / entities
+        << ", \"speedup\": " << baselineMs / ms << "}"
+        << (last ? "\n" : ",\n");
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<GameObject> objects(options.entities);
+  AltE::World world;
+  for (uint32_t i = 0; i < options.entities; i++) {
+    Velocity velocity{(float)(i % 7), 1.f, (float)(i % 3)};
+    objects[i].velocity = velocity;
+    // two archetypes, the queries go through both
+    if (i % 2 == 0) {
+      world.create(Position{}, velocity, Transform{}, Health{}, Name{});
+    } else {
+      world.create(Position{}, velocity, Transform{}, Name{});
+    }
+  }
+
+  double aosMs = best_ms(options.repeat, [&]() {
+    for (GameObject &object : objects) {
+      integrate(object.position, object.velocity);
+    }
+  });
+
+  double eachMs = best_ms(options.repeat, [&]() {
+    world.each<Position, const Velocity>(
+        [](AltE::Entity, Position &position, const Velocity &velocity) {
+          integrate(position, velocity);
+        });
+  });
+
+  double chunkMs = best_ms(options.repeat, [&]() {
+    world.each_chunk<Position, const Velocity>(
+        [](uint32_t count, const AltE::Entity *, Position *positions,
+           const Velocity *velocities) {
+          for (uint32_t i = 0; i < count; i++) {
+            integrate(positions[i], velocities[i]);
+          }
+        });
+  });
+
+  AltE::JobSystem jobs;
+  jobs.init(options.threads - 1);
+  double parallelMs = best_ms(options.repeat, [&]() {
+    world.parallel_each<Position, const Velocity>(
+        jobs, [](AltE::Entity, Position &position, const Velocity &velocity) {
+          integrate(position, velocity);
+        });
+  });
+
+  // a health component for one entity in ten, recorded by the jobs and
+  // applied after the query. Only timed once, it changes the world
+  std::vector<AltE::CommandBuffer> buffers(jobs.worker_count() + 1);
+  auto start = std::chrono::steady_clock::now();
+  world.parallel_each<const Position>(
+      jobs, [&](AltE::Entity entity, const Position &) {
+        if (entity._index % 10 == 0) {
+          buffers[AltE::JobSystem::worker_index()].add(entity,
+                                                       Health{1.f, 1.f});
+        }
+      });
+  for (AltE::CommandBuffer &buffer : buffers) {
+    buffer.apply(world);
+  }
+  double commandMs = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  jobs.shutdown();
+
+  std::ofstream file;
+  if (options.output != "-") {
+    file.open(options.output);
+    if (!file.is_open()) {
+      std::cerr << "Can't open " << options.output << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = options.output == "-" ? std::cout : file;
+
+  out << "{\n";
+  out << "  \"entities\": " << options.entities << ",\n";
+  out << "  \"threads\": " << options.threads << ",\n";
+  out << "  \"aos_object_bytes\": " << sizeof(GameObject) << ",\n";
+  out << "  \"unit\": \"ms\",\n";
+  out << "  \"update\": {\n";
+  write_result(out, "aos", aosMs, aosMs, options.entities, false);
+  write_result(out, "ecs_each", eachMs, aosMs, options.entities, false);
+  write_result(out, "ecs_each_chunk", chunkMs, aosMs, options.entities,
+               false);
+  write_result(out, "ecs_parallel_each", parallelMs, aosMs,
+               options.entities, true);
+  out << "  },\n";
+  out << "  \"command_buffer_ms\": " << commandMs << "\n";
+  out << "}" << std::endl;
+
+  return EXIT_SUCCESS;
+}
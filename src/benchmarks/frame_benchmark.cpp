@@ -0,0 +1,189 @@
+// Renders a fixed number of headless frames and reports the frame timings as
+// percentiles in JSON, so every commit gets a regression number. Runs without
+// a display, on any Vulkan driver including lavapipe:
+//
+//   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json \
+//     ./alternative-engine-benchmark --frames 1000 --output bench.json
+
+#include "../engine/application/App.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+  struct Options {
+      uint32_t frames = 1000;
+      uint32_t warmup = 60;
+      uint32_t width = 1280;
+      uint32_t height = 720;
+      // triangles per frame, high counts go through the parallel recording
+      uint32_t draws = 1;
+      // sprites per frame, batched into a few instanced draws
+      uint32_t sprites = 0;
+      // objects of the GPU driven scene, culled by a compute shader
+      uint32_t objects = 1024;
+      bool validation = false;
+      // "-" writes the report to stdout, mixed with the engine logs
+      std::string output = "frame_benchmark.json";
+      // Chrome trace of the measured frames, none when empty
+      std::string trace;
+      // the engine logs, written to the console only when empty
+      std::string log;
+  };
+
+  void print_usage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " [--frames N] [--warmup N] [--width W] [--height H]"
+                 " [--draws N] [--sprites N] [--objects N] [--validation]"
+                 " [--output FILE] [--trace FILE] [--log FILE]"
+              << std::endl;
+  }
+
+  bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+      auto has_value = [&]() { return i + 1 < argc; };
+
+      if (std::strcmp(argv[i], "--frames") == 0 && has_value()) {
+        options.frames = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--warmup") == 0 && has_value()) {
+        options.warmup = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--width") == 0 && has_value()) {
+        options.width = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--height") == 0 && has_value()) {
+        options.height = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--draws") == 0 && has_value()) {
+        options.draws = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--sprites") == 0 && has_value()) {
+        options.sprites = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--objects") == 0 && has_value()) {
+        options.objects = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--validation") == 0) {
+        options.validation = true;
+      } else if (std::strcmp(argv[i], "--output") == 0 && has_value()) {
+        options.output = argv[++i];
+      } else if (std::strcmp(argv[i], "--trace") == 0 && has_value()) {
+        options.trace = argv[++i];
+      } else if (std::strcmp(argv[i], "--log") == 0 && has_value()) {
+        options.log = argv[++i];
+      } else {
+        return false;
+      }
+    }
+    return options.frames > 0 && options.width > 0 && options.height > 0;
+  }
+
+  // nearest-rank percentile of an already sorted list
+  double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+      return 0.0;
+    }
+    size_t rank = (size_t)(p / 100.0 * (double)(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+  }
+
+  void write_metric(std::ostream &out, const char *name,
+                    std::vector<double> values, bool last) {
+    std::sort(values.begin(), values.end());
+
+    double mean = 0.0;
+    for (double v : values) {
+      mean += v;
+    }
+    if (!values.empty()) {
+      mean /= (double)values.size();
+    }
+
+    out << "    \"" << name << "\": {";
+    out << "\"samples\": " << values.size();
+    if (!values.empty()) {
+      out << ", \"mean\": " << mean;
+      out << ", \"min\": " << values.front();
+      out << ", \"p50\": " << percentile(values, 50.0);
+      out << ", \"p90\": " << percentile(values, 90.0);
+      out << ", \"p95\": " << percentile(values, 95.0);
+      out << ", \"p99\": " << percentile(values, 99.0);
+      out << ", \"max\": " << values.back();
+    }
+    out << "}" << (last ? "\n" : ",\n");
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  AltE::AppConfig config;
+  config.headless = true;
+  config.validation = options.validation;
+  config.collectTimings = true;
+  config.extent = {options.width, options.height};
+  config.drawCount = options.draws;
+  config.spriteCount = options.sprites;
+  config.sceneObjectCount = options.objects;
+  config.traceFile = options.trace;
+  config.logFile = options.log;
+
+  AltE::App app{};
+  app.init(config);
+
+  // let the driver settle (pipeline compilation, memory residency...)
+  for (uint32_t i = 0; i < options.warmup; i++) {
+    app.draw();
+  }
+  app.take_frame_timings();
+
+  for (uint32_t i = 0; i < options.frames; i++) {
+    app.draw();
+  }
+  std::vector<AltE::FrameTimings> timings = app.take_frame_timings();
+
+  app.cleanup();
+
+  if (timings.empty()) {
+    std::cerr << "No frame has been rendered" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<double> cpuRecord, submit, gpu;
+  for (const AltE::FrameTimings &t : timings) {
+    cpuRecord.push_back(t.cpuRecordMs);
+    submit.push_back(t.submitMs);
+    if (t.gpuMs >= 0.0) {
+      gpu.push_back(t.gpuMs);
+    }
+  }
+
+  std::ofstream file;
+  if (options.output != "-") {
+    file.open(options.output);
+    if (!file.is_open()) {
+      std::cerr << "Can't open " << options.output << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = options.output == "-" ? std::cout : file;
+
+  out << "{\n";
+  out << "  \"frames\": " << timings.size() << ",\n";
+  out << "  \"width\": " << options.width << ",\n";
+  out << "  \"height\": " << options.height << ",\n";
+  out << "  \"draws\": " << options.draws << ",\n";
+  out << "  \"sprites\": " << options.sprites << ",\n";
+  out << "  \"objects\": " << options.objects << ",\n";
+  out << "  \"unit\": \"ms\",\n";
+  out << "  \"metrics\": {\n";
+  write_metric(out, "cpu_record", cpuRecord, false);
+  write_metric(out, "submit", submit, false);
+  write_metric(out, "gpu", gpu, true);
+  out << "  }\n";
+  out << "}" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+// Measures how the job system scales from 1 to N threads, and what a single
+// job costs. Reports JSON:
+//
+//   ./alternative-engine-job-benchmark --max-threads 8 --output jobs.json
+//
+// "threads" counts the calling thread, which takes part in parallel_for.
+// With 1 thread the work runs as a plain loop, the baseline of the speedups
+
+#include "../engine/core/JobSystem.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  struct Options {
+      uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+      // items of the scaling workload
+      uint32_t items = 1 << 20;
+      // empty jobs of the overhead workload
+      uint32_t jobs = 100000;
+      uint32_t repeat = 10;
+      // "-" writes the report to stdout
+      std::string output = "job_benchmark.json";
+  };
+
+  void print_usage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " [--max-threads N] [--items N] [--jobs N] [--repeat N]"
+                 " [--output FILE]"
+              << std::endl;
+  }
+
+  bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+      auto has_value = [&]() { return i + 1 < argc; };
+
+      if (std::strcmp(argv[i], "--max-threads") == 0 && has_value()) {
+        options.maxThreads = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--items") == 0 && has_value()) {
+        options.items = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--jobs") == 0 && has_value()) {
+        options.jobs = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--repeat") == 0 && has_value()) {
+        options.repeat = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--output") == 0 && has_value()) {
+        options.output = argv[++i];
+      } else {
+        return false;
+      }
+    }
+    return options.maxThreads > 0 && options.items > 0 && options.repeat > 0;
+  }
+
+  // enough arithmetic per item for the work to be compute bound
+  void process(std::vector<uint32_t> &values, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      uint32_t x = values[i] | 1;
+      for (int round = 0; round < 64; round++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+      }
+      values[i] = x;
+    }
+  }
+
+  // best of the runs, the others were disturbed by something else
+  template <typename F> double best_ms(uint32_t repeat, F &&run) {
+    double best = 0.0;
+    for (uint32_t i = 0; i < repeat; i++) {
+      auto start = std::chrono::steady_clock::now();
+      run();
+      auto end = std::chrono::steady_clock::now();
+      double ms =
+          std::chrono::duration<double, std::milli>(end - start).count();
+      best = i == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<uint32_t> values(options.items);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = (uint32_t)i;
+  }
+
+  std::ofstream file;
+  if (options.output != "-") {
+    file.open(options.output);
+    if (!file.is_open()) {
+      std::cerr << "Can't open " << options.output << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = options.output == "-" ? std::cout : file;
+
+  out << "{\n";
+  out << "  \"items\": " << options.items << ",\n";
+  out << "  \"jobs\": " << options.jobs << ",\n";
+  out << "  \"unit\": \"ms\",\n";
+  out << "  \"scaling\": [\n";
+
+  double baseline = best_ms(options.repeat,
+                            [&]() { process(values, 0, values.size()); });
+
+  for (uint32_t threads = 1; threads <= options.maxThreads; threads++) {
+    double parallelMs = baseline;
+    double jobMs = 0.0;
+
+    if (threads > 1) {
+      AltE::JobSystem jobs;
+      jobs.init(threads - 1);
+
+      parallelMs = best_ms(options.repeat, [&]() {
+        jobs.parallel_for(values.size(), 4096, [&](size_t begin, size_t end) {
+          process(values, begin, end);
+        });
+      });
+
+      // the cost of scheduling alone
+      jobMs = best_ms(options.repeat, [&]() {
+        AltE::JobCounter counter;
+        for (uint32_t i = 0; i < options.jobs; i++) {
+          jobs.run([]() {}, &counter);
+        }
+        jobs.wait(counter);
+      });
+
+      jobs.shutdown();
+    }
+
+    double speedup = baseline / parallelMs;
+    out << "    {\"threads\": " << threads
+        << ", \"parallel_for\": " << parallelMs
+        << ", \"speedup\": " << speedup
+        << ", \"efficiency\": " << speedup / threads;
+    if (threads > 1) {
+      out << ", \"ns_per_job\": " << jobMs * 1000000.0 / options.jobs;
+    }
+    out << "}" << (threads == options.maxThreads ? "\n" : ",\n");
+  }
+
+  out << "  ]\n";
+  out << "}" << std::endl;
+
+  return EXIT_SUCCESS;
+}
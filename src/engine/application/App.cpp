@@ -1,100 +1,329 @@
 #include "App.hpp"
+#include "../assets/ImageLoader.hpp"
 #include "../rendering/PipelineBuilder.hpp"
-#include "../rendering/shader_utils.hpp"
+#include "../rendering/PipelineCompiler.hpp"
+#include "../rendering/vk_check.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <mutex>
+#include <numbers>
+#include <spdlog/async.h>
+#include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
 #include <SDL2/SDL_vulkan.h>
 #include <VkBootstrap.h>
 
-#define VK_CHECK(x)                                                            \
-  {                                                                            \
-    VkResult err = x;                                                          \
-    if (err != VK_SUCCESS) {                                                   \
-      spdlog::default_logger()->error("Detected Vulkan error: {}", err);       \
-      abort();                                                                 \
-    }                                                                          \
+namespace {
+  // vertex stage push constants of mesh.vert
+  struct MeshPushConstants {
+      glm::mat4 renderMatrix;
+      glm::mat4 model;
+  };
+
+  VkPresentModeKHR to_vulkan(AltE::PresentMode mode) {
+    switch (mode) {
+      case AltE::PresentMode::FifoRelaxed:
+        return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+      case AltE::PresentMode::Mailbox:
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+      case AltE::PresentMode::Immediate:
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+      case AltE::PresentMode::Fifo:
+        break;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
   }
 
-namespace AltE {
-  void App::init() {
-    // We initialize SDL and create a window with it
-    SDL_Init(SDL_INIT_VIDEO);
+  const char *present_mode_name(AltE::PresentMode mode) {
+    switch (mode) {
+      case AltE::PresentMode::FifoRelaxed:
+        return "FIFO relaxed";
+      case AltE::PresentMode::Mailbox:
+        return "mailbox";
+      case AltE::PresentMode::Immediate:
+        return "immediate";
+      case AltE::PresentMode::Fifo:
+        break;
+    }
+    return "FIFO";
+  }
 
-    SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN);
+  // validation messages with the same id logged before they are rate
+  // limited, then one of them is logged per interval
+  constexpr uint32_t VALIDATION_BURST = 5;
+  constexpr auto VALIDATION_INTERVAL = std::chrono::seconds(1);
+
+  struct RepeatedMessage {
+      int32_t _id = 0;
+      // messages seen with this id, 0 for a free entry
+      uint32_t _count = 0;
+      // dropped since the last one logged
+      uint32_t _suppressed = 0;
+      std::chrono::steady_clock::time_point _lastLogged;
+  };
+
+  // the validation layers call back from every thread using the device
+  std::mutex repeatedMessagesMutex;
+  // open addressing on the message id, the ids past the table are never
+  // limited
+  std::array<RepeatedMessage, 128> repeatedMessages;
+
+  // false when the message is dropped. Otherwise suppressed is the number
+  // of messages with this id dropped since the last one logged
+  bool rate_limit(int32_t id, uint32_t &suppressed) {
+    suppressed = 0;
+    // id 0 is shared by unrelated messages, the loader ones for example
+    if (id == 0) {
+      return true;
+    }
 
-    // create blank SDL window for our application
-    _window = SDL_CreateWindow(
-        "Alternative-Engine",    // window title
-        SDL_WINDOWPOS_UNDEFINED, // window position x (don't care)
-        SDL_WINDOWPOS_UNDEFINED, // window position y (don't care)
-        _windowExtent.width,     // window width in pixels
-        _windowExtent.height,    // window height in pixels
-        window_flags);
+    std::lock_guard<std::mutex> lock(repeatedMessagesMutex);
+    size_t index = (uint32_t)id % repeatedMessages.size();
+    for (size_t probe = 0; probe < repeatedMessages.size(); probe++) {
+      RepeatedMessage &message =
+          repeatedMessages[(index + probe) % repeatedMessages.size()];
+      if (message._count != 0 && message._id != id) {
+        continue;
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      message._id = id;
+      message._count++;
+      if (message._count > VALIDATION_BURST &&
+          now - message._lastLogged < VALIDATION_INTERVAL) {
+        message._suppressed++;
+        return false;
+      }
+      suppressed = message._suppressed;
+      message._suppressed = 0;
+      message._lastLogged = now;
+      return true;
+    }
+    return true;
+  }
+} // namespace
+
+namespace AltE {
+  void App::init(const AppConfig &config) {
+    _config = config;
+    _windowExtent = config.extent;
+
+    // before the workers start, so their first zones are kept
+    Profiler::set_enabled(!_config.traceFile.empty());
+    Profiler::set_thread_name("main");
+
+    // workers for the background tasks, the main thread keeps one core
+    _jobs.init(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+    if (!_config.headless) {
+      // We initialize SDL and create a window with it
+      SDL_Init(SDL_INIT_VIDEO);
+
+      SDL_WindowFlags window_flags = (SDL_WindowFlags)(
+          SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+
+      // create blank SDL window for our application
+      _window = SDL_CreateWindow(
+          "Alternative-Engine",    // window title
+          SDL_WINDOWPOS_UNDEFINED, // window position x (don't care)
+          SDL_WINDOWPOS_UNDEFINED, // window position y (don't care)
+          _windowExtent.width,     // window width in pixels
+          _windowExtent.height,    // window height in pixels
+          window_flags);
+    }
 
     // configure the logger
     init_logger();
     // load the core Vulkan structure
     init_vulkan();
-    // create the swapchain
-    init_swapchain();
+    // create the GPU memory allocator
+    init_allocator();
+    // start streaming uploads on the transfer queue
+    init_uploads();
+    if (_config.headless) {
+      // create the images we render to instead of the swapchain
+      init_offscreen_targets();
+    } else {
+      // create the swapchain
+      init_swapchain();
+    }
     // create the command pool
     init_commands();
-    // create the render pass
-    init_default_renderpass();
-    // create the framebuffers
-    init_framebuffers();
+    // create the render passes and the framebuffers
+    init_render_graph();
     // create the render semaphores
     init_sync_structures();
+    // create the bindless descriptor set of the textures and buffers
+    init_bindless();
+    // fill the sprite atlas
+    init_sprites();
+    // upload the meshes and fill the scene
+    init_meshes();
     // create pipeline
     init_pipeline();
 
+    if (!_config.headless && _config.hotReloadShaders) {
+      _shaderWatcher.start(asset_directory() / "shaders");
+    }
+
+    if (!_config.headless) {
+      _framePacer.init(display_refresh_rate());
+      _framePacer.set_enabled(_config.lowLatency);
+      _loopScheduler.set_target_rate(_config.targetFrameRate);
+      _loopScheduler.set_background_rate(_config.backgroundFrameRate);
+    }
+
+    // the logic ticks on its own thread from now on
+    _simulation.start(_config.simulationRate);
+
     // everthing went fine
     _isInitialized = true;
-    spdlog::default_logger()->info("App initialized");
+    _allocator.log_statistics();
+    spdlog::default_logger()->info("App initialized{}",
+                                   _config.headless ? " (headless)" : "");
   }
 
   void App::cleanup() {
     if (_isInitialized) {
+      _simulation.stop();
+
       // make sure the gpu has stopped doing its things
       vkDeviceWaitIdle(_device);
 
+      // every frame is resolved, and the names of the zones are still alive
+      if (!_config.traceFile.empty()) {
+        for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+          resolve_frame_timings(_frames[i]);
+        }
+        if (Profiler::write_chrome_trace(_config.traceFile)) {
+          spdlog::default_logger()->info("Trace written to {}",
+                                         _config.traceFile);
+        } else {
+          spdlog::default_logger()->error("Can't write the trace to {}",
+                                          _config.traceFile);
+        }
+      }
+
+      // no more recompilations, and no pipeline left on the workers
+      _shaderWatcher.stop();
+      for (ReloadablePipeline &reloadable : _reloadablePipelines) {
+        if (reloadable._rebuild.valid()) {
+          vkDestroyPipeline(_device, reloadable._rebuild.get(), nullptr);
+        }
+        vkDestroyPipeline(_device, *reloadable._pipeline, nullptr);
+      }
+
+      // the workers record commands and create pipelines, they must be
+      // gone before the device is
+      _jobs.shutdown();
+
       _mainDeletionQueue.flush();
 
-      vkDestroySurfaceKHR(_instance, _surface, nullptr);
+      if (_surface != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(_instance, _surface, nullptr);
+      }
 
       vkDestroyDevice(_device, nullptr);
       vkb::destroy_debug_utils_messenger(_instance, _debug_messenger);
       vkDestroyInstance(_instance, nullptr);
 
-      SDL_DestroyWindow(_window);
+      if (_window != nullptr) {
+        SDL_DestroyWindow(_window);
+      }
     }
-    spdlog::default_logger()->debug("Engine closed");
+    SPDLOG_DEBUG("Engine closed");
+    // drains the queue of the async backend, flushes the sinks and joins
+    // the backend and flush_every threads. Nothing can be logged after this
+    spdlog::shutdown();
   }
 
   void App::draw() {
     // check if window is minimized and skip drawing
-    if (SDL_GetWindowFlags(_window) & SDL_WINDOW_MINIMIZED)
+    if (_window != nullptr &&
+        (SDL_GetWindowFlags(_window) & SDL_WINDOW_MINIMIZED))
       return;
 
-    // wait until the GPU has finished rendering the last frame. Timeout of 1
-    // second
-    VK_CHECK(vkWaitForFences(_device, 1, &_renderFence, true, 1000000000));
-    VK_CHECK(vkResetFences(_device, 1, &_renderFence));
+    ALTE_PROFILE_SCOPE("draw");
+
+    FrameData &frame = get_current_frame();
+
+    {
+      ALTE_PROFILE_SCOPE("wait for the GPU");
+      // wait until the GPU has finished rendering the last frame that used
+      // this slot of the ring. Timeout of 1 second
+      VK_CHECK(
+          vkWaitForFences(_device, 1, &frame._renderFence, true, 1000000000));
+    }
+
+    // every frame up to the previous use of this slot is done, what they
+    // retired can go
+    if (_frameNumber >= (int)FRAME_OVERLAP) {
+      _mainDeletionQueue.collect(_frameNumber - FRAME_OVERLAP);
+      _bindless.collect(_frameNumber - FRAME_OVERLAP);
+    }
+
+    // the timestamps of the previous use of this slot are now available
+    resolve_frame_timings(frame);
+
+    // the GPU is done with the per-frame data of this slot too
+    _frameAllocator.begin_frame(_frameNumber % FRAME_OVERLAP);
+
+    // nothing is recorded yet, the pipelines can be swapped
+    update_hot_reload();
+
+    if (_swapchainDirty) {
+      recreate_swapchain();
+      if (_swapchainDirty) {
+        // the window has no area to draw to
+        return;
+      }
+    }
 
-    // request image from the swapchain, one second timeout
     uint32_t swapchainImageIndex;
-    VK_CHECK(vkAcquireNextImageKHR(_device, _swapchain, 1000000000,
-                                   _presentSemaphore, nullptr,
-                                   &swapchainImageIndex));
+    if (_config.headless) {
+      // there is one offscreen image per frame in flight
+      swapchainImageIndex = _frameNumber % FRAME_OVERLAP;
+    } else {
+      // request image from the swapchain, one second timeout
+      VkResult acquireResult = vkAcquireNextImageKHR(
+          _device, _swapchain, 1000000000, frame._presentSemaphore, nullptr,
+          &swapchainImageIndex);
+      if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+        // no image was acquired and the semaphore won't be signaled, skip
+        // this frame and try again with a new swapchain
+        _swapchainDirty = true;
+        return;
+      }
+      if (acquireResult == VK_SUBOPTIMAL_KHR) {
+        // still usable, it is replaced after this frame
+        _swapchainDirty = true;
+      } else {
+        VK_CHECK(acquireResult);
+      }
+    }
+
+    // only reset the fence once we know this frame is going to be submitted,
+    // otherwise the next wait would never return
+    VK_CHECK(vkResetFences(_device, 1, &frame._renderFence));
 
-    // now that we are sure that the commands finished executing, we can safely
-    // reset the command buffer to begin recording again.
-    VK_CHECK(vkResetCommandBuffer(_mainCommandBuffer, 0));
+    auto recordStart = std::chrono::steady_clock::now();
+
+    // now that we are sure that the commands of this frame finished executing,
+    // we can safely reset the whole pool to begin recording again.
+    VK_CHECK(vkResetCommandPool(_device, frame._commandPool, 0));
+    _recorder.begin_frame(_frameNumber % FRAME_OVERLAP);
 
     // naming it cmd for shorter writing
-    VkCommandBuffer cmd = _mainCommandBuffer;
+    VkCommandBuffer cmd = frame._mainCommandBuffer;
 
     // begin the command buffer recording. We will use this command buffer
     // exactly once, so we want to let Vulkan know that
@@ -107,159 +336,486 @@ namespace AltE {
 
     VK_CHECK(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
 
-    // make a clear-color from frame number. This will flash wih a 120*pi frame
-    // period
+    // take ownership of what has been uploaded since the last frame. The
+    // submit below waits for those uploads to complete
+    uint64_t uploadValue = _uploadQueue.record_acquire_barriers(cmd);
+
+    // images added to atlas pages the previous frames may still sample
+    _atlas.record_updates(cmd);
+
+    // resets the timestamps of this slot, and starts the frame zone
+    _gpuProfiler.begin_frame(cmd, _frameNumber % FRAME_OVERLAP);
+
+    // what the simulation decided, between its two latest ticks
+    SimulationState state = _simulation.sample(Simulation::Clock::now());
+
     VkClearValue clearValue;
-    float flash = abs(sin(_frameNumber / 120.f));
-    clearValue.color = {{0.f, 0.f, flash, 1.f}};
-
-    // start the main renderpass
-    // we will use the clear color from above, and the framebuffer of the index
-    // the swapchain gave us
-    VkRenderPassBeginInfo rpInfo = {};
-    rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    rpInfo.pNext = nullptr;
-
-    rpInfo.renderPass = _renderPass;
-    rpInfo.renderArea.offset.x = 0;
-    rpInfo.renderArea.offset.y = 0;
-    rpInfo.renderArea.extent = _windowExtent;
-    rpInfo.framebuffer = _framebuffers[swapchainImageIndex];
-
-    // connect clear values
-    rpInfo.clearValueCount = 1;
-    rpInfo.pClearValues = &clearValue;
-
-    vkCmdBeginRenderPass(cmd, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    // once we start adding rendering commands, they will go here
-    if (_selectedShader == 0) {
-      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        _trianglePipeline);
-    } else {
-      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                        _redTrianglePipeline);
+    clearValue.color = {{state._clearColor[0], state._clearColor[1],
+                         state._clearColor[2], state._clearColor[3]}};
+    _renderGraph.set_clear_value(_colorTarget, clearValue);
+
+    _drawList.clear();
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.f, 1.5f, 2.5f), glm::vec3(0.f),
+                                 glm::vec3(0.f, 1.f, 0.f));
+    glm::mat4 projection = glm::perspective(
+        glm::radians(70.f),
+        (float)_windowExtent.width / (float)_windowExtent.height, 0.1f, 100.f);
+    // Vulkan has Y going down in clip space
+    projection[1][1] *= -1.f;
+    glm::mat4 viewProjection = projection * view;
+
+    // the plane turning slowly under the camera. There is no depth buffer
+    // yet, it is drawn first so the triangles stay on top
+    if (_planeMesh.valid()) {
+      MeshPushConstants constants;
+      constants.model = glm::rotate(glm::mat4(1.f),
+                                    glm::radians(state._planeAngle),
+                                    glm::vec3(0.f, 1.f, 0.f));
+      constants.renderMatrix = viewProjection * constants.model;
+      _drawList.add_mesh(_meshPipeline, _planeMesh, _meshPipelineLayout,
+                         &constants, sizeof(constants));
     }
 
-    vkCmdDraw(cmd, 3, 1, 0, 0);
+    // the field of planes below, culled by a compute shader writing the
+    // draws read by a single indirect draw. The dispatch has to be outside
+    // of the render pass
+    if (_scene.supported()) {
+      _gpuProfiler.begin_zone(cmd, "cull");
+      _scene.record_cull(cmd, viewProjection);
+      _gpuProfiler.end_zone(cmd);
+      _scene.draw(_drawList, _scenePipeline, viewProjection);
+    }
+
+    VkPipeline pipeline =
+        _selectedShader == 0 ? _trianglePipeline : _redTrianglePipeline;
+    for (uint32_t i = 0; i < _config.drawCount; i++) {
+      _drawList.add(pipeline, 3);
+    }
+
+    // sprites wandering over the rest, batched into a few instanced draws
+    if (!_spriteImages.empty()) {
+      _spriteBatcher.begin(_windowExtent);
+      // in double, the simulated time outgrows the precision of a float
+      double time = state._time;
+      for (uint32_t i = 0; i < _config.spriteCount; i++) {
+        const AtlasRegion &image = _spriteImages[i % _spriteImages.size()];
+        float phase = i * 0.37f;
+
+        Sprite sprite;
+        sprite._position[0] = (0.5f + 0.45f * std::sin(time * 0.7f + phase)) *
+                              _windowExtent.width;
+        sprite._position[1] =
+            (0.5f + 0.45f * std::sin(time * 1.1f + phase * 1.7f)) *
+            _windowExtent.height;
+        sprite._size[0] = (float)image._width;
+        sprite._size[1] = (float)image._height;
+        sprite._rotation =
+            (float)std::fmod(time + phase, 2.0 * std::numbers::pi);
+        sprite._layer = (int32_t)(i % 2);
+        _spriteBatcher.add(_spritePipeline, image, sprite);
+      }
+      _spriteBatcher.flush(_drawList);
+    }
+
+    // big lists are recorded by the workers into secondary command buffers,
+    // small ones straight into the primary
+    _renderGraph.set_contents(
+        _mainPass, ParallelRecorder::worth_parallel(_drawList.size())
+                       ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                       : VK_SUBPASS_CONTENTS_INLINE);
+
+    // records the passes and the barriers between them, the image the
+    // swapchain gave us is the output
+    _renderGraph.execute(cmd, swapchainImageIndex, &_gpuProfiler);
+
+    _gpuProfiler.end_frame(cmd);
 
-    // finalize the render pass
-    vkCmdEndRenderPass(cmd);
     // finalize the command buffer (we can no longer add commands, but it can
     // now be executed)
     VK_CHECK(vkEndCommandBuffer(cmd));
 
+    // make what has been written in the per-frame buffer visible to the GPU
+    _frameAllocator.flush();
+
+    auto submitStart = std::chrono::steady_clock::now();
+
     // prepare the submission to the queue
     // we want to wait on the _presentSemaphore, as that semaphore is signaled
     // when the swapchain is ready we will signal the _renderSemaphore, to
     // signal that rendering has finished
+    // without a swapchain there is nothing to wait on or to signal
+    // we also wait on the upload timeline when this frame uses new uploads
 
     VkSubmitInfo submit = {};
     submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submit.pNext = nullptr;
 
-    VkPipelineStageFlags waitStage =
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    VkSemaphore waitSemaphores[2];
+    VkPipelineStageFlags waitStages[2];
+    // binary semaphores ignore their value
+    uint64_t waitValues[2];
+    uint32_t waitCount = 0;
 
-    submit.pWaitDstStageMask = &waitStage;
+    if (!_config.headless) {
+      waitSemaphores[waitCount] = frame._presentSemaphore;
+      waitStages[waitCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+      waitValues[waitCount] = 0;
+      waitCount++;
 
-    submit.waitSemaphoreCount = 1;
-    submit.pWaitSemaphores = &_presentSemaphore;
+      submit.signalSemaphoreCount = 1;
+      submit.pSignalSemaphores = &frame._renderSemaphore;
+    }
+
+    if (uploadValue != 0) {
+      waitSemaphores[waitCount] = _uploadQueue.timeline();
+      waitStages[waitCount] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+      waitValues[waitCount] = uploadValue;
+      waitCount++;
+    }
 
-    submit.signalSemaphoreCount = 1;
-    submit.pSignalSemaphores = &_renderSemaphore;
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.pNext = nullptr;
+    timelineInfo.waitSemaphoreValueCount = waitCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+
+    submit.pNext = &timelineInfo;
+    submit.waitSemaphoreCount = waitCount;
+    submit.pWaitSemaphores = waitSemaphores;
+    submit.pWaitDstStageMask = waitStages;
 
     submit.commandBufferCount = 1;
     submit.pCommandBuffers = &cmd;
 
-    // submit command buffer to the queue and execute it
-    // _renderFence will now block until the graphic commands finish execution
-    VK_CHECK(vkQueueSubmit(_graphicsQueue, 1, &submit, _renderFence));
-
-    // this will put the image we jsut rendered into the visible window
-    // we want to wait on the _renderSemaphore for that,
-    // as it's necessary that drawing commands have finished before the image is
-    // displayed to the user
-    VkPresentInfoKHR presentInfo = {};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.pNext = nullptr;
+    {
+      ALTE_PROFILE_SCOPE("submit");
+      // the upload thread may submit to the same queue
+      std::lock_guard<std::mutex> queueLock(_graphicsQueueMutex);
 
-    presentInfo.pSwapchains = &_swapchain;
-    presentInfo.swapchainCount = 1;
+      // submit command buffer to the queue and execute it
+      // _renderFence will now block until the graphic commands finish
+      // execution
+      VK_CHECK(
+          vkQueueSubmit(_graphicsQueue, 1, &submit, frame._renderFence));
+
+      if (!_config.headless) {
+        // this will put the image we jsut rendered into the visible window
+        // we want to wait on the _renderSemaphore for that,
+        // as it's necessary that drawing commands have finished before the
+        // image is displayed to the user
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.pNext = nullptr;
+
+        presentInfo.pSwapchains = &_swapchain;
+        presentInfo.swapchainCount = 1;
+
+        presentInfo.pWaitSemaphores = &frame._renderSemaphore;
+        presentInfo.waitSemaphoreCount = 1;
+
+        presentInfo.pImageIndices = &swapchainImageIndex;
+
+        VkResult presentResult =
+            vkQueuePresentKHR(_graphicsQueue, &presentInfo);
+        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR ||
+            presentResult == VK_SUBOPTIMAL_KHR) {
+          _swapchainDirty = true;
+        } else {
+          VK_CHECK(presentResult);
+        }
+      }
+    }
 
-    presentInfo.pWaitSemaphores = &_renderSemaphore;
-    presentInfo.waitSemaphoreCount = 1;
+    auto submitEnd = std::chrono::steady_clock::now();
 
-    presentInfo.pImageIndices = &swapchainImageIndex;
+    if (!_config.headless) {
+      _framePacer.frame_presented();
+    }
 
-    VK_CHECK(vkQueuePresentKHR(_graphicsQueue, &presentInfo));
+    // keep the CPU timings until the GPU time of this frame can be read back
+    frame._pendingTimings = {};
+    frame._pendingTimings.frameNumber = _frameNumber;
+    frame._pendingTimings.cpuRecordMs =
+        std::chrono::duration<double, std::milli>(submitStart - recordStart)
+            .count();
+    frame._pendingTimings.submitMs =
+        std::chrono::duration<double, std::milli>(submitEnd - submitStart)
+            .count();
+    frame._hasPendingTimings = true;
 
     // increase the number of frames drawn
     _frameNumber++;
   }
 
+  void App::record_main_pass(VkCommandBuffer cmd,
+                             const RenderPassContext &context) {
+    // the viewport and the scissor are dynamic, the pipelines work with any
+    // swapchain size
+    VkViewport viewport = {};
+    viewport.x = 0.f;
+    viewport.y = 0.f;
+    viewport.width = (float)context._extent.width;
+    viewport.height = (float)context._extent.height;
+    viewport.minDepth = 0.f;
+    viewport.maxDepth = 1.f;
+
+    VkRect2D scissor = {};
+    scissor.offset = {0, 0};
+    scissor.extent = context._extent;
+
+    if (context._contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+      VkCommandBufferInheritanceInfo inheritance = {};
+      inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+      inheritance.pNext = nullptr;
+      inheritance.renderPass = context._renderPass;
+      inheritance.subpass = 0;
+      inheritance.framebuffer = context._framebuffer;
+
+      _recorder.record(cmd, _drawList, inheritance, viewport, scissor);
+    } else {
+      vkCmdSetViewport(cmd, 0, 1, &viewport);
+      vkCmdSetScissor(cmd, 0, 1, &scissor);
+      _drawList.record(cmd, 0, _drawList.size());
+    }
+  }
+
+  void App::resolve_frame_timings(FrameData &frame) {
+    if (!frame._hasPendingTimings) {
+      return;
+    }
+    frame._hasPendingTimings = false;
+
+    // the fence of the frame is signaled, the GPU zones of the frame are
+    // read back and the frame one is its GPU time
+    frame._pendingTimings.gpuMs =
+        _gpuProfiler.resolve((uint32_t)(&frame - _frames));
+
+    if (_config.collectTimings) {
+      _completedTimings.push_back(frame._pendingTimings);
+    }
+  }
+
+  std::vector<FrameTimings> App::take_frame_timings() {
+    // wait for the frames still in flight and read back their timings, in
+    // submission order
+    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+      FrameData &frame = _frames[(_frameNumber + i) % FRAME_OVERLAP];
+      VK_CHECK(
+          vkWaitForFences(_device, 1, &frame._renderFence, true, 1000000000));
+      resolve_frame_timings(frame);
+    }
+
+    std::vector<FrameTimings> timings;
+    timings.swap(_completedTimings);
+    return timings;
+  }
+
+  std::filesystem::path App::asset_directory() {
+    // the executables are written to bin/, next to assets/
+    std::filesystem::path base;
+    if (char *basePath = SDL_GetBasePath()) {
+      base = basePath;
+      SDL_free(basePath);
+    }
+    return base / ".." / "assets";
+  }
+
+  void App::update_hot_reload() {
+    for (const std::string &name : _shaderWatcher.take_recompiled()) {
+      if (_shaderLibrary.reload(name) == VK_NULL_HANDLE) {
+        continue;
+      }
+      for (ReloadablePipeline &reloadable : _reloadablePipelines) {
+        if (std::find(reloadable._shaderNames.begin(),
+                      reloadable._shaderNames.end(),
+                      name) != reloadable._shaderNames.end()) {
+          reloadable._dirty = true;
+        }
+      }
+    }
+
+    for (ReloadablePipeline &reloadable : _reloadablePipelines) {
+      // never wait on the workers, a rebuild that isn't done yet is picked
+      // up on a later frame
+      if (reloadable._rebuild.valid() &&
+          reloadable._rebuild.wait_for(std::chrono::seconds(0)) ==
+              std::future_status::ready) {
+        VkPipeline pipeline = reloadable._rebuild.get();
+        if (pipeline == VK_NULL_HANDLE) {
+          spdlog::default_logger()->error(
+              "Failed to rebuild a pipeline, keeping the previous one");
+        } else {
+          // frames still in flight may be using the old one
+          _mainDeletionQueue.retire(_frameNumber, DeletionType::Pipeline,
+                                    *reloadable._pipeline);
+          *reloadable._pipeline = pipeline;
+        }
+      }
+
+      if (reloadable._dirty && !reloadable._rebuild.valid()) {
+        reloadable._dirty = false;
+        for (size_t i = 0; i < reloadable._shaderNames.size(); i++) {
+          reloadable._description._shaderStages[i].module =
+              _shaderLibrary.get(reloadable._shaderNames[i]);
+        }
+        reloadable._rebuild =
+            _pipelineCompiler.compile(reloadable._description);
+      }
+    }
+  }
+
+  FrameData &App::get_current_frame() {
+    return _frames[_frameNumber % FRAME_OVERLAP];
+  }
+
   void App::run() {
-    spdlog::default_logger()->debug("Running engine");
+    if (_config.headless) {
+      spdlog::default_logger()->error(
+          "There is no window to run in headless mode, call draw() instead");
+      return;
+    }
 
-    SDL_Event e;
-    bool bQuit = false;
-    bool isFullScreen = false;
+    SPDLOG_DEBUG("Running engine");
 
     // main loop
-    while (!bQuit) {
-      // Handle events on queue
-      while (SDL_PollEvent(&e) != 0) {
-        // close the window when user clicks the X button or alt+F4
-        if (e.type == SDL_QUIT) {
-          spdlog::default_logger()->debug("Received close event");
-          bQuit = true;
-        } else if (e.type == SDL_KEYDOWN) {
-          if (e.key.keysym.sym == SDLK_F11) {
-            if (!isFullScreen) {
-              // if F11+SHIFT => borderless fullscreen
-              if (e.key.keysym.mod & KMOD_SHIFT) {
-                SDL_SetWindowFullscreen(_window, SDL_WINDOW_FULLSCREEN_DESKTOP);
-                spdlog::default_logger()->debug(
-                    "Changed window to borderless fullscreen mode");
-
-              } else {
-                // fullscreen
-                SDL_SetWindowFullscreen(_window, SDL_WINDOW_FULLSCREEN);
-                spdlog::default_logger()->debug(
-                    "Changed window to fullscreen mode");
-              }
-              isFullScreen = true;
-            } else {
-              // windowed
-              SDL_SetWindowFullscreen(_window, SDL_FALSE);
-
-              spdlog::default_logger()->debug(
-                  "Changed window to windowed mode");
-              isFullScreen = false;
-            }
-          } else if (e.key.keysym.sym == SDLK_SPACE) {
-            _selectedShader += 1;
-            if (_selectedShader > 1) {
-              _selectedShader = 0;
+    std::vector<InputEvent> events;
+    while (!_quit) {
+      LoopState state = loop_state();
+      // nothing to show while minimized, the simulation sleeps too
+      _simulation.set_paused(state == LoopState::Minimized);
+      bool drawFrame = _loopScheduler.wait_for_frame(state, _input);
+
+      // in low latency mode, wait here so the events read below are as
+      // recent as possible when the frame is displayed
+      if (drawFrame) {
+        _framePacer.wait_for_frame_start();
+      }
+
+      // work the other threads need done on the main thread, like SDL calls
+      _jobs.run_main_jobs();
+
+      // the events read while the loop waited, and the ones since
+      _input.pump();
+      events.clear();
+      _input.take(events);
+      for (const InputEvent &event : events) {
+        handle_event(event._event);
+      }
+
+      if (drawFrame) {
+        draw();
+      }
+    }
+  }
+
+  LoopState App::loop_state() const {
+    uint32_t flags = SDL_GetWindowFlags(_window);
+    if (flags & SDL_WINDOW_MINIMIZED) {
+      return LoopState::Minimized;
+    }
+    if (!(flags & SDL_WINDOW_INPUT_FOCUS)) {
+      return LoopState::Background;
+    }
+    return LoopState::Active;
+  }
+
+  void App::handle_event(const SDL_Event &event) {
+    // close the window when user clicks the X button or alt+F4
+    if (event.type == SDL_QUIT) {
+      SPDLOG_DEBUG("Received close event");
+      _quit = true;
+    } else if (event.type == SDL_WINDOWEVENT &&
+               event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+      // resized by the user or by a fullscreen switch. Not every
+      // platform reports an out of date swapchain, so don't wait for it
+      _swapchainDirty = true;
+    } else if (event.type == SDL_KEYDOWN) {
+      if (event.key.keysym.sym == SDLK_F11) {
+        if (!_isFullScreen) {
+          // if F11+SHIFT => borderless fullscreen
+          if (event.key.keysym.mod & KMOD_SHIFT) {
+            SDL_SetWindowFullscreen(_window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+            SPDLOG_DEBUG("Changed window to borderless fullscreen mode");
+
+          } else {
+            // fullscreen, at the native resolution instead of switching
+            // the display to the size of the window
+            SDL_DisplayMode desktopMode;
+            if (SDL_GetDesktopDisplayMode(SDL_GetWindowDisplayIndex(_window),
+                                          &desktopMode) == 0) {
+              SDL_SetWindowDisplayMode(_window, &desktopMode);
             }
+            SDL_SetWindowFullscreen(_window, SDL_WINDOW_FULLSCREEN);
+            SPDLOG_DEBUG("Changed window to fullscreen mode");
           }
+          _isFullScreen = true;
+        } else {
+          // windowed
+          SDL_SetWindowFullscreen(_window, SDL_FALSE);
+
+          SPDLOG_DEBUG("Changed window to windowed mode");
+          _isFullScreen = false;
+        }
+      } else if (event.key.keysym.sym == SDLK_F3) {
+        _allocator.log_statistics();
+
+        PresentIntervals intervals = _framePacer.take_present_intervals();
+        spdlog::default_logger()->info(
+            "Present intervals over {} frames: mean {:.2f} ms, min "
+            "{:.2f} ms, p99 {:.2f} ms, max {:.2f} ms",
+            intervals.count, intervals.meanMs, intervals.minMs,
+            intervals.p99Ms, intervals.maxMs);
+      } else if (event.key.keysym.sym == SDLK_F4) {
+        // cycle through the present modes
+        set_present_mode((PresentMode)(((int)_config.presentMode + 1) % 4));
+      } else if (event.key.keysym.sym == SDLK_F5) {
+        set_low_latency(!_config.lowLatency);
+      } else if (event.key.keysym.sym == SDLK_SPACE) {
+        _selectedShader += 1;
+        if (_selectedShader > 1) {
+          _selectedShader = 0;
         }
       }
-
-      draw();
     }
   }
 
   void App::init_logger() {
     try {
-      auto console_sink =
-          std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+      std::vector<spdlog::sink_ptr> sinks;
+      sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+      if (!_config.logFile.empty()) {
+        // fully buffered, the file is written when the buffer is full or
+        // when the logger flushes
+        spdlog::file_event_handlers handlers;
+        handlers.after_open = [](const spdlog::filename_t &, FILE *file) {
+          std::setvbuf(file, nullptr, _IOFBF, 64 * 1024);
+        };
+        sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(
+            _config.logFile, true, handlers));
+      }
 
-      spdlog::set_default_logger(std::make_shared<spdlog::logger>(
-          "AltE", spdlog::sinks_init_list{console_sink}));
+      std::shared_ptr<spdlog::logger> logger;
+      if (_config.asyncLogging) {
+        // a single backend thread formats and writes the messages queued in
+        // a preallocated ring. When it falls behind the oldest messages are
+        // dropped instead of blocking the thread logging
+        spdlog::init_thread_pool(8192, 1);
+        logger = std::make_shared<spdlog::async_logger>(
+            "AltE", sinks.begin(), sinks.end(), spdlog::thread_pool(),
+            spdlog::async_overflow_policy::overrun_oldest);
+      } else {
+        logger = std::make_shared<spdlog::logger>("AltE", sinks.begin(),
+                                                  sinks.end());
+      }
+      spdlog::set_default_logger(logger);
+      // the levels below SPDLOG_ACTIVE_LEVEL are compiled out already
       spdlog::default_logger()->set_level(spdlog::level::trace);
       spdlog::default_logger()->set_pattern(
           "\033[90m[%Y-%m-%d %T.%e]\033[m [\033[33m%n\033[m] [%^%=9l%$] %v");
+      // errors are written out right away, in case they are the last words
+      spdlog::default_logger()->flush_on(spdlog::level::err);
+      spdlog::flush_every(std::chrono::seconds(1));
     } catch (const spdlog::spdlog_ex &ex) {
       std::cerr << "Log initialization failed: " << ex.what() << std::endl;
       abort();
@@ -271,31 +827,41 @@ namespace AltE {
       VkDebugUtilsMessageTypeFlagsEXT messageTypes,
       const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData,
       void *pUserData) {
-    auto severity = vkb::to_string_message_severity(messageSeverity);
-    auto type = vkb::to_string_message_type(messageTypes);
-
+    spdlog::level::level_enum level;
     switch (messageSeverity) {
-      case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-        spdlog::default_logger()->debug("[{}] {}", type,
-                                        pCallbackData->pMessage);
-        break;
       case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-        spdlog::default_logger()->error("[{}] {}", type,
-                                        pCallbackData->pMessage);
+        level = spdlog::level::err;
         break;
       case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-        spdlog::default_logger()->warn("[{}] {}", type,
-                                       pCallbackData->pMessage);
+        level = spdlog::level::warn;
         break;
       case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-        spdlog::default_logger()->info("[{}] {}", type,
-                                       pCallbackData->pMessage);
+        level = spdlog::level::info;
         break;
       default:
-        spdlog::default_logger()->debug("[{}] {}", type,
-                                        pCallbackData->pMessage);
+        level = spdlog::level::debug;
         break;
     }
+    // the verbose messages are compiled out with the debug logs
+    if (level < SPDLOG_ACTIVE_LEVEL) {
+      return VK_FALSE;
+    }
+
+    // the same message is often reported for every draw or every frame
+    uint32_t suppressed;
+    if (!rate_limit(pCallbackData->messageIdNumber, suppressed)) {
+      return VK_FALSE;
+    }
+
+    auto type = vkb::to_string_message_type(messageTypes);
+    if (suppressed > 0) {
+      spdlog::default_logger()->log(level,
+                                    "[{}] {} ({} similar messages dropped)",
+                                    type, pCallbackData->pMessage, suppressed);
+    } else {
+      spdlog::default_logger()->log(level, "[{}] {}", type,
+                                    pCallbackData->pMessage);
+    }
 
     return VK_FALSE;
   }
@@ -304,29 +870,109 @@ namespace AltE {
     vkb::InstanceBuilder builder;
 
     // make the Vulkan instance, with basic debug features
+    // in headless mode we don't need any of the surface extensions
     auto inst_ret = builder.set_app_name("Alternative-Engine")
-                        .request_validation_layers(true)
-                        .require_api_version(1, 1, 0)
+                        .request_validation_layers(_config.validation)
+                        .set_headless(_config.headless)
+                        .require_api_version(1, 2, 0)
                         .set_debug_callback(App::configure_logger)
                         .build();
 
+    if (!inst_ret) {
+      spdlog::default_logger()->error("Failed to create Vulkan instance: {}",
+                                      inst_ret.error().message());
+      abort();
+    }
+
     vkb::Instance vkb_inst = inst_ret.value();
     // store the instance
     _instance = vkb_inst.instance;
     // store the debug messenger
     _debug_messenger = vkb_inst.debug_messenger;
 
-    // get the surface of the window we opened with SDL
-    SDL_Vulkan_CreateSurface(_window, _instance, &_surface);
-
     // use vkboostratp to select a GPU
-    // We want a GPU that can write to the SDL surface and supports Vulkan 1.1
+    // We want a GPU that supports Vulkan 1.2 with timeline semaphores, the
+    // descriptor indexing of the bindless heap and, unless we are headless,
+    // can write to the SDL surface
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.timelineSemaphore = VK_TRUE;
+    features12.descriptorIndexing = VK_TRUE;
+    features12.runtimeDescriptorArray = VK_TRUE;
+    features12.descriptorBindingPartiallyBound = VK_TRUE;
+    features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    features12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+
     vkb::PhysicalDeviceSelector selector{vkb_inst};
+    selector.set_minimum_version(1, 2).set_required_features_12(features12);
 
-    vkb::PhysicalDevice physicalDevice = selector.set_minimum_version(1, 1)
-                                             .set_surface(_surface)
-                                             .select()
-                                             .value();
+    if (!_config.headless) {
+      // get the surface of the window we opened with SDL
+      SDL_Vulkan_CreateSurface(_window, _instance, &_surface);
+      selector.set_surface(_surface);
+    }
+
+    auto physicalDeviceRet = selector.select();
+    if (!physicalDeviceRet) {
+      spdlog::default_logger()->error("Failed to select a GPU: {}",
+                                      physicalDeviceRet.error().message());
+      abort();
+    }
+
+    // the GPU driven scene uses the indirect draw features the GPU has, the
+    // selection is made again with them required so they get enabled
+    VkPhysicalDeviceVulkan12Features supported12 = {};
+    supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 supported = {};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &supported12;
+    vkGetPhysicalDeviceFeatures2(physicalDeviceRet.value().physical_device,
+                                 &supported);
+
+    _gpuDrivenFeatures._multiDrawIndirect =
+        supported.features.multiDrawIndirect == VK_TRUE;
+    _gpuDrivenFeatures._drawIndirectFirstInstance =
+        supported.features.drawIndirectFirstInstance == VK_TRUE;
+    _gpuDrivenFeatures._drawIndirectCount =
+        supported12.drawIndirectCount == VK_TRUE;
+
+    VkPhysicalDeviceFeatures features = {};
+    features.multiDrawIndirect = supported.features.multiDrawIndirect;
+    features.drawIndirectFirstInstance =
+        supported.features.drawIndirectFirstInstance;
+    features12.drawIndirectCount = supported12.drawIndirectCount;
+    selector.set_required_features(features).set_required_features_12(
+        features12);
+
+    // puts the GPU timestamps of the profiler on the CPU timeline
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(
+        physicalDeviceRet.value().physical_device, nullptr, &extensionCount,
+        nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(
+        physicalDeviceRet.value().physical_device, nullptr, &extensionCount,
+        extensions.data());
+    bool calibratedTimestamps = false;
+    for (const VkExtensionProperties &extension : extensions) {
+      if (std::strcmp(extension.extensionName,
+                      VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0) {
+        calibratedTimestamps = true;
+        selector.add_required_extension(
+            VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+      }
+    }
+
+    physicalDeviceRet = selector.select();
+    if (!physicalDeviceRet) {
+      spdlog::default_logger()->error("Failed to select a GPU: {}",
+                                      physicalDeviceRet.error().message());
+      abort();
+    }
+    vkb::PhysicalDevice physicalDevice = physicalDeviceRet.value();
 
     // create the final Vulkan device
     vkb::DeviceBuilder deviceBuilder{physicalDevice};
@@ -336,23 +982,100 @@ namespace AltE {
     _device = vkbDevice.device;
     _chosenGPU = physicalDevice.physical_device;
 
+    // the allocator is created right after, it is only needed to destroy
+    // buffers and images
+    _mainDeletionQueue.init(_device, &_allocator);
+
     // use vkboostrap to get a Graphics Queue
     _graphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
     _graphicsQueueFamily =
         vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
 
-    spdlog::default_logger()->debug("Vulkan initialized");
+    // uploads go through a dedicated transfer queue when the GPU has one, so
+    // they run alongside rendering. Otherwise they share the graphics queue
+    auto transferQueue =
+        vkbDevice.get_dedicated_queue(vkb::QueueType::transfer);
+    if (transferQueue) {
+      _transferQueue = transferQueue.value();
+      _transferQueueFamily =
+          vkbDevice.get_dedicated_queue_index(vkb::QueueType::transfer).value();
+    } else {
+      _transferQueue = _graphicsQueue;
+      _transferQueueFamily = _graphicsQueueFamily;
+    }
+
+    // timestamps are only usable if the graphics queue has valid bits for them
+    float timestampPeriod = 0.f;
+    if (vkbDevice.queue_families[_graphicsQueueFamily].timestampValidBits >
+        0) {
+      timestampPeriod = physicalDevice.properties.limits.timestampPeriod;
+    } else {
+      spdlog::default_logger()->warn(
+          "Graphics queue doesn't support timestamps, GPU timings disabled");
+    }
+
+    // the debug labels need the debug utils of the messenger
+    _gpuProfiler.init(_instance, _chosenGPU, _device, timestampPeriod,
+                      calibratedTimestamps,
+                      _debug_messenger != VK_NULL_HANDLE, FRAME_OVERLAP);
+    _mainDeletionQueue.push_cleanup<&GpuProfiler::cleanup>(&_gpuProfiler);
+
+    // load the pipelines compiled by the previous runs, they are saved back
+    // when the engine shuts down
+    _pipelineCache.init(_device, _chosenGPU);
+    _mainDeletionQueue.push_cleanup<&PipelineCache::cleanup>(&_pipelineCache);
+
+    _pipelineCompiler.init(_device, _pipelineCache.get(), _jobs);
+
+    // the assets are found next to the executable, whatever the working
+    // directory is. The archive is only there once the Assets target ran,
+    // until then the loose files are used
+    std::filesystem::path archivePath = asset_directory() / "assets.pak";
+    if (!_assets.open(archivePath)) {
+      spdlog::default_logger()->info(
+          "No asset archive at {}, loading loose files",
+          archivePath.string());
+    }
+    _mainDeletionQueue.push_cleanup<&AssetManager::close>(&_assets);
+
+    _shaderLibrary.init(_device, asset_directory() / "shaders", &_assets);
+    _mainDeletionQueue.push_cleanup<&ShaderLibrary::cleanup>(&_shaderLibrary);
+
+    SPDLOG_DEBUG("Vulkan initialized on {}",
+                 physicalDevice.properties.deviceName);
   }
 
   void App::init_swapchain() {
+    // on high DPI screens the window size is in points, the swapchain needs
+    // pixels
+    int width, height;
+    SDL_Vulkan_GetDrawableSize(_window, &width, &height);
+    _windowExtent = {(uint32_t)width, (uint32_t)height};
+
+    create_swapchain(VK_NULL_HANDLE);
+
+    SPDLOG_DEBUG("Swapchain initialized ({}x{}, {})", _windowExtent.width,
+                 _windowExtent.height, present_mode_name(_presentMode));
+  }
+
+  void App::create_swapchain(VkSwapchainKHR oldSwapchain) {
+    _presentMode = select_present_mode();
+    if (_presentMode != _config.presentMode) {
+      spdlog::default_logger()->info(
+          "Present mode {} isn't supported, using {}",
+          present_mode_name(_config.presentMode),
+          present_mode_name(_presentMode));
+    }
+
     vkb::SwapchainBuilder swapchainBuilder{_chosenGPU, _device, _surface};
 
     vkb::Swapchain vkbSwapchain =
         swapchainBuilder
             .use_default_format_selection()
-            // use vsync present mode
-            .set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)
+            .set_desired_present_mode(to_vulkan(_presentMode))
             .set_desired_extent(_windowExtent.width, _windowExtent.height)
+            // lets the driver reuse the resources of the old swapchain
+            .set_old_swapchain(oldSwapchain)
             .build()
             .value();
 
@@ -361,195 +1084,336 @@ namespace AltE {
     _swapchainImages = vkbSwapchain.get_images().value();
     _swapchainImageViews = vkbSwapchain.get_image_views().value();
 
+    // the render pass is created for this format, it doesn't change when
+    // the swapchain is recreated on the same surface
     _swapchainImageFormat = vkbSwapchain.image_format;
 
-    _mainDeletionQueue.push_function(
-        [this]() { vkDestroySwapchainKHR(_device, _swapchain, nullptr); });
+    // the surface has the final say on the size
+    _windowExtent = vkbSwapchain.extent;
+  }
+
+  PresentMode App::select_present_mode() const {
+    uint32_t count = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(_chosenGPU, _surface, &count,
+                                              nullptr);
+    std::vector<VkPresentModeKHR> supported(count);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(_chosenGPU, _surface, &count,
+                                              supported.data());
+
+    // the requested mode first, then the closest fallbacks, down to FIFO
+    // which every surface supports
+    std::vector<PresentMode> candidates;
+    switch (_config.presentMode) {
+      case PresentMode::Immediate:
+        candidates = {PresentMode::Immediate, PresentMode::Mailbox,
+                      PresentMode::FifoRelaxed};
+        break;
+      case PresentMode::Mailbox:
+        candidates = {PresentMode::Mailbox};
+        break;
+      case PresentMode::FifoRelaxed:
+        candidates = {PresentMode::FifoRelaxed};
+        break;
+      case PresentMode::Fifo:
+        break;
+    }
+
+    for (PresentMode candidate : candidates) {
+      if (std::find(supported.begin(), supported.end(),
+                    to_vulkan(candidate)) != supported.end()) {
+        return candidate;
+      }
+    }
+    return PresentMode::Fifo;
+  }
+
+  int App::display_refresh_rate() const {
+    SDL_DisplayMode mode;
+    if (SDL_GetWindowDisplayMode(_window, &mode) != 0) {
+      return 0;
+    }
+    return mode.refresh_rate;
+  }
+
+  void App::set_present_mode(PresentMode mode) {
+    _config.presentMode = mode;
+    _swapchainDirty = true;
+  }
+
+  void App::set_low_latency(bool enabled) {
+    _config.lowLatency = enabled;
+    _framePacer.set_enabled(enabled);
+    SPDLOG_DEBUG("Low latency frame pacing {}",
+                 enabled ? "enabled" : "disabled");
+  }
 
-    spdlog::default_logger()->debug("Swapchain initialized");
+  void App::recreate_swapchain() {
+    int width, height;
+    SDL_Vulkan_GetDrawableSize(_window, &width, &height);
+    if (width == 0 || height == 0) {
+      // minimized, keep the old swapchain until the window comes back
+      return;
+    }
+    _swapchainDirty = false;
+
+    // the frames in flight still render to the old images and present them,
+    // so everything is retired with the current frame instead of waiting for
+    // the device to go idle
+    _renderGraph.retire_resources(_mainDeletionQueue, _frameNumber);
+    for (VkImageView view : _swapchainImageViews) {
+      _mainDeletionQueue.retire(_frameNumber, DeletionType::ImageView, view);
+    }
+
+    VkSwapchainKHR oldSwapchain = _swapchain;
+    _windowExtent = {(uint32_t)width, (uint32_t)height};
+    create_swapchain(oldSwapchain);
+    _mainDeletionQueue.retire(_frameNumber, DeletionType::Swapchain,
+                              oldSwapchain);
+
+    create_graph_resources();
+
+    // the window may have moved to another display
+    _framePacer.init(display_refresh_rate());
+
+    SPDLOG_DEBUG("Swapchain recreated ({}x{}, {})", _windowExtent.width,
+                 _windowExtent.height, present_mode_name(_presentMode));
+  }
+
+  void App::destroy_swapchain() {
+    for (VkImageView view : _swapchainImageViews) {
+      vkDestroyImageView(_device, view, nullptr);
+    }
+    _swapchainImageViews.clear();
+    _swapchainImages.clear();
+
+    // in headless mode the images belong to _offscreenImages
+    if (_swapchain != VK_NULL_HANDLE) {
+      vkDestroySwapchainKHR(_device, _swapchain, nullptr);
+      _swapchain = VK_NULL_HANDLE;
+    }
+  }
+
+  void App::init_allocator() {
+    _allocator.init(_instance, _chosenGPU, _device, VK_API_VERSION_1_2);
+
+    _mainDeletionQueue.push_cleanup<&GpuAllocator::cleanup>(&_allocator);
+
+    // per-frame constants and dynamic geometry are written here instead of
+    // allocating or mapping memory for every draw. The atlas stages its
+    // updates here too
+    _frameAllocator.init(_allocator, _chosenGPU, FRAME_ALLOCATOR_SIZE,
+                         FRAME_OVERLAP,
+                         VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                             VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+    _mainDeletionQueue.push_cleanup<&LinearAllocator::cleanup>(
+        &_frameAllocator);
+  }
+
+  void App::init_uploads() {
+    // the queue lock is only needed when uploads share the graphics queue
+    bool sharedQueue = _transferQueue == _graphicsQueue;
+    _uploadQueue.init(_device, _allocator, _transferQueue,
+                      _transferQueueFamily, _graphicsQueueFamily,
+                      sharedQueue ? &_graphicsQueueMutex : nullptr,
+                      UPLOAD_STAGING_SIZE);
+
+    _mainDeletionQueue.push_cleanup<&UploadQueue::cleanup>(&_uploadQueue);
+
+    SPDLOG_DEBUG("Uploads use {} queue",
+                 sharedQueue ? "the graphics" : "a dedicated transfer");
+  }
+
+  void App::init_offscreen_targets() {
+    // a format every driver supports as a color attachment
+    _swapchainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.pNext = nullptr;
+
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = _swapchainImageFormat;
+    imageInfo.extent = {_windowExtent.width, _windowExtent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // the images can be copied out to check what has been rendered
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    // one image per frame in flight, so a frame never overwrites an image
+    // still being rendered by the previous one
+    _offscreenImages.resize(FRAME_OVERLAP);
+    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+      AllocatedImage &target = _offscreenImages[i];
+      target = _allocator.create_image(imageInfo);
+
+      VkImageViewCreateInfo viewInfo = {};
+      viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      viewInfo.pNext = nullptr;
+
+      viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+      viewInfo.image = target._image;
+      viewInfo.format = _swapchainImageFormat;
+      viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      viewInfo.subresourceRange.baseMipLevel = 0;
+      viewInfo.subresourceRange.levelCount = 1;
+      viewInfo.subresourceRange.baseArrayLayer = 0;
+      viewInfo.subresourceRange.layerCount = 1;
+
+      VkImageView view;
+      VK_CHECK(vkCreateImageView(_device, &viewInfo, nullptr, &view));
+
+      // the image views are destroyed along with the swapchain ones
+      _swapchainImages.push_back(target._image);
+      _swapchainImageViews.push_back(view);
+
+      _mainDeletionQueue.push(DeletionType::Image, target._image,
+                              target._allocation);
+    }
+
+    SPDLOG_DEBUG("Offscreen targets initialized");
   }
 
   void App::init_commands() {
     // create a command pool for commands submitted to the graphics queue.
-    // we also want the pool to allow for resetting of individual command
-    // buffers
+    // every frame in flight gets its own pool, so it can be reset as a whole
+    // once the fence of that frame has been signaled
     VkCommandPoolCreateInfo commandPoolInfo =
-        vk_abstract::command_pool_create_info(
-            _graphicsQueueFamily,
-            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-
-    VK_CHECK(
-        vkCreateCommandPool(_device, &commandPoolInfo, nullptr, &_commandPool));
-
-    // allocate the default command buffer that we will use for rendering
-    VkCommandBufferAllocateInfo cmdAllocInfo =
-        vk_abstract::command_buffer_allocate_info(_commandPool, 1);
-
-    VK_CHECK(
-        vkAllocateCommandBuffers(_device, &cmdAllocInfo, &_mainCommandBuffer));
-
-    _mainDeletionQueue.push_function(
-        [this]() { vkDestroyCommandPool(_device, _commandPool, nullptr); });
-  }
-
-  void App::init_default_renderpass() {
-    // the renderpass will use this color attachement
-    VkAttachmentDescription color_attachment = {};
-    // the attachment will have the format needed by the swapchain
-    color_attachment.format = _swapchainImageFormat;
-    // 1 sample, we won't be doing MSAA
-    color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    // we clear when this attacment is loaded
-    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    // we keep the attachment sotre when the renderpass ends
-    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    // we don't care about stencil
-    color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-
-    // we don't know or care about the starting layout of the attachment
-    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-    // after the renderpass ends, the image has to be on a layout ready for
-    // display
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference color_attachment_ref = {};
-    // attachment number will index into the pAttachments array in the parent
-    // renderpass itself
-    color_attachment_ref.attachment = 0;
-    color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    // we are going to create 1 subpass, which is the minimum you can do
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &color_attachment_ref;
-
-    VkRenderPassCreateInfo render_pass_info = {};
-    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-
-    // connect the color attachment to the info
-    render_pass_info.attachmentCount = 1;
-    render_pass_info.pAttachments = &color_attachment;
-    // connect the subpass to the info
-    render_pass_info.subpassCount = 1;
-    render_pass_info.pSubpasses = &subpass;
-
-    VK_CHECK(
-        vkCreateRenderPass(_device, &render_pass_info, nullptr, &_renderPass));
-
-    _mainDeletionQueue.push_function(
-        [this]() { vkDestroyRenderPass(_device, _renderPass, nullptr); });
-
-    spdlog::default_logger()->debug("Renderpass initialized");
-  }
-
-  void App::init_framebuffers() {
-    // create the framebuffers for the swapchain images. This will connect the
-    // render-pass to the images for rendering.
-    VkFramebufferCreateInfo fb_info = {};
-    fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    fb_info.pNext = nullptr;
-
-    fb_info.renderPass = _renderPass;
-    fb_info.attachmentCount = 1;
-    fb_info.width = _windowExtent.width;
-    fb_info.height = _windowExtent.height;
-    fb_info.layers = 1;
-
-    // grab how many images we have in the swapchain
-    const uint32_t swapchain_imagecount = _swapchainImageViews.size();
-    _framebuffers = std::vector<VkFramebuffer>(swapchain_imagecount);
-
-    // create framebuffers for each of the swapchain image views
-    for (int i = 0; i < swapchain_imagecount; i++) {
-      fb_info.pAttachments = &_swapchainImageViews[i];
-      VK_CHECK(
-          vkCreateFramebuffer(_device, &fb_info, nullptr, &_framebuffers[i]));
+        vk_abstract::command_pool_create_info(_graphicsQueueFamily);
 
-      _mainDeletionQueue.push_function([this, i]() {
-        vkDestroyFramebuffer(_device, _framebuffers[i], nullptr);
-        vkDestroyImageView(_device, _swapchainImageViews[i], nullptr);
-      });
+    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+      VK_CHECK(vkCreateCommandPool(_device, &commandPoolInfo, nullptr,
+                                   &_frames[i]._commandPool));
+
+      // allocate the default command buffer that we will use for rendering
+      VkCommandBufferAllocateInfo cmdAllocInfo =
+          vk_abstract::command_buffer_allocate_info(_frames[i]._commandPool,
+                                                    1);
+
+      VK_CHECK(vkAllocateCommandBuffers(_device, &cmdAllocInfo,
+                                        &_frames[i]._mainCommandBuffer));
+
+      _mainDeletionQueue.push(DeletionType::CommandPool,
+                              _frames[i]._commandPool);
     }
 
-    spdlog::default_logger()->debug("Framebuffers initialized");
+    // secondary command buffers recorded by the workers
+    _recorder.init(_device, _graphicsQueueFamily, _jobs, FRAME_OVERLAP);
+    _mainDeletionQueue.push_cleanup<&ParallelRecorder::cleanup>(&_recorder);
+  }
+
+  void App::init_render_graph() {
+    _renderGraph.init(_device, _allocator);
+
+    // after the graph, the image has to be on a layout ready for display, or
+    // ready to be copied out when rendering offscreen
+    _colorTarget = _renderGraph.import_image(
+        "swapchain", _swapchainImageFormat,
+        _config.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                         : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+    // the triangles, drawn over the clear color
+    _mainPass = _renderGraph.add_pass(
+        "main", [this](VkCommandBuffer cmd, const RenderPassContext &context) {
+          record_main_pass(cmd, context);
+        });
+    _renderGraph.write_color(_mainPass, _colorTarget, true);
+
+    _renderGraph.compile();
+
+    // the render passes are kept when the swapchain is recreated, so the
+    // pipelines stay compatible with them
+    _renderPass = _renderGraph.render_pass(_mainPass);
+
+    create_graph_resources();
+
+    // the swapchain and its views are replaced when the window is resized,
+    // destroy whichever are current at shutdown, after the framebuffers
+    _mainDeletionQueue.push_cleanup<&App::destroy_swapchain>(this);
+    _mainDeletionQueue.push_cleanup<&RenderGraph::cleanup>(&_renderGraph);
+
+    SPDLOG_DEBUG("Render graph initialized");
+  }
+
+  void App::create_graph_resources() {
+    _renderGraph.set_imported(_colorTarget, _swapchainImages,
+                              _swapchainImageViews);
+    _renderGraph.create_resources(_windowExtent);
   }
 
   void App::init_sync_structures() {
     // create synchronization structures
+    // the fences start signaled so the first wait of each frame returns
+    // immediately
     VkFenceCreateInfo fenceCreateInfo =
         vk_abstract::fence_create_info(VK_FENCE_CREATE_SIGNALED_BIT);
 
-    VK_CHECK(vkCreateFence(_device, &fenceCreateInfo, nullptr, &_renderFence));
-
-    // enqueue the destruction of the fence
-    _mainDeletionQueue.push_function(
-        [this]() { vkDestroyFence(_device, _renderFence, nullptr); });
-
-    // for the semapgores, we don't need any flags
+    // for the semaphores, we don't need any flags
     VkSemaphoreCreateInfo semaphoreCreateInfo =
         vk_abstract::semaphore_create_info();
 
-    VK_CHECK(vkCreateSemaphore(_device, &semaphoreCreateInfo, nullptr,
-                               &_presentSemaphore));
-    VK_CHECK(vkCreateSemaphore(_device, &semaphoreCreateInfo, nullptr,
-                               &_renderSemaphore));
-
-    // enqueue the destruction of semaphores
-    _mainDeletionQueue.push_function([this]() {
-      vkDestroySemaphore(_device, _presentSemaphore, nullptr);
-      vkDestroySemaphore(_device, _renderSemaphore, nullptr);
-    });
+    for (unsigned int i = 0; i < FRAME_OVERLAP; i++) {
+      VK_CHECK(vkCreateFence(_device, &fenceCreateInfo, nullptr,
+                             &_frames[i]._renderFence));
+
+      VK_CHECK(vkCreateSemaphore(_device, &semaphoreCreateInfo, nullptr,
+                                 &_frames[i]._presentSemaphore));
+      VK_CHECK(vkCreateSemaphore(_device, &semaphoreCreateInfo, nullptr,
+                                 &_frames[i]._renderSemaphore));
+
+      // enqueue the destruction of the fence and semaphores
+      _mainDeletionQueue.push(DeletionType::Fence, _frames[i]._renderFence);
+      _mainDeletionQueue.push(DeletionType::Semaphore,
+                              _frames[i]._presentSemaphore);
+      _mainDeletionQueue.push(DeletionType::Semaphore,
+                              _frames[i]._renderSemaphore);
+    }
 
-    spdlog::default_logger()->debug("Sync structures initialized");
+    SPDLOG_DEBUG("Sync structures initialized ({} frames in flight)",
+                 FRAME_OVERLAP);
   }
 
   void App::init_pipeline() {
-
-    VkShaderModule triangleFragShader;
-    if (!shader_utils::load_shader_module(
-            _device, "../assets/shaders/colored_triangle.frag.spv",
-            &triangleFragShader)) {
+    // the modules stay in the library, pipelines sharing a shader share its
+    // module and the pipelines can be rebuilt without reloading anything
+    VkShaderModule triangleFragShader =
+        _shaderLibrary.get("colored_triangle.frag");
+    VkShaderModule triangleVertexShader =
+        _shaderLibrary.get("colored_triangle.vert");
+    VkShaderModule redTriangleVertexShader =
+        _shaderLibrary.get("triangle.vert");
+    VkShaderModule redTriangleFragShader = _shaderLibrary.get("triangle.frag");
+    VkShaderModule meshVertexShader = _shaderLibrary.get("mesh.vert");
+    VkShaderModule meshFragShader = _shaderLibrary.get("mesh.frag");
+    VkShaderModule spriteVertexShader = _shaderLibrary.get("sprite.vert");
+    VkShaderModule spriteFragShader = _shaderLibrary.get("sprite.frag");
+    VkShaderModule sceneVertexShader = _shaderLibrary.get("scene.vert");
+
+    if (triangleFragShader == VK_NULL_HANDLE ||
+        triangleVertexShader == VK_NULL_HANDLE ||
+        redTriangleVertexShader == VK_NULL_HANDLE ||
+        redTriangleFragShader == VK_NULL_HANDLE) {
       spdlog::default_logger()->error(
-          "Error when building the triangle fragment shader module");
-    } else {
-      spdlog::default_logger()->debug(
-          "Triangle fragment shader module successfully loaded");
+          "Error when loading the triangle shaders");
     }
-
-    VkShaderModule triangleVertexShader;
-    if (!shader_utils::load_shader_module(
-            _device, "../assets/shaders/colored_triangle.vert.spv",
-            &triangleVertexShader)) {
-      spdlog::default_logger()->error(
-          "Error when building the triangle vertex shader module");
-    } else {
-      spdlog::default_logger()->debug(
-          "Triangle vertex shader module successfully loaded");
+    if (meshVertexShader == VK_NULL_HANDLE ||
+        meshFragShader == VK_NULL_HANDLE) {
+      spdlog::default_logger()->error("Error when loading the mesh shaders");
     }
-
-    VkShaderModule redTriangleVertexShader;
-    if (!shader_utils::load_shader_module(_device,
-                                          "../assets/shaders/triangle.vert.spv",
-                                          &redTriangleVertexShader)) {
+    if (spriteVertexShader == VK_NULL_HANDLE ||
+        spriteFragShader == VK_NULL_HANDLE) {
       spdlog::default_logger()->error(
-          "Error when building the red triangle vertex shader module");
-    } else {
-      spdlog::default_logger()->debug(
-          "Red triangle vertex shader module successfully loaded");
+          "Error when loading the sprite shaders");
     }
-
-    VkShaderModule redTriangleFragShader;
-    if (!shader_utils::load_shader_module(_device,
-                                          "../assets/shaders/triangle.frag.spv",
-                                          &redTriangleFragShader)) {
-      spdlog::default_logger()->error(
-          "Error when building the red triangle fragment shader module");
-    } else {
-      spdlog::default_logger()->debug(
-          "Red triangle fragment shader module successfully loaded");
+    if (sceneVertexShader == VK_NULL_HANDLE) {
+      spdlog::default_logger()->error("Error when loading the scene shaders");
     }
 
     // build the pipeline layout that controls the inputs/outputs of the shader
@@ -573,27 +1437,14 @@ namespace AltE {
         vk_abstract::pipeline_shader_stage_create_info(
             VK_SHADER_STAGE_FRAGMENT_BIT, triangleFragShader));
 
-    // vertex input controls how to read vertices from vertex buffers. We aren't
-    // using it yet
-    pipelineBuilder._vertexInputInfo =
-        vk_abstract::vertex_input_state_create_info();
+    // the triangles are generated from gl_VertexIndex, they leave the vertex
+    // input empty
 
     // input assembly is the configuration for drawing triangle lists, strips,
     // or individual points. we are just going to draw triangle list
     pipelineBuilder._inputAssembly = vk_abstract::input_assembly_create_info(
         VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
 
-    // build viewport and scissor from the swapchain extends
-    pipelineBuilder._viewport.x = 0.f;
-    pipelineBuilder._viewport.y = 0.f;
-    pipelineBuilder._viewport.width = (float)_windowExtent.width;
-    pipelineBuilder._viewport.height = (float)_windowExtent.height;
-    pipelineBuilder._viewport.minDepth = 0.f;
-    pipelineBuilder._viewport.maxDepth = 1.f;
-
-    pipelineBuilder._scissor.offset = {0, 0};
-    pipelineBuilder._scissor.extent = _windowExtent;
-
     // configure the rastzerizer to draw filled triangles
     pipelineBuilder._rasterizer =
         vk_abstract::rasterization_state_create_info(VK_POLYGON_MODE_FILL);
@@ -609,8 +1460,10 @@ namespace AltE {
     // use the triangle layout we created
     pipelineBuilder._pipelineLayout = _trianglePipelineLayout;
 
-    // finally build the pipeline
-    _trianglePipeline = pipelineBuilder.build_pipeline(_device, _renderPass);
+    // take a snapshot of the triangle pipeline, the builder can then be
+    // reused for the next one
+    std::vector<PipelineDescription> descriptions;
+    descriptions.push_back(pipelineBuilder.describe(_renderPass));
 
     // clear the shader stages for the builder
     pipelineBuilder._shaderStages.clear();
@@ -624,22 +1477,208 @@ namespace AltE {
         vk_abstract::pipeline_shader_stage_create_info(
             VK_SHADER_STAGE_FRAGMENT_BIT, redTriangleFragShader));
 
-    // build the red triangle pipeline
-    _redTrianglePipeline = pipelineBuilder.build_pipeline(_device, _renderPass);
+    descriptions.push_back(pipelineBuilder.describe(_renderPass));
+
+    // the meshes push their matrices, and read the packed vertices of the
+    // mesh arena
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(MeshPushConstants);
+
+    VkPipelineLayoutCreateInfo mesh_layout_info =
+        vk_abstract::pipeline_layout_create_info();
+    mesh_layout_info.pushConstantRangeCount = 1;
+    mesh_layout_info.pPushConstantRanges = &pushConstantRange;
+
+    VK_CHECK(vkCreatePipelineLayout(_device, &mesh_layout_info, nullptr,
+                                    &_meshPipelineLayout));
+
+    pipelineBuilder._shaderStages.clear();
+    pipelineBuilder._shaderStages.push_back(
+        vk_abstract::pipeline_shader_stage_create_info(
+            VK_SHADER_STAGE_VERTEX_BIT, meshVertexShader));
+    pipelineBuilder._shaderStages.push_back(
+        vk_abstract::pipeline_shader_stage_create_info(
+            VK_SHADER_STAGE_FRAGMENT_BIT, meshFragShader));
+    pipelineBuilder._vertexInput = packed_vertex_description();
+    pipelineBuilder._pipelineLayout = _meshPipelineLayout;
+
+    descriptions.push_back(pipelineBuilder.describe(_renderPass));
 
-    // destroy all shader modules, outside of the queue
-    vkDestroyShaderModule(_device, redTriangleVertexShader, nullptr);
-    vkDestroyShaderModule(_device, redTriangleFragShader, nullptr);
-    vkDestroyShaderModule(_device, triangleFragShader, nullptr);
-    vkDestroyShaderModule(_device, triangleVertexShader, nullptr);
+    // the scene reads the same vertices, its transforms come from the
+    // objects of the scene instead of push constants
+    pipelineBuilder._shaderStages[0] =
+        vk_abstract::pipeline_shader_stage_create_info(
+            VK_SHADER_STAGE_VERTEX_BIT, sceneVertexShader);
+    pipelineBuilder._pipelineLayout = _scene.pipeline_layout();
+
+    descriptions.push_back(pipelineBuilder.describe(_renderPass));
+
+    // the sprites read their instances and blend over what is behind them
+    pipelineBuilder._shaderStages.clear();
+    pipelineBuilder._shaderStages.push_back(
+        vk_abstract::pipeline_shader_stage_create_info(
+            VK_SHADER_STAGE_VERTEX_BIT, spriteVertexShader));
+    pipelineBuilder._shaderStages.push_back(
+        vk_abstract::pipeline_shader_stage_create_info(
+            VK_SHADER_STAGE_FRAGMENT_BIT, spriteFragShader));
+    pipelineBuilder._vertexInput = SpriteBatcher::instance_description();
+    pipelineBuilder._colorBlendAttachment =
+        vk_abstract::alpha_blend_attachment_state();
+    pipelineBuilder._pipelineLayout = _spriteBatcher.pipeline_layout();
+
+    descriptions.push_back(pipelineBuilder.describe(_renderPass));
+
+    // the pipelines are rebuilt when one of their shaders is edited
+    _reloadablePipelines.resize(5);
+    _reloadablePipelines[0]._pipeline = &_trianglePipeline;
+    _reloadablePipelines[0]._description = descriptions[0];
+    _reloadablePipelines[0]._shaderNames = {"colored_triangle.vert",
+                                            "colored_triangle.frag"};
+    _reloadablePipelines[1]._pipeline = &_redTrianglePipeline;
+    _reloadablePipelines[1]._description = descriptions[1];
+    _reloadablePipelines[1]._shaderNames = {"triangle.vert", "triangle.frag"};
+    _reloadablePipelines[2]._pipeline = &_meshPipeline;
+    _reloadablePipelines[2]._description = descriptions[2];
+    _reloadablePipelines[2]._shaderNames = {"mesh.vert", "mesh.frag"};
+    _reloadablePipelines[3]._pipeline = &_scenePipeline;
+    _reloadablePipelines[3]._description = descriptions[3];
+    _reloadablePipelines[3]._shaderNames = {"scene.vert", "mesh.frag"};
+    _reloadablePipelines[4]._pipeline = &_spritePipeline;
+    _reloadablePipelines[4]._description = descriptions[4];
+    _reloadablePipelines[4]._shaderNames = {"sprite.vert", "sprite.frag"};
+
+    // compile the pipelines on the worker threads and wait for them
+    std::vector<std::future<VkPipeline>> pipelines =
+        _pipelineCompiler.compile_batch(std::move(descriptions));
+    _trianglePipeline = pipelines[0].get();
+    _redTrianglePipeline = pipelines[1].get();
+    _meshPipeline = pipelines[2].get();
+    _scenePipeline = pipelines[3].get();
+    _spritePipeline = pipelines[4].get();
+
+    // the cull shader isn't hot reloaded, it only feeds the scene
+    _scene.create_cull_pipeline(_shaderLibrary.get("cull.comp"),
+                                _pipelineCache.get());
+
+    // the pipelines themselves can be replaced by hot reloading, the current
+    // ones are destroyed by cleanup()
+    _mainDeletionQueue.push(DeletionType::PipelineLayout,
+                            _trianglePipelineLayout);
+    _mainDeletionQueue.push(DeletionType::PipelineLayout,
+                            _meshPipelineLayout);
+  }
 
-    _mainDeletionQueue.push_function([this]() {
-      // destroy the 2 pipelines we have created
-      vkDestroyPipeline(_device, _redTrianglePipeline, nullptr);
-      vkDestroyPipeline(_device, _trianglePipeline, nullptr);
+  void App::init_meshes() {
+    _meshArena.init(_allocator, _uploadQueue, MESH_ARENA_VERTICES,
+                    MESH_ARENA_INDEX_SIZE);
+    _mainDeletionQueue.push_cleanup<&MeshArena::cleanup>(&_meshArena);
+
+    _planeMesh = load_mesh("plane");
+
+    _scene.init(_device, _allocator, _uploadQueue, _meshArena,
+                _gpuDrivenFeatures, std::max(_config.sceneObjectCount, 1u),
+                VK_INDEX_TYPE_UINT16);
+    _mainDeletionQueue.push_cleanup<&GpuScene::cleanup>(&_scene);
+
+    // a field of planes under the one in the middle, most of it outside of
+    // the view
+    uint32_t side = (uint32_t)std::ceil(std::sqrt(_config.sceneObjectCount));
+    for (uint32_t i = 0; i < _config.sceneObjectCount; i++) {
+      float x = ((float)(i % side) - side / 2.f) * 2.5f;
+      float z = -(float)(i / side) * 2.5f;
+      glm::mat4 model =
+          glm::translate(glm::mat4(1.f), glm::vec3(x, -1.f, z));
+      model = glm::rotate(model, i * 0.3f, glm::vec3(0.f, 1.f, 0.f));
+      _scene.add_object(_planeMesh, model);
+    }
+    uint64_t sceneUpload = _scene.upload();
+
+    // the first frame culls the objects and draws the mesh, both copies
+    // must be done by then. The timeline only grows, the newest value
+    // covers the other
+    _uploadQueue.wait(std::max(_planeMesh._uploadValue, sceneUpload));
+  }
+
+  std::span<const std::byte> App::read_asset(const std::string &name,
+                                             MappedFile &file) {
+    if (_assets.is_open()) {
+      std::span<const std::byte> data = _assets.get(name);
+      if (!data.empty()) {
+        return data;
+      }
+    }
+
+    std::filesystem::path path = asset_directory() / name;
+    if (!file.open(path)) {
+      spdlog::default_logger()->error("Can't open asset {}", path.string());
+      return {};
+    }
+    return file.data();
+  }
 
-      // destroy the pipeline layout that they use
-      vkDestroyPipelineLayout(_device, _trianglePipelineLayout, nullptr);
-    });
+  GpuMesh App::load_mesh(const std::string &name) {
+    MappedFile file;
+    std::span<const std::byte> data =
+        read_asset("meshes/" + name + ".mesh", file);
+    if (data.empty()) {
+      return {};
+    }
+
+    GpuMesh mesh = _meshArena.load(data);
+    if (mesh.valid()) {
+      SPDLOG_DEBUG("Mesh {} loaded ({} vertices, {} indices)", name,
+                   mesh._vertexCount, mesh._indexCount);
+    }
+    return mesh;
+  }
+
+  void App::init_bindless() {
+    _bindless.init(_device);
+    _mainDeletionQueue.push_cleanup<&BindlessHeap::cleanup>(&_bindless);
+  }
+
+  void App::init_sprites() {
+    _atlas.init(_device, _allocator, _uploadQueue, _bindless,
+                _frameAllocator);
+    _mainDeletionQueue.push_cleanup<&TextureAtlas::cleanup>(&_atlas);
+
+    _spriteBatcher.init(_atlas, _bindless, _frameAllocator);
+
+    AtlasRegion ball = load_sprite_image("textures/ball.png");
+    if (ball.valid()) {
+      _spriteImages.push_back(ball);
+    }
+
+    // a few images made here, so the atlas has more than one to pack
+    for (uint32_t size : {24u, 40u, 16u}) {
+      std::vector<uint8_t> pixels((size_t)size * size * 4);
+      for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+          // a white frame around a translucent colored square
+          bool border = x < 2 || y < 2 || x >= size - 2 || y >= size - 2;
+          uint8_t *pixel = &pixels[((size_t)y * size + x) * 4];
+          pixel[0] = border ? 255 : (uint8_t)(x * 255 / size);
+          pixel[1] = border ? 255 : (uint8_t)(y * 255 / size);
+          pixel[2] = border ? 255 : (uint8_t)(size * 4);
+          pixel[3] = border ? 255 : 160;
+        }
+      }
+      _spriteImages.push_back(_atlas.add(pixels.data(), size, size));
+    }
+
+    // the first frame draws the sprites, the pages must be filled by then
+    _uploadQueue.wait(_atlas.upload());
+  }
+
+  AtlasRegion App::load_sprite_image(const std::string &name) {
+    MappedFile file;
+    std::span<const std::byte> data = read_asset(name, file);
+    Image image;
+    if (data.empty() || !decode_image(data, image)) {
+      return {};
+    }
+    return _atlas.add(image._pixels.data(), image._width, image._height);
   }
 } // namespace AltE
\ No newline at end of file
@@ -1,16 +1,151 @@
 #pragma once
 
+#include "../assets/AssetManager.hpp"
+#include "../core/JobSystem.hpp"
+#include "../core/MappedFile.hpp"
+#include "../core/Profiler.hpp"
+#include "../rendering/BindlessHeap.hpp"
 #include "../rendering/DeletionQueue.hpp"
+#include "../rendering/DrawList.hpp"
+#include "../rendering/FramePacer.hpp"
+#include "../rendering/GpuAllocator.hpp"
+#include "../rendering/GpuProfiler.hpp"
+#include "../rendering/GpuScene.hpp"
+#include "../rendering/LinearAllocator.hpp"
+#include "../rendering/MeshArena.hpp"
+#include "../rendering/ParallelRecorder.hpp"
+#include "../rendering/PipelineCache.hpp"
+#include "../rendering/PipelineCompiler.hpp"
+#include "../rendering/RenderGraph.hpp"
+#include "../rendering/ShaderLibrary.hpp"
+#include "../rendering/ShaderWatcher.hpp"
+#include "../rendering/SpriteBatcher.hpp"
+#include "../rendering/TextureAtlas.hpp"
+#include "../rendering/UploadQueue.hpp"
 #include "../rendering/vk_abstract.hpp"
+#include "../rendering/vk_types.hpp"
+#include "../simulation/Simulation.hpp"
+#include "InputQueue.hpp"
+#include "LoopScheduler.hpp"
 #include <SDL2/SDL.h>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <mutex>
 #include <spdlog/spdlog.h>
+#include <string>
+#include <vector>
 #include <vulkan/vulkan.h>
 
+#ifndef ALTE_FRAME_OVERLAP
+#define ALTE_FRAME_OVERLAP 2
+#endif
+
 namespace AltE {
+  // number of frames the CPU is allowed to record ahead of the GPU
+  constexpr unsigned int FRAME_OVERLAP = ALTE_FRAME_OVERLAP;
+  static_assert(FRAME_OVERLAP > 0, "at least one frame must be in flight");
+
+  // bytes of per-frame uniform and dynamic vertex data
+  constexpr VkDeviceSize FRAME_ALLOCATOR_SIZE = 4 * 1024 * 1024;
+  // bytes of data that can be waiting to be uploaded at the same time
+  constexpr VkDeviceSize UPLOAD_STAGING_SIZE = 64 * 1024 * 1024;
+  // vertices and bytes of indices of every mesh loaded at the same time
+  constexpr uint32_t MESH_ARENA_VERTICES = 1024 * 1024;
+  constexpr VkDeviceSize MESH_ARENA_INDEX_SIZE = 16 * 1024 * 1024;
+
+  // how the frames are handed to the display
+  enum class PresentMode {
+    // vsync, supported everywhere
+    Fifo,
+    // vsync, but a late frame is shown right away and may tear
+    FifoRelaxed,
+    // vsync without blocking, a new frame replaces the one waiting
+    Mailbox,
+    // no vsync, tears
+    Immediate,
+  };
+
+  // how the engine should be started
+  struct AppConfig {
+      // render into offscreen images instead of a window swapchain. No window
+      // is created and no display is needed, so this also runs on software
+      // drivers like lavapipe
+      bool headless = false;
+      // enable the validation layers when they are available
+      bool validation = true;
+      // keep the timings of every frame so they can be read back with
+      // App::take_frame_timings()
+      bool collectTimings = false;
+      // recompile the shaders when their sources are saved and rebuild the
+      // pipelines using them. Only when a window is opened
+      bool hotReloadShaders = true;
+      // size of the window or of the offscreen images
+      VkExtent2D extent{1280, 720};
+      // preferred present mode, the closest one the surface supports is used
+      PresentMode presentMode = PresentMode::Fifo;
+      // start each frame as late as possible, see FramePacer
+      bool lowLatency = false;
+      // frames per second of the window, 0 to leave the pacing to the
+      // present mode. The loop sleeps between the frames, see LoopScheduler
+      uint32_t targetFrameRate = 0;
+      // frames per second while the window doesn't have the focus, 0 for
+      // targetFrameRate. A minimized window draws nothing
+      uint32_t backgroundFrameRate = 10;
+      // ticks per second of the simulation, whatever the frame rate
+      uint32_t simulationRate = 60;
+      // triangles drawn every frame, more than one to stress the recording
+      uint32_t drawCount = 1;
+      // sprites drawn every frame over the rest, batched by SpriteBatcher
+      uint32_t spriteCount = 64;
+      // objects of the GPU driven scene, culled and drawn without the CPU
+      uint32_t sceneObjectCount = 1024;
+      // the CPU and GPU zones are recorded and written there as a Chrome
+      // trace when the engine shuts down. Empty to not profile
+      std::string traceFile;
+      // format and write the logs on a background thread, the thread
+      // logging only queues them
+      bool asyncLogging = true;
+      // the logs are also written there, buffered. Empty for the console only
+      std::string logFile;
+  };
+
+  // timings of a single frame, in milliseconds
+  struct FrameTimings {
+      uint64_t frameNumber = 0;
+      // time spent recording the command buffer
+      double cpuRecordMs = 0.0;
+      // time spent in vkQueueSubmit (and vkQueuePresentKHR when presenting)
+      double submitMs = 0.0;
+      // time between the timestamps written at the start and the end of the
+      // command buffer, negative when timestamps are not supported
+      double gpuMs = -1.0;
+  };
+
+  // everything a single frame in flight needs to be recorded and submitted
+  // without waiting on the other frames
+  struct FrameData {
+      // the command pool for the commands of this frame
+      VkCommandPool _commandPool;
+      // the buffer we will record into
+      VkCommandBuffer _mainCommandBuffer;
+
+      // signaled when the swapchain image can be rendered to, and when the
+      // rendering is done and the image can be presented
+      VkSemaphore _presentSemaphore, _renderSemaphore;
+      // signaled when the GPU is done with the commands of this frame
+      VkFence _renderFence;
+
+      // timings of the last frame submitted with this slot, waiting for its
+      // GPU time
+      FrameTimings _pendingTimings;
+      bool _hasPendingTimings = false;
+  };
+
   class App {
     public:
       // Initialize everything in the engine
-      void init();
+      void init(const AppConfig &config = {});
 
       // Shuts down the engine
       void cleanup();
@@ -21,28 +156,73 @@ namespace AltE {
       // Run main loop
       void run();
 
+      // Returns the timings of the frames completed since the last call. The
+      // frames still in flight are waited on so their GPU time is known.
+      // Only filled when AppConfig::collectTimings is set
+      std::vector<FrameTimings> take_frame_timings();
+
+      // scheduler shared by rendering, asset loading and simulation
+      JobSystem &jobs() { return _jobs; }
+
+      // the swapchain is recreated with the new mode before the next frame
+      void set_present_mode(PresentMode mode);
+      void set_low_latency(bool enabled);
+
     private:
       bool _isInitialized = false;
+      AppConfig _config;
       int _frameNumber = 0;
       int _selectedShader = 0;
 
       DeletionQueue _mainDeletionQueue;
 
+      // workers shared by the background tasks of the engine
+      JobSystem _jobs;
+      // the logic, ticked on a thread of its own and sampled by draw()
+      Simulation _simulation;
+
       VkExtent2D _windowExtent{1280, 720};
       struct SDL_Window *_window = nullptr;
       VkInstance _instance;
       VkDebugUtilsMessengerEXT _debug_messenger;
       VkPhysicalDevice _chosenGPU;
       VkDevice _device;
-      VkSurfaceKHR _surface;
+      VkSurfaceKHR _surface = VK_NULL_HANDLE;
+
+      // every buffer and image goes through this allocator
+      GpuAllocator _allocator;
+      // per-frame ring for uniforms and dynamic vertex data
+      LinearAllocator _frameAllocator;
+
+      // on-disk cache shared by every pipeline we build
+      PipelineCache _pipelineCache;
+      // builds the pipelines on _jobs
+      PipelineCompiler _pipelineCompiler;
+      // assets/assets.pak, mapped for the whole run
+      AssetManager _assets;
+      // every shader module, created once
+      ShaderLibrary _shaderLibrary;
 
-      VkSwapchainKHR _swapchain;
+      VkSwapchainKHR _swapchain = VK_NULL_HANDLE;
+      // the window changed size or the swapchain stopped matching the
+      // surface, it is recreated before the next frame
+      bool _swapchainDirty = false;
+      // mode the swapchain actually uses
+      PresentMode _presentMode = PresentMode::Fifo;
+      FramePacer _framePacer;
+      // when the main loop draws, and the events it read meanwhile
+      LoopScheduler _loopScheduler;
+      InputQueue _input;
+      bool _quit = false;
+      bool _isFullScreen = false;
 
       // image format expected by the windowing system
       VkFormat _swapchainImageFormat;
 
       // array of images from the swapchain
       std::vector<VkImage> _swapchainImages;
+      // in headless mode, the offscreen images standing in for the swapchain
+      std::vector<AllocatedImage> _offscreenImages;
 
       // array of image-views from the swapchain
       std::vector<VkImageView> _swapchainImageViews;
@@ -51,21 +231,90 @@ namespace AltE {
       VkQueue _graphicsQueue;
       // family of that queue
       uint32_t _graphicsQueueFamily;
+      // guards _graphicsQueue, which the upload thread may also submit to
+      std::mutex _graphicsQueueMutex;
 
-      // the command pool for our commands
-      VkCommandPool _commandPool;
-      // the buffer we will record into
-      VkCommandBuffer _mainCommandBuffer;
+      // queue used for uploads, the graphics queue when there is no dedicated
+      // transfer queue
+      VkQueue _transferQueue;
+      uint32_t _transferQueueFamily;
+      UploadQueue _uploadQueue;
+      // vertex and index buffer of every mesh
+      MeshArena _meshArena;
+      GpuMesh _planeMesh;
+      // objects culled by a compute shader and drawn indirectly
+      GpuScene _scene;
+      // optional features of the device the scene can use
+      GpuDrivenFeatures _gpuDrivenFeatures;
+      // every texture and storage buffer, indexed by the shaders
+      BindlessHeap _bindless;
+      // images of the sprites, folded in a few textures
+      TextureAtlas _atlas;
+      SpriteBatcher _spriteBatcher;
+      std::vector<AtlasRegion> _spriteImages;
 
-      VkRenderPass _renderPass;
-      std::vector<VkFramebuffer> _framebuffers;
+      // timestamps and debug labels of the command buffers
+      GpuProfiler _gpuProfiler;
 
-      VkSemaphore _presentSemaphore, _renderSemaphore;
-      VkFence _renderFence;
+      std::vector<FrameTimings> _completedTimings;
+
+      // ring of frames in flight, indexed by _frameNumber % FRAME_OVERLAP
+      FrameData _frames[FRAME_OVERLAP];
+
+      // draws of the current frame
+      DrawList _drawList;
+      // records big draw lists on the workers
+      ParallelRecorder _recorder;
+
+      // passes of the frame, the swapchain image is its output
+      RenderGraph _renderGraph;
+      RenderImage _colorTarget;
+      RenderPassId _mainPass;
+      // render pass of the main pass, owned by the graph
+      VkRenderPass _renderPass;
 
       VkPipelineLayout _trianglePipelineLayout;
       VkPipeline _trianglePipeline;
       VkPipeline _redTrianglePipeline;
+      VkPipelineLayout _meshPipelineLayout;
+      VkPipeline _meshPipeline;
+      VkPipeline _spritePipeline;
+      VkPipeline _scenePipeline;
+
+      // a pipeline rebuilt when one of its shaders is recompiled
+      struct ReloadablePipeline {
+          // where the pipeline is used from
+          VkPipeline *_pipeline;
+          PipelineDescription _description;
+          // shader of each stage of the description
+          std::vector<std::string> _shaderNames;
+          // a shader changed since the last rebuild started
+          bool _dirty = false;
+          // rebuild running on the workers
+          std::future<VkPipeline> _rebuild;
+      };
+
+      ShaderWatcher _shaderWatcher;
+      std::vector<ReloadablePipeline> _reloadablePipelines;
+
+      // root of the assets, next to the directory of the executable
+      static std::filesystem::path asset_directory();
+
+      // getter for the frame we are rendering to right now
+      FrameData &get_current_frame();
+
+      // reads back the GPU time of the frame previously submitted with this
+      // slot, its fence must be signaled
+      void resolve_frame_timings(FrameData &frame);
+
+      // swaps in the pipelines rebuilt since the last frame. Called between
+      // two frames
+      void update_hot_reload();
+
+      // what the window lets the main loop do
+      LoopState loop_state() const;
+      // reacts to an event read by the main loop
+      void handle_event(const SDL_Event &event);
 
       void init_logger();
       static inline VKAPI_ATTR VkBool32 configure_logger(
@@ -74,11 +323,44 @@ namespace AltE {
           const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData,
           void *pUserData);
       void init_vulkan();
+      void init_allocator();
+      void init_uploads();
       void init_swapchain();
+      // builds the swapchain at _windowExtent, handing over the images of
+      // oldSwapchain when there is one
+      void create_swapchain(VkSwapchainKHR oldSwapchain);
+      // the requested present mode if the surface supports it, otherwise
+      // the closest supported one
+      PresentMode select_present_mode() const;
+      // refresh rate of the display showing the window, 0 when unknown
+      int display_refresh_rate() const;
+      // swaps in a swapchain matching the current size of the window. The
+      // previous one is retired, frames in flight can still present to it
+      void recreate_swapchain();
+      // destroys the current swapchain and its image views
+      void destroy_swapchain();
+      void init_offscreen_targets();
       void init_commands();
-      void init_default_renderpass();
-      void init_framebuffers();
+      void init_render_graph();
+      // hands the current swapchain images to the graph and creates its size
+      // dependent resources
+      void create_graph_resources();
+      // draws of the main pass, the graph begins and ends its render pass
+      void record_main_pass(VkCommandBuffer cmd,
+                            const RenderPassContext &context);
       void init_sync_structures();
       void init_pipeline();
+      void init_meshes();
+      void init_bindless();
+      void init_sprites();
+      // content of an asset, from the archive or else from the loose file,
+      // which is then mapped in file. Empty when it can't be found
+      std::span<const std::byte> read_asset(const std::string &name,
+                                            MappedFile &file);
+      // mesh written by the mesh-importer tool. Invalid when it can't be
+      // loaded
+      GpuMesh load_mesh(const std::string &name);
+      // decodes an image and adds it to the atlas
+      AtlasRegion load_sprite_image(const std::string &name);
   };
 } // namespace AltE
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "InputQueue.hpp"
+#include <algorithm>
+
+namespace AltE {
+  void InputQueue::pump() {
+    SDL_Event event;
+    while (SDL_PollEvent(&event) != 0) {
+      push(event);
+    }
+  }
+
+  void InputQueue::wait_until(Clock::time_point deadline) {
+    while (true) {
+      // SDL only waits in whole milliseconds
+      auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - Clock::now());
+      if (timeout.count() <= 0) {
+        return;
+      }
+
+      SDL_Event event;
+      if (SDL_WaitEventTimeout(&event, (int)timeout.count()) != 0) {
+        push(event);
+      }
+    }
+  }
+
+  void InputQueue::wait_for_event(Clock::time_point deadline) {
+    auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - Clock::now());
+    int timeoutMs = (int)std::max<int64_t>(timeout.count(), 0);
+
+    SDL_Event event;
+    if (SDL_WaitEventTimeout(&event, timeoutMs) != 0) {
+      push(event);
+    }
+  }
+
+  void InputQueue::take(std::vector<InputEvent> &events,
+                        Clock::time_point until) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // stamped in order, the ones to take are at the front
+    auto end = std::find_if(
+        _events.begin(), _events.end(),
+        [&](const InputEvent &event) { return event._time > until; });
+    events.insert(events.end(), _events.begin(), end);
+    _events.erase(_events.begin(), end);
+  }
+
+  void InputQueue::push(const SDL_Event &event) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _events.push_back({Clock::now(), event});
+  }
+} // namespace AltE
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace AltE {
+  // an SDL event and when the engine read it
+  struct InputEvent {
+      std::chrono::steady_clock::time_point _time;
+      SDL_Event _event;
+  };
+
+  // the SDL events, stamped when they are read instead of when a frame
+  // gets to them. The main thread reads them whenever it waits, so the
+  // input keeps its own timing whatever the frame rate. Any thread can
+  // take them, in the order they came
+  class InputQueue {
+    public:
+      using Clock = std::chrono::steady_clock;
+
+      // reads the events SDL has, without waiting. Main thread only
+      void pump();
+
+      // reads the events until deadline, sleeping in SDL between them.
+      // Returns early when deadline is less than a millisecond away. Main
+      // thread only
+      void wait_until(Clock::time_point deadline);
+
+      // waits until SDL has an event or until deadline, and reads that
+      // event. Main thread only
+      void wait_for_event(Clock::time_point deadline);
+
+      // appends the events read up to until to events, and removes them
+      void take(std::vector<InputEvent> &events,
+                Clock::time_point until = Clock::time_point::max());
+
+    private:
+      std::mutex _mutex;
+      std::vector<InputEvent> _events;
+
+      void push(const SDL_Event &event);
+  };
+} // namespace AltE
@@ -0,0 +1,43 @@
+#include "LoopScheduler.hpp"
+#include <thread>
+
+namespace AltE {
+  bool LoopScheduler::wait_for_frame(LoopState state, InputQueue &input) {
+    if (state == LoopState::Minimized) {
+      // back to the loop on the first event, a restore or a quit is
+      // handled right away
+      input.wait_for_event(Clock::now() + MINIMIZED_WAKEUP);
+      // pace from scratch once restored
+      _nextFrame = {};
+      return false;
+    }
+
+    uint32_t rate = _targetRate;
+    if (state == LoopState::Background && _backgroundRate != 0) {
+      rate = _backgroundRate;
+    }
+    if (rate == 0) {
+      _nextFrame = {};
+      return true;
+    }
+
+    auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / rate));
+    Clock::time_point now = Clock::now();
+    // the first frame, or more than a frame late: start from now instead of
+    // catching up with a burst of frames. Also when the focus comes back and
+    // the next background frame is further away than a frame
+    if (_nextFrame == Clock::time_point{} || now > _nextFrame + period ||
+        _nextFrame > now + period) {
+      _nextFrame = now;
+    }
+
+    // SDL wakes up for the events in whole milliseconds, the last one is a
+    // plain sleep. clock_nanosleep on Linux, which is accurate to a few
+    // tens of microseconds
+    input.wait_until(_nextFrame);
+    std::this_thread::sleep_until(_nextFrame);
+    _nextFrame += period;
+    return true;
+  }
+} // namespace AltE
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "InputQueue.hpp"
+#include <chrono>
+#include <cstdint>
+
+namespace AltE {
+  // what the window lets the main loop do
+  enum class LoopState {
+    // focused, frames at the target rate
+    Active,
+    // visible but unfocused, frames at the background rate
+    Background,
+    // nothing to draw, the loop only wakes up for the events
+    Minimized,
+  };
+
+  // decides when the main loop starts its next frame. Instead of spinning,
+  // the loop sleeps in SDL until the frame is due, so it still reads the
+  // events as they come, then sleeps the last millisecond with the high
+  // resolution clock of the OS. A minimized window draws nothing and
+  // blocks until the next event
+  class LoopScheduler {
+    public:
+      using Clock = std::chrono::steady_clock;
+
+      // frames per second, 0 to not limit them and let the present mode
+      // pace the loop
+      void set_target_rate(uint32_t rate) { _targetRate = rate; }
+      // frames per second without the focus, 0 for the target rate
+      void set_background_rate(uint32_t rate) { _backgroundRate = rate; }
+
+      // waits until the next frame is due, reading the events meanwhile.
+      // Returns false when no frame should be drawn, the loop should handle
+      // the events and come back
+      bool wait_for_frame(LoopState state, InputQueue &input);
+
+    private:
+      // the jobs queued for the main thread still run this often while
+      // minimized
+      static constexpr std::chrono::milliseconds MINIMIZED_WAKEUP{100};
+
+      uint32_t _targetRate = 0;
+      uint32_t _backgroundRate = 0;
+      // when the next frame is due, none while the loop isn't limited
+      Clock::time_point _nextFrame{};
+  };
+} // namespace AltE
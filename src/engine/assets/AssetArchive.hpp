@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// layout of the asset archive written by the asset-packer tool:
+//
+//   Header
+//   Entry[entryCount]     sorted by hash
+//   names                 entry names, not null terminated
+//   blobs                 each one aligned on BLOB_ALIGNMENT
+//
+// every integer is little endian
+namespace AltE::asset_archive {
+  constexpr uint32_t MAGIC = 0x4b504c41; // "ALPK"
+  constexpr uint32_t VERSION = 1;
+  // large enough for any SPIR-V word, vertex or texel read in place
+  constexpr uint64_t BLOB_ALIGNMENT = 64;
+
+  struct Header {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t entryCount;
+      uint32_t reserved;
+      uint64_t entriesOffset;
+      uint64_t namesOffset;
+  };
+
+  struct Entry {
+      uint64_t hash;
+      uint64_t offset;
+      uint64_t size;
+      uint32_t nameOffset;
+      uint32_t nameSize;
+  };
+
+  static_assert(sizeof(Header) == 32 && sizeof(Entry) == 32,
+                "the archive structures are written as is");
+
+  // FNV-1a of the asset name, e.g. "shaders/triangle.vert.spv"
+  constexpr uint64_t hash_name(std::string_view name) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : name) {
+      hash ^= (uint8_t)c;
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+} // namespace AltE::asset_archive
@@ -0,0 +1,95 @@
+#include "AssetManager.hpp"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  bool AssetManager::open(const std::filesystem::path &archivePath) {
+    close();
+
+    if (!_file.open(archivePath)) {
+      return false;
+    }
+
+    std::span<const std::byte> data = _file.data();
+    asset_archive::Header header;
+    if (data.size() < sizeof(header)) {
+      spdlog::default_logger()->error("Asset archive {} is truncated",
+                                      archivePath.string());
+      close();
+      return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    const uint64_t entriesSize =
+        (uint64_t)header.entryCount * sizeof(asset_archive::Entry);
+    if (header.magic != asset_archive::MAGIC ||
+        header.version != asset_archive::VERSION ||
+        header.entriesOffset % alignof(asset_archive::Entry) != 0 ||
+        header.entriesOffset > data.size() ||
+        entriesSize > data.size() - header.entriesOffset ||
+        header.namesOffset > data.size()) {
+      spdlog::default_logger()->error("Asset archive {} is invalid",
+                                      archivePath.string());
+      close();
+      return false;
+    }
+
+    _entries = {reinterpret_cast<const asset_archive::Entry *>(
+                    data.data() + header.entriesOffset),
+                header.entryCount};
+    _names = reinterpret_cast<const char *>(data.data() + header.namesOffset);
+
+    // check every entry once, so get() never has to
+    const uint64_t namesSize = data.size() - header.namesOffset;
+    for (size_t i = 0; i < _entries.size(); i++) {
+      const asset_archive::Entry &entry = _entries[i];
+      if (entry.offset > data.size() ||
+          entry.size > data.size() - entry.offset ||
+          (uint64_t)entry.nameOffset + entry.nameSize > namesSize ||
+          (i > 0 && _entries[i - 1].hash >= entry.hash)) {
+        spdlog::default_logger()->error("Asset archive {} is corrupted",
+                                        archivePath.string());
+        close();
+        return false;
+      }
+    }
+
+    SPDLOG_DEBUG("Asset archive {} opened ({} assets)", archivePath.string(),
+                 _entries.size());
+    return true;
+  }
+
+  void AssetManager::close() {
+    _file.close();
+    _entries = {};
+    _names = nullptr;
+  }
+
+  const asset_archive::Entry *
+  AssetManager::find(std::string_view name) const {
+    const uint64_t hash = asset_archive::hash_name(name);
+
+    auto entry = std::lower_bound(
+        _entries.begin(), _entries.end(), hash,
+        [](const asset_archive::Entry &e, uint64_t h) { return e.hash < h; });
+    if (entry == _entries.end() || entry->hash != hash) {
+      return nullptr;
+    }
+
+    // the packer refuses colliding names, but make sure we don't hand out the
+    // wrong asset for a name that isn't in the archive
+    if (std::string_view(_names + entry->nameOffset, entry->nameSize) != name) {
+      return nullptr;
+    }
+    return &*entry;
+  }
+
+  std::span<const std::byte> AssetManager::get(std::string_view name) const {
+    const asset_archive::Entry *entry = find(name);
+    if (entry == nullptr) {
+      return {};
+    }
+    return _file.data().subspan(entry->offset, entry->size);
+  }
+} // namespace AltE
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../core/MappedFile.hpp"
+#include "AssetArchive.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+namespace AltE {
+  // gives access to the assets packed in an archive. The archive is mapped in
+  // memory once, assets are handed out as views into the mapping without
+  // opening or copying anything
+  class AssetManager {
+    public:
+      // maps and validates the archive, returns false if it is missing or
+      // corrupted
+      bool open(const std::filesystem::path &archivePath);
+      void close();
+
+      bool is_open() const { return _file.is_open(); }
+
+      // content of the asset, empty if the archive doesn't have it. Valid
+      // until the manager is closed
+      std::span<const std::byte> get(std::string_view name) const;
+
+      bool contains(std::string_view name) const {
+        return find(name) != nullptr;
+      }
+
+    private:
+      MappedFile _file;
+      std::span<const asset_archive::Entry> _entries;
+      const char *_names = nullptr;
+
+      const asset_archive::Entry *find(std::string_view name) const;
+  };
+} // namespace AltE
@@ -0,0 +1,34 @@
+#include "ImageLoader.hpp"
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+// the implementation of stb_image lives in this translation unit only
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_TGA
+#define STBI_ONLY_BMP
+// the archive is already in memory, the stdio loaders are never used
+#define STBI_NO_STDIO
+#include <stb_image.h>
+
+namespace AltE {
+  bool decode_image(std::span<const std::byte> data, Image &image) {
+    int width, height, channels;
+    stbi_uc *pixels = stbi_load_from_memory(
+        reinterpret_cast<const stbi_uc *>(data.data()), (int)data.size(),
+        &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr) {
+      spdlog::default_logger()->error("Can't decode image: {}",
+                                      stbi_failure_reason());
+      return false;
+    }
+
+    image._width = (uint32_t)width;
+    image._height = (uint32_t)height;
+    image._pixels.resize((size_t)width * height * 4);
+    std::memcpy(image._pixels.data(), pixels, image._pixels.size());
+    stbi_image_free(pixels);
+    return true;
+  }
+} // namespace AltE
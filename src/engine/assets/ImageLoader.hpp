@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace AltE {
+  // decoded image, 4 bytes per pixel in RGBA order, rows top to bottom
+  struct Image {
+      uint32_t _width = 0;
+      uint32_t _height = 0;
+      std::vector<uint8_t> _pixels;
+  };
+
+  // decodes a PNG, JPEG, TGA or BMP file already in memory, like an entry
+  // of the asset archive. Returns false and logs the reason when it can't
+  bool decode_image(std::span<const std::byte> data, Image &image);
+} // namespace AltE
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// layout of the meshes written by the mesh-importer tool, ready to be copied
+// into the vertex and index buffers as is:
+//
+//   Header
+//   Vertex[vertexCount]
+//   indices               indexCount indices of indexSize bytes
+//
+// every integer is little endian
+namespace AltE::mesh_format {
+  constexpr uint32_t MAGIC = 0x534d4c41; // "ALMS"
+  constexpr uint32_t VERSION = 1;
+
+  struct Header {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t vertexCount;
+      uint32_t indexCount;
+      // 2 or 4 bytes
+      uint32_t indexSize;
+      uint32_t reserved;
+      // bounding sphere, in model space
+      float center[3];
+      float radius;
+  };
+
+  // 24 bytes per vertex, against 48 for three floats of position, normal and
+  // two of UV, plus a color
+  struct Vertex {
+      float position[3];
+      // octahedral encoding, R16G16_SNORM
+      int16_t normal[2];
+      // R16G16_SFLOAT
+      uint16_t uv[2];
+      // R8G8B8A8_UNORM
+      uint8_t color[4];
+  };
+
+  static_assert(sizeof(Header) == 40 && sizeof(Vertex) == 24,
+                "the mesh structures are written as is");
+
+  // the largest vertex count 16 bits indices can address
+  constexpr uint32_t MAX_16BIT_VERTICES = 65536;
+
+  // IEEE 754 binary16, rounded to nearest even. Out of range values become
+  // infinities
+  inline uint16_t float_to_half(float value) {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xffu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (((bits >> 23) & 0xffu) == 0xffu) {
+      // infinity or NaN
+      return (uint16_t)(sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u));
+    }
+    if (exponent >= 31) {
+      return (uint16_t)(sign | 0x7c00u);
+    }
+    if (exponent <= 0) {
+      if (exponent < -10) {
+        return (uint16_t)sign;
+      }
+      // subnormal, the implicit 1 becomes explicit
+      mantissa |= 0x800000u;
+      uint32_t shift = (uint32_t)(14 - exponent);
+      uint32_t half = mantissa >> shift;
+      uint32_t rest = mantissa & ((1u << shift) - 1);
+      uint32_t midpoint = 1u << (shift - 1);
+      if (rest > midpoint || (rest == midpoint && (half & 1u))) {
+        half++;
+      }
+      return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fffu;
+    // a carry into the exponent is still the right rounding
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+      half++;
+    }
+    return (uint16_t)half;
+  }
+
+  inline int16_t to_snorm16(float value) {
+    return (int16_t)std::lround(std::clamp(value, -1.f, 1.f) * 32767.f);
+  }
+
+  inline uint8_t to_unorm8(float value) {
+    return (uint8_t)std::lround(std::clamp(value, 0.f, 1.f) * 255.f);
+  }
+
+  // maps a unit vector onto the octahedron unfolded in [-1, 1]^2. Decoded by
+  // oct_decode() in mesh.vert
+  inline void encode_octahedral(const float normal[3], int16_t out[2]) {
+    float x = normal[0];
+    float y = normal[1];
+    float z = normal[2];
+    float l1 = std::abs(x) + std::abs(y) + std::abs(z);
+    if (l1 == 0.f) {
+      out[0] = 0;
+      out[1] = 0;
+      return;
+    }
+    x /= l1;
+    y /= l1;
+    z /= l1;
+
+    if (z < 0.f) {
+      // the lower half is folded over the diagonals
+      float foldedX = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+      float foldedY = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+      x = foldedX;
+      y = foldedY;
+    }
+    out[0] = to_snorm16(x);
+    out[1] = to_snorm16(y);
+  }
+} // namespace AltE::mesh_format
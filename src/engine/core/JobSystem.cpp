@@ -0,0 +1,162 @@
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+#include <string>
+
+namespace {
+  thread_local unsigned int currentWorker = 0;
+} // namespace
+
+namespace AltE {
+  void JobSystem::init(unsigned int workerCount) {
+    workerCount = std::max(workerCount, 1u);
+    _stopping = false;
+
+    for (unsigned int i = 0; i < workerCount; i++) {
+      _queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned int i = 0; i < workerCount; i++) {
+      _workers.emplace_back([this, i]() { worker_loop(i + 1); });
+    }
+  }
+
+  JobSystem::~JobSystem() { shutdown(); }
+
+  void JobSystem::shutdown() {
+    if (_workers.empty()) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_sleepMutex);
+      _stopping = true;
+    }
+    _wakeUp.notify_all();
+
+    for (std::thread &worker : _workers) {
+      worker.join();
+    }
+    _workers.clear();
+    _queues.clear();
+  }
+
+  unsigned int JobSystem::worker_index() { return currentWorker; }
+
+  void JobSystem::run(std::function<void()> job, JobCounter *counter) {
+    if (counter != nullptr) {
+      counter->_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+      // counted before it is visible, so the count never goes below the
+      // number of queued jobs. Under the lock, a worker can't miss the job
+      // between checking the count and going to sleep
+      std::lock_guard<std::mutex> lock(_sleepMutex);
+      _queuedJobs.fetch_add(1, std::memory_order_release);
+    }
+
+    // a worker keeps its jobs, they are likely to touch what it just
+    // touched. Other threads spread them between the workers
+    unsigned int queue = currentWorker;
+    if (queue == 0) {
+      queue = _nextQueue.fetch_add(1, std::memory_order_relaxed) %
+                  _queues.size() +
+              1;
+    }
+    {
+      WorkerQueue &target = *_queues[queue - 1];
+      std::lock_guard<std::mutex> lock(target._mutex);
+      target._jobs.push_back({std::move(job), counter});
+    }
+    _wakeUp.notify_one();
+  }
+
+  void JobSystem::wait(const JobCounter &counter) {
+    Job job;
+    while (!counter.done()) {
+      if (try_take(currentWorker, job)) {
+        execute(job);
+      } else {
+        // the last jobs are running on other threads
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void JobSystem::run_on_main(std::function<void()> job) {
+    std::lock_guard<std::mutex> lock(_mainMutex);
+    _mainJobs.push_back(std::move(job));
+  }
+
+  void JobSystem::run_main_jobs() {
+    std::vector<std::function<void()>> jobs;
+    {
+      std::lock_guard<std::mutex> lock(_mainMutex);
+      jobs.swap(_mainJobs);
+    }
+    for (std::function<void()> &job : jobs) {
+      job();
+    }
+  }
+
+  void JobSystem::worker_loop(unsigned int index) {
+    currentWorker = index;
+    Profiler::set_thread_name(("worker " + std::to_string(index)).c_str());
+
+    Job job;
+    while (true) {
+      if (try_take(index, job)) {
+        execute(job);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(_sleepMutex);
+      // keep going until every queue is empty, so no future is left broken
+      if (_stopping && _queuedJobs.load(std::memory_order_acquire) == 0) {
+        return;
+      }
+      _wakeUp.wait(lock, [this]() {
+        return _stopping || _queuedJobs.load(std::memory_order_acquire) > 0;
+      });
+    }
+  }
+
+  bool JobSystem::try_take(unsigned int index, Job &job) {
+    if (_queuedJobs.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+
+    if (index != 0) {
+      WorkerQueue &own = *_queues[index - 1];
+      std::lock_guard<std::mutex> lock(own._mutex);
+      if (!own._jobs.empty()) {
+        job = std::move(own._jobs.back());
+        own._jobs.pop_back();
+        _queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+
+    // start with the next worker, so thieves don't all hit the same queue
+    size_t queueCount = _queues.size();
+    for (size_t i = 0; i < queueCount; i++) {
+      WorkerQueue &victim = *_queues[(index + i) % queueCount];
+      std::lock_guard<std::mutex> lock(victim._mutex);
+      if (!victim._jobs.empty()) {
+        job = std::move(victim._jobs.front());
+        victim._jobs.pop_front();
+        _queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void JobSystem::execute(Job &job) {
+    job._function();
+    job._function = nullptr;
+
+    if (job._counter != nullptr) {
+      job._counter->_pending.fetch_sub(1, std::memory_order_release);
+    }
+  }
+} // namespace AltE
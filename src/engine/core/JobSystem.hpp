@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace AltE {
+  // counts the jobs of a group that are still queued or running
+  class JobCounter {
+    public:
+      bool done() const {
+        return _pending.load(std::memory_order_acquire) == 0;
+      }
+
+    private:
+      friend class JobSystem;
+      std::atomic<uint32_t> _pending{0};
+  };
+
+  // work stealing scheduler shared by the whole engine. Every worker owns a
+  // deque: it pushes and pops its own jobs at the back, and idle workers
+  // steal the oldest jobs at the front of the others. Waiting on a counter
+  // runs queued jobs instead of blocking, so jobs can wait on other jobs.
+  // Jobs that must run on the main thread (SDL calls) have their own queue,
+  // emptied by the main loop
+  class JobSystem {
+    public:
+      // starts the workers, at least one
+      void init(unsigned int workerCount);
+
+      // calls shutdown()
+      ~JobSystem();
+
+      // finishes the queued jobs and joins the workers. Does nothing once
+      // the workers are gone, it can be called again
+      void shutdown();
+
+      unsigned int worker_count() const { return _workers.size(); }
+
+      // 1 to worker_count() on the workers, 0 on any other thread
+      static unsigned int worker_index();
+
+      // queues a job. The counter, when given, counts it until it is done.
+      // The job must not throw, use submit() for jobs that can
+      void run(std::function<void()> job, JobCounter *counter = nullptr);
+
+      // queues a job, its result (or exception) is given back by the future
+      template <typename F>
+      auto submit(F &&job) -> std::future<std::invoke_result_t<F>> {
+        using Result = std::invoke_result_t<F>;
+
+        // std::function must be copyable, so the packaged task is shared
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<F>(job));
+        std::future<Result> future = task->get_future();
+        run([task]() { (*task)(); });
+        return future;
+      }
+
+      // runs queued jobs on this thread until every job of counter is done
+      void wait(const JobCounter &counter);
+
+      // calls body(begin, end) on ranges covering [0, count), of at least
+      // minBatch items, and returns once they are all done. The calling
+      // thread takes part
+      template <typename F>
+      void parallel_for(size_t count, size_t minBatch, F &&body) {
+        if (count == 0) {
+          return;
+        }
+
+        // a few batches per thread, so stealing can even out the load
+        size_t maxBatches = 4 * (worker_count() + 1);
+        size_t batches = std::clamp<size_t>(
+            (count + minBatch - 1) / std::max<size_t>(minBatch, 1), 1,
+            maxBatches);
+        size_t batchSize = (count + batches - 1) / batches;
+
+        JobCounter counter;
+        for (size_t begin = batchSize; begin < count; begin += batchSize) {
+          size_t end = std::min(begin + batchSize, count);
+          run([&body, begin, end]() { body(begin, end); }, &counter);
+        }
+        body(size_t(0), std::min(batchSize, count));
+
+        wait(counter);
+      }
+
+      // queues a job for the main thread
+      void run_on_main(std::function<void()> job);
+
+      // runs the main thread jobs queued so far, called by the main loop
+      void run_main_jobs();
+
+    private:
+      struct Job {
+          std::function<void()> _function;
+          JobCounter *_counter;
+      };
+
+      struct WorkerQueue {
+          std::mutex _mutex;
+          std::deque<Job> _jobs;
+      };
+
+      std::vector<std::thread> _workers;
+      // one per worker, indexed by worker_index() - 1
+      std::vector<std::unique_ptr<WorkerQueue>> _queues;
+      // queue receiving the next job pushed from outside the workers
+      std::atomic<unsigned int> _nextQueue{0};
+
+      // jobs in the queues, the workers sleep while it is 0
+      std::atomic<size_t> _queuedJobs{0};
+      std::mutex _sleepMutex;
+      std::condition_variable _wakeUp;
+      std::atomic<bool> _stopping{false};
+
+      std::mutex _mainMutex;
+      std::vector<std::function<void()>> _mainJobs;
+
+      void worker_loop(unsigned int index);
+      // own queue first, newest job first, then steals from the others
+      bool try_take(unsigned int index, Job &job);
+      void execute(Job &job);
+  };
+} // namespace AltE
@@ -0,0 +1,115 @@
+#include "MappedFile.hpp"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AltE {
+  MappedFile::~MappedFile() { close(); }
+
+  MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+  }
+
+  MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      close();
+      _data = std::exchange(other._data, nullptr);
+      _size = std::exchange(other._size, 0);
+#ifdef _WIN32
+      _mapping = std::exchange(other._mapping, nullptr);
+#endif
+    }
+    return *this;
+  }
+
+#ifdef _WIN32
+  bool MappedFile::open(const std::filesystem::path &path) {
+    close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+      CloseHandle(file);
+      return false;
+    }
+
+    // the mapping keeps the file alive, the handle can be closed right away
+    _mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (_mapping == nullptr) {
+      return false;
+    }
+
+    void *view = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+      CloseHandle(_mapping);
+      _mapping = nullptr;
+      return false;
+    }
+
+    _data = static_cast<const std::byte *>(view);
+    _size = (size_t)size.QuadPart;
+    return true;
+  }
+
+  void MappedFile::close() {
+    if (_data != nullptr) {
+      UnmapViewOfFile(_data);
+      CloseHandle(_mapping);
+    }
+    _data = nullptr;
+    _size = 0;
+    _mapping = nullptr;
+  }
+#else
+  bool MappedFile::open(const std::filesystem::path &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+      ::close(fd);
+      return false;
+    }
+
+    // the mapping keeps the file alive, the descriptor can be closed right
+    // away
+    void *view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+      return false;
+    }
+
+    _data = static_cast<const std::byte *>(view);
+    _size = (size_t)info.st_size;
+    return true;
+  }
+
+  void MappedFile::close() {
+    if (_data != nullptr) {
+      munmap(const_cast<std::byte *>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+  }
+#endif
+} // namespace AltE
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace AltE {
+  // read-only memory mapping of a whole file. The content is paged in by the
+  // OS on access, nothing is copied
+  class MappedFile {
+    public:
+      MappedFile() = default;
+      ~MappedFile();
+
+      MappedFile(MappedFile &&other) noexcept;
+      MappedFile &operator=(MappedFile &&other) noexcept;
+      MappedFile(const MappedFile &) = delete;
+      MappedFile &operator=(const MappedFile &) = delete;
+
+      // maps the file, returns false if it can't be opened or mapped
+      bool open(const std::filesystem::path &path);
+      void close();
+
+      bool is_open() const { return _data != nullptr; }
+
+      std::span<const std::byte> data() const { return {_data, _size}; }
+
+    private:
+      const std::byte *_data = nullptr;
+      size_t _size = 0;
+#ifdef _WIN32
+      void *_mapping = nullptr;
+#endif
+  };
+} // namespace AltE
@@ -0,0 +1,198 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+  // zones kept per thread, a power of two
+  constexpr uint64_t RING_SIZE = 16384;
+
+  struct Zone {
+      const char *_name;
+      uint64_t _start;
+      uint64_t _end;
+  };
+
+  // written by a single thread, read by write_chrome_trace()
+  struct ThreadRing {
+      // tid in the trace
+      uint32_t _id = 0;
+      // guarded by registryMutex
+      std::string _name;
+      std::unique_ptr<Zone[]> _zones = std::make_unique<Zone[]>(RING_SIZE);
+      // zones ever written, the last RING_SIZE are still there
+      std::atomic<uint64_t> _head = 0;
+      // the thread is gone, the ring goes once its zones are written out
+      std::atomic<bool> _exited = false;
+
+      void push(const char *name, uint64_t start, uint64_t end) {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        _zones[head & (RING_SIZE - 1)] = {name, start, end};
+        _head.store(head + 1, std::memory_order_release);
+      }
+  };
+
+  std::atomic<bool> enabledFlag = false;
+
+  std::mutex registryMutex;
+  // the rings outlive their threads, the zones of the workers that exited
+  // are still written out
+  std::vector<std::shared_ptr<ThreadRing>> registry;
+  // the GPU is a track of its own, tid 0
+  ThreadRing gpuRing;
+  uint32_t nextThreadId = 1;
+
+  // the ring is only allocated on the first zone recorded while enabled,
+  // the threads that never record one cost nothing
+  struct ThreadState {
+      std::string _name;
+      std::shared_ptr<ThreadRing> _ring;
+
+      ~ThreadState() {
+        if (_ring != nullptr) {
+          _ring->_exited.store(true, std::memory_order_release);
+        }
+      }
+  };
+
+  thread_local ThreadState currentThread;
+
+  ThreadRing &thread_ring() {
+    if (currentThread._ring == nullptr) {
+      std::lock_guard<std::mutex> lock(registryMutex);
+      auto ring = std::make_shared<ThreadRing>();
+      ring->_id = nextThreadId++;
+      ring->_name = currentThread._name.empty()
+                        ? "thread " + std::to_string(ring->_id)
+                        : currentThread._name;
+      registry.push_back(ring);
+      currentThread._ring = ring;
+    }
+    return *currentThread._ring;
+  }
+
+  void write_escaped(std::ostream &out, const std::string &text) {
+    for (char c : text) {
+      if (c == '"' || c == '\\') {
+        out << '\\' << c;
+      } else if ((unsigned char)c >= 0x20) {
+        out << c;
+      }
+    }
+  }
+
+  // complete events of the zones still in the ring, ts and dur in
+  // microseconds from origin
+  void write_zones(std::ostream &out, const ThreadRing &ring,
+                   uint64_t origin, bool &first) {
+    uint64_t head = ring._head.load(std::memory_order_acquire);
+    uint64_t count = std::min(head, RING_SIZE);
+    for (uint64_t i = head - count; i < head; i++) {
+      const Zone &zone = ring._zones[i & (RING_SIZE - 1)];
+      if (zone._start < origin || zone._end < zone._start) {
+        // overwritten while we were reading it
+        continue;
+      }
+      out << (first ? "\n" : ",\n") << "{\"name\":\"";
+      write_escaped(out, zone._name);
+      out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring._id
+          << ",\"ts\":" << (double)(zone._start - origin) / 1000.0
+          << ",\"dur\":" << (double)(zone._end - zone._start) / 1000.0
+          << "}";
+      first = false;
+    }
+  }
+
+  void write_thread_name(std::ostream &out, const ThreadRing &ring,
+                         bool &first) {
+    out << (first ? "\n" : ",\n")
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << ring._id << ",\"args\":{\"name\":\"";
+    write_escaped(out, ring._name);
+    out << "\"}}";
+    first = false;
+  }
+
+  // start of the oldest zone left, the trace starts there
+  uint64_t oldest_zone(const ThreadRing &ring) {
+    uint64_t head = ring._head.load(std::memory_order_acquire);
+    uint64_t count = std::min(head, RING_SIZE);
+    uint64_t oldest = UINT64_MAX;
+    for (uint64_t i = head - count; i < head; i++) {
+      oldest = std::min(oldest, ring._zones[i & (RING_SIZE - 1)]._start);
+    }
+    return oldest;
+  }
+} // namespace
+
+namespace AltE {
+  void Profiler::set_enabled(bool enabled) {
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool Profiler::enabled() {
+    return enabledFlag.load(std::memory_order_relaxed);
+  }
+
+  void Profiler::set_thread_name(const char *name) {
+    currentThread._name = name;
+    if (currentThread._ring != nullptr) {
+      std::lock_guard<std::mutex> lock(registryMutex);
+      currentThread._ring->_name = name;
+    }
+  }
+
+  void Profiler::record(const char *name, uint64_t start, uint64_t end) {
+    if (enabled()) {
+      thread_ring().push(name, start, end);
+    }
+  }
+
+  void Profiler::record_gpu(const char *name, uint64_t start, uint64_t end) {
+    if (enabled()) {
+      gpuRing.push(name, start, end);
+    }
+  }
+
+  bool Profiler::write_chrome_trace(const std::filesystem::path &path) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    gpuRing._name = "GPU";
+
+    uint64_t origin = oldest_zone(gpuRing);
+    for (const std::shared_ptr<ThreadRing> &ring : registry) {
+      origin = std::min(origin, oldest_zone(*ring));
+    }
+    if (origin == UINT64_MAX) {
+      origin = 0;
+    }
+
+    // nanosecond precision in microseconds
+    out << std::fixed << std::setprecision(3);
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    write_thread_name(out, gpuRing, first);
+    write_zones(out, gpuRing, origin, first);
+    for (const std::shared_ptr<ThreadRing> &ring : registry) {
+      write_thread_name(out, *ring, first);
+      write_zones(out, *ring, origin, first);
+    }
+    out << "\n]}\n";
+
+    // the zones of the threads that exited are written, nothing will be
+    // added to their rings
+    std::erase_if(registry, [](const std::shared_ptr<ThreadRing> &ring) {
+      return ring->_exited.load(std::memory_order_acquire);
+    });
+    return out.good();
+  }
+} // namespace AltE
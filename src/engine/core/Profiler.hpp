@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+namespace AltE {
+  // records timed zones of every thread, and of the GPU through
+  // GpuProfiler, and writes them as a Chrome trace that chrome://tracing
+  // and Perfetto load.
+  //
+  // Each thread writes its zones to its own ring buffer, so recording a
+  // zone takes no lock and never allocates: only the oldest zones are lost
+  // when a ring is full. A ring is allocated and registered on the first
+  // zone its thread records while enabled, and dropped once the thread has
+  // exited and its zones are written out. Recording is off until
+  // set_enabled(true), a zone then costs a relaxed atomic load.
+  //
+  // Zone names aren't copied, they must live until the trace is written
+  class Profiler {
+    public:
+      static void set_enabled(bool enabled);
+      static bool enabled();
+
+      // name of the calling thread in the trace, copied. Allocates nothing
+      // until the thread records a zone
+      static void set_thread_name(const char *name);
+
+      // nanoseconds on the steady clock, the timeline of every zone
+      static uint64_t now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+      }
+
+      // a zone of the calling thread
+      static void record(const char *name, uint64_t start, uint64_t end);
+      // a zone of the GPU, already on the CPU timeline. Only called from
+      // the render thread
+      static void record_gpu(const char *name, uint64_t start, uint64_t end);
+
+      // writes the zones still in the rings. The threads may keep
+      // recording, the zones written meanwhile may come out torn
+      static bool write_chrome_trace(const std::filesystem::path &path);
+  };
+
+  // times its own lifetime as a zone of the calling thread
+  class ProfileScope {
+    public:
+      explicit ProfileScope(const char *name)
+          : _name(name), _start(Profiler::enabled() ? Profiler::now() : 0) {}
+      ~ProfileScope() {
+        if (_start != 0) {
+          Profiler::record(_name, _start, Profiler::now());
+        }
+      }
+
+      ProfileScope(const ProfileScope &) = delete;
+      ProfileScope &operator=(const ProfileScope &) = delete;
+
+    private:
+      const char *_name;
+      uint64_t _start;
+  };
+} // namespace AltE
+
+#define ALTE_PROFILE_CONCAT_(a, b) a##b
+#define ALTE_PROFILE_CONCAT(a, b) ALTE_PROFILE_CONCAT_(a, b)
+
+// times the rest of the enclosing block, compiled out without
+// ALTE_PROFILING
+#if ALTE_PROFILING
+#define ALTE_PROFILE_SCOPE(name)                                               \
+  ::AltE::ProfileScope ALTE_PROFILE_CONCAT(profileScope, __LINE__) { name }
+#else
+#define ALTE_PROFILE_SCOPE(name)
+#endif
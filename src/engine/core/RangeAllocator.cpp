@@ -0,0 +1,58 @@
+#include "RangeAllocator.hpp"
+#include <iterator>
+
+namespace AltE {
+  void RangeAllocator::init(uint32_t capacity) {
+    _capacity = capacity;
+    _used = 0;
+    _free.clear();
+    if (capacity > 0) {
+      _free[0] = capacity;
+    }
+  }
+
+  uint32_t RangeAllocator::allocate(uint32_t count) {
+    if (count == 0) {
+      return INVALID;
+    }
+
+    for (auto it = _free.begin(); it != _free.end(); ++it) {
+      if (it->second < count) {
+        continue;
+      }
+
+      uint32_t offset = it->first;
+      uint32_t remaining = it->second - count;
+      _free.erase(it);
+      if (remaining > 0) {
+        _free[offset + count] = remaining;
+      }
+      _used += count;
+      return offset;
+    }
+    return INVALID;
+  }
+
+  void RangeAllocator::free(uint32_t offset, uint32_t count) {
+    if (count == 0) {
+      return;
+    }
+    _used -= count;
+
+    auto next = _free.lower_bound(offset);
+    if (next != _free.begin()) {
+      auto previous = std::prev(next);
+      if (previous->first + previous->second == offset) {
+        // grow the previous range instead of adding one
+        offset = previous->first;
+        count += previous->second;
+        _free.erase(previous);
+      }
+    }
+    if (next != _free.end() && offset + count == next->first) {
+      count += next->second;
+      _free.erase(next);
+    }
+    _free[offset] = count;
+  }
+} // namespace AltE
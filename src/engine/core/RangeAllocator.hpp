@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+namespace AltE {
+  // hands out ranges of [0, capacity) in abstract units, like vertices. First
+  // fit, the freed ranges are merged with their neighbours so the space
+  // doesn't end up in crumbs. Not thread safe
+  class RangeAllocator {
+    public:
+      static constexpr uint32_t INVALID = UINT32_MAX;
+
+      void init(uint32_t capacity);
+
+      // offset of count contiguous units, INVALID when no free range is
+      // large enough
+      uint32_t allocate(uint32_t count);
+      void free(uint32_t offset, uint32_t count);
+
+      uint32_t capacity() const { return _capacity; }
+      uint32_t used() const { return _used; }
+
+    private:
+      uint32_t _capacity = 0;
+      uint32_t _used = 0;
+      // free ranges, size by offset
+      std::map<uint32_t, uint32_t> _free;
+  };
+} // namespace AltE
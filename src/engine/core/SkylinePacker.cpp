@@ -0,0 +1,100 @@
+#include "SkylinePacker.hpp"
+#include <algorithm>
+
+namespace AltE {
+  void SkylinePacker::init(uint32_t width, uint32_t height) {
+    _width = width;
+    _height = height;
+    _usedArea = 0;
+    _skyline.clear();
+    _skyline.push_back({0, 0, width});
+  }
+
+  bool SkylinePacker::fit(size_t index, uint32_t width, uint32_t height,
+                          uint32_t &y) const {
+    uint32_t x = _skyline[index]._x;
+    if (x + width > _width) {
+      return false;
+    }
+
+    // the rectangle rests on the highest node under it
+    y = 0;
+    uint32_t remaining = width;
+    for (size_t i = index; remaining > 0; i++) {
+      y = std::max(y, _skyline[i]._y);
+      if (y + height > _height) {
+        return false;
+      }
+      remaining -= std::min(remaining, _skyline[i]._width);
+    }
+    return true;
+  }
+
+  bool SkylinePacker::pack(uint32_t width, uint32_t height, uint32_t &x,
+                           uint32_t &y) {
+    if (width == 0 || height == 0) {
+      return false;
+    }
+
+    // lowest top first, then the narrowest node to keep the wide ones
+    size_t best = _skyline.size();
+    uint32_t bestTop = UINT32_MAX;
+    uint32_t bestWidth = UINT32_MAX;
+    uint32_t bestY = 0;
+    for (size_t i = 0; i < _skyline.size(); i++) {
+      uint32_t nodeY;
+      if (!fit(i, width, height, nodeY)) {
+        continue;
+      }
+      uint32_t top = nodeY + height;
+      if (top < bestTop ||
+          (top == bestTop && _skyline[i]._width < bestWidth)) {
+        best = i;
+        bestTop = top;
+        bestWidth = _skyline[i]._width;
+        bestY = nodeY;
+      }
+    }
+    if (best == _skyline.size()) {
+      return false;
+    }
+
+    x = _skyline[best]._x;
+    y = bestY;
+
+    // the new node covers the nodes under the rectangle, the last one may
+    // only be cut
+    _skyline.insert(_skyline.begin() + best, {x, bestTop, width});
+    size_t i = best + 1;
+    while (i < _skyline.size() && _skyline[i]._x < x + width) {
+      uint32_t end = _skyline[i]._x + _skyline[i]._width;
+      if (end <= x + width) {
+        _skyline.erase(_skyline.begin() + i);
+        continue;
+      }
+      _skyline[i]._width = end - (x + width);
+      _skyline[i]._x = x + width;
+      break;
+    }
+
+    // neighbours at the same height become one node
+    for (size_t j = 0; j + 1 < _skyline.size();) {
+      if (_skyline[j]._y == _skyline[j + 1]._y) {
+        _skyline[j]._width += _skyline[j + 1]._width;
+        _skyline.erase(_skyline.begin() + j + 1);
+      } else {
+        j++;
+      }
+    }
+
+    _usedArea += (uint64_t)width * height;
+    return true;
+  }
+
+  float SkylinePacker::occupancy() const {
+    if (_width == 0 || _height == 0) {
+      return 0.f;
+    }
+    return (float)_usedArea / ((float)_width * (float)_height);
+  }
+} // namespace AltE
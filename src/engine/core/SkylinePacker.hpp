@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AltE {
+  // packs rectangles into a width x height area, keeping only the top edge
+  // of what has been placed (the skyline). Each rectangle goes where its
+  // top ends up the lowest, which keeps the area filled from the bottom
+  // and wastes little space with rectangles of similar heights. Rectangles
+  // can't be freed. Not thread safe
+  class SkylinePacker {
+    public:
+      void init(uint32_t width, uint32_t height);
+
+      // top left corner of a free width x height rectangle, false when it
+      // doesn't fit anywhere
+      bool pack(uint32_t width, uint32_t height, uint32_t &x, uint32_t &y);
+
+      // fraction of the area covered by rectangles
+      float occupancy() const;
+
+    private:
+      // a horizontal segment of the skyline
+      struct Node {
+          uint32_t _x;
+          uint32_t _y;
+          uint32_t _width;
+      };
+
+      uint32_t _width = 0;
+      uint32_t _height = 0;
+      uint64_t _usedArea = 0;
+      // left to right, they cover the whole width
+      std::vector<Node> _skyline;
+
+      // y where a rectangle starting at node index would rest, false when it
+      // goes past the edges
+      bool fit(size_t index, uint32_t width, uint32_t height,
+               uint32_t &y) const;
+  };
+} // namespace AltE
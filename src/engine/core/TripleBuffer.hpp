@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace AltE {
+  // hands the latest value written by one thread to another, without locks
+  // and without either of them ever waiting. The writer fills its own slot
+  // and publishes it by swapping it with the middle slot, the reader takes
+  // the middle slot when it has something new. Values published between
+  // two reads are skipped, the reader only sees the latest
+  template <typename T> class TripleBuffer {
+    public:
+      // the slot to fill before publish(), it holds an older value. Writer
+      // thread only
+      T &write_slot() { return _slots[_write]; }
+
+      // makes the write slot the latest value. Writer thread only
+      void publish() {
+        _write = _middle.exchange(_write | FRESH, std::memory_order_acq_rel) &
+                 INDEX;
+      }
+
+      // the latest value published, left alone by the writer until the
+      // next read. A default T before the first publish(). Reader thread
+      // only
+      const T &read() {
+        if (_middle.load(std::memory_order_relaxed) & FRESH) {
+          _read = _middle.exchange(_read, std::memory_order_acq_rel) & INDEX;
+        }
+        return _slots[_read];
+      }
+
+    private:
+      // the middle slot holds a value the reader hasn't taken yet
+      static constexpr uint8_t FRESH = 4;
+      static constexpr uint8_t INDEX = 3;
+
+      T _slots[3] = {};
+      uint8_t _write = 0;
+      uint8_t _read = 1;
+      std::atomic<uint8_t> _middle{2};
+  };
+} // namespace AltE
@@ -0,0 +1,98 @@
+#include "Archetype.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  Archetype::Archetype(const ComponentMask &mask) : _mask(mask) {
+    size_t rowSize = sizeof(Entity);
+    for (ComponentId id = 0; id < MAX_COMPONENTS; id++) {
+      if (mask.test(id)) {
+        _components.push_back(id);
+        const ComponentInfo &info = ComponentRegistry::info(id);
+        rowSize += info._size;
+
+        // the arrays are aligned from the start of the chunk
+        if (info._alignment > alignof(ChunkMemory)) {
+          spdlog::default_logger()->error(
+              "Component {} is aligned on {} bytes, chunks only on {}", id,
+              info._alignment, alignof(ChunkMemory));
+          abort();
+        }
+      }
+    }
+
+    // the alignment of the arrays may cost a few rows
+    _capacity = (uint32_t)(CHUNK_SIZE / rowSize);
+    while (_capacity > 0 && layout(_capacity) > CHUNK_SIZE) {
+      _capacity--;
+    }
+    if (_capacity == 0) {
+      spdlog::default_logger()->error(
+          "Entities of {} bytes don't fit in a {} bytes chunk", rowSize,
+          CHUNK_SIZE);
+      abort();
+    }
+    layout(_capacity);
+  }
+
+  size_t Archetype::entity_count() const {
+    if (_chunks.empty()) {
+      return 0;
+    }
+    return (_chunks.size() - 1) * _capacity + _chunks.back()._count;
+  }
+
+  void Archetype::push(Entity entity, uint32_t &chunk, uint32_t &row) {
+    if (_chunks.empty() || _chunks.back()._count == _capacity) {
+      // left uninitialized, every row is written before it is read
+      _chunks.push_back({std::unique_ptr<ChunkMemory>(new ChunkMemory), 0});
+    }
+
+    Chunk &last = _chunks.back();
+    chunk = (uint32_t)_chunks.size() - 1;
+    row = last._count++;
+
+    entities(last)[row] = entity;
+    for (ComponentId id : _components) {
+      const ComponentInfo &info = ComponentRegistry::info(id);
+      std::memcpy(array(last, id) + row * info._size, info._default.get(),
+                  info._size);
+    }
+  }
+
+  Entity Archetype::swap_remove(uint32_t chunk, uint32_t row) {
+    Chunk &last = _chunks.back();
+    uint32_t lastChunk = (uint32_t)_chunks.size() - 1;
+    uint32_t lastRow = last._count - 1;
+
+    Entity moved;
+    if (chunk != lastChunk || row != lastRow) {
+      Chunk &target = _chunks[chunk];
+      moved = entities(last)[lastRow];
+      entities(target)[row] = moved;
+      for (ComponentId id : _components) {
+        size_t size = ComponentRegistry::info(id)._size;
+        std::memcpy(array(target, id) + row * size,
+                    array(last, id) + lastRow * size, size);
+      }
+    }
+
+    last._count--;
+    if (last._count == 0) {
+      _chunks.pop_back();
+    }
+    return moved;
+  }
+
+  size_t Archetype::layout(uint32_t capacity) {
+    size_t offset = capacity * sizeof(Entity);
+    for (ComponentId id : _components) {
+      const ComponentInfo &info = ComponentRegistry::info(id);
+      offset = (offset + info._alignment - 1) & ~(info._alignment - 1);
+      _offsets[id] = (uint32_t)offset;
+      offset += capacity * info._size;
+    }
+    return offset;
+  }
+} // namespace AltE
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Component.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace AltE {
+  // a few whole pages, small enough for the arrays a query reads to stay
+  // in L1 or L2 while it goes through a chunk
+  constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+  struct alignas(64) ChunkMemory {
+      std::byte _bytes[CHUNK_SIZE];
+  };
+
+  // a block of entities of a single archetype: the array of their handles,
+  // then an array per component
+  struct Chunk {
+      std::unique_ptr<ChunkMemory> _memory;
+      uint32_t _count = 0;
+  };
+
+  // the entities having exactly the same component types. Each component
+  // is stored in an array of its own (SoA), so a query only reads the
+  // arrays it needs, contiguously. The chunks are kept full but the last
+  // one: a removed entity is replaced by the last one of the archetype
+  class Archetype {
+    public:
+      explicit Archetype(const ComponentMask &mask);
+
+      const ComponentMask &mask() const { return _mask; }
+      // entities per chunk
+      uint32_t chunk_capacity() const { return _capacity; }
+      size_t chunk_count() const { return _chunks.size(); }
+      Chunk &chunk(size_t index) { return _chunks[index]; }
+      size_t entity_count() const;
+
+      Entity *entities(Chunk &chunk) const {
+        return reinterpret_cast<Entity *>(chunk._memory->_bytes);
+      }
+      // the array of a component in chunk, it must be one of the archetype
+      std::byte *array(Chunk &chunk, ComponentId id) const {
+        return chunk._memory->_bytes + _offsets[id];
+      }
+      void *component(uint32_t chunk, uint32_t row, ComponentId id) {
+        return array(_chunks[chunk], id) +
+               row * ComponentRegistry::info(id)._size;
+      }
+
+      // appends entity with default components, where it lands is written
+      // to chunk and row
+      void push(Entity entity, uint32_t &chunk, uint32_t &row);
+      // removes a row, the last entity of the archetype moves there.
+      // Returns that entity, an invalid one when the row was the last
+      Entity swap_remove(uint32_t chunk, uint32_t row);
+
+    private:
+      ComponentMask _mask;
+      std::vector<ComponentId> _components;
+      uint32_t _capacity = 0;
+      // of the array of each component in a chunk
+      uint32_t _offsets[MAX_COMPONENTS] = {};
+      std::vector<Chunk> _chunks;
+
+      // bytes used by chunks of capacity entities, the offsets are set
+      size_t layout(uint32_t capacity);
+  };
+} // namespace AltE
@@ -0,0 +1,51 @@
+#include "CommandBuffer.hpp"
+#include <cstring>
+
+namespace AltE {
+  void CommandBuffer::apply(World &world) {
+    for (size_t i = 0; i < _commands.size(); i++) {
+      const Command &command = _commands[i];
+      switch (command._op) {
+        case Op::Create: {
+          // created in its final archetype, the components follow
+          uint32_t count = command._component;
+          ComponentMask mask;
+          for (uint32_t c = 1; c <= count; c++) {
+            mask.set(_commands[i + c]._component);
+          }
+          Entity entity = world.create(mask);
+          for (uint32_t c = 1; c <= count; c++) {
+            const Command &component = _commands[i + c];
+            std::memcpy(world.get(entity, component._component),
+                        &_data[component._data],
+                        ComponentRegistry::info(component._component)._size);
+          }
+          i += count;
+          break;
+        }
+        case Op::Destroy:
+          world.destroy(command._entity);
+          break;
+        case Op::Add:
+          world.add(command._entity, command._component,
+                    &_data[command._data]);
+          break;
+        case Op::Remove:
+          world.remove(command._entity, command._component);
+          break;
+      }
+    }
+
+    _commands.clear();
+    _data.clear();
+  }
+
+  void CommandBuffer::push(Op op, Entity entity, ComponentId id,
+                           const void *component) {
+    size_t size = ComponentRegistry::info(id)._size;
+    uint32_t offset = (uint32_t)_data.size();
+    _data.resize(_data.size() + size);
+    std::memcpy(&_data[offset], component, size);
+    _commands.push_back({op, id, entity, offset});
+  }
+} // namespace AltE
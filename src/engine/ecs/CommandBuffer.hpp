@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Component.hpp"
+#include "World.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AltE {
+  // structural changes recorded during a query and applied to the World
+  // once it is over. Not thread safe, a parallel query records into one
+  // buffer per thread, indexed by JobSystem::worker_index() for example.
+  // The components are copied when recorded
+  class CommandBuffer {
+    public:
+      // an entity with these components, created by apply()
+      template <typename... Ts> void create(const Ts &...components) {
+        _commands.push_back(
+            {Op::Create, (ComponentId)sizeof...(Ts), Entity{}, 0});
+        (push(Op::Add, Entity{}, component_id<Ts>(), &components), ...);
+      }
+
+      void destroy(Entity entity) {
+        _commands.push_back({Op::Destroy, 0, entity, 0});
+      }
+
+      template <typename T> void add(Entity entity, const T &component) {
+        push(Op::Add, entity, component_id<T>(), &component);
+      }
+
+      template <typename T> void remove(Entity entity) {
+        _commands.push_back({Op::Remove, component_id<T>(), entity, 0});
+      }
+
+      bool empty() const { return _commands.empty(); }
+
+      // runs the commands in the order they were recorded, and clears
+      // them. The ones on entities destroyed meanwhile do nothing
+      void apply(World &world);
+
+    private:
+      enum class Op : uint8_t { Create, Destroy, Add, Remove };
+
+      struct Command {
+          Op _op;
+          // the component count of a Create
+          ComponentId _component;
+          Entity _entity;
+          // of the component in _data
+          uint32_t _data;
+      };
+
+      std::vector<Command> _commands;
+      std::vector<std::byte> _data;
+
+      void push(Op op, Entity entity, ComponentId id, const void *component);
+  };
+} // namespace AltE
@@ -0,0 +1,38 @@
+#include "Component.hpp"
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <spdlog/spdlog.h>
+
+namespace {
+  std::mutex registryMutex;
+  // never moves, info() reads it without the lock. An id is only handed
+  // out once its entry is written
+  std::array<AltE::ComponentInfo, AltE::MAX_COMPONENTS> components;
+  AltE::ComponentId componentCount = 0;
+} // namespace
+
+namespace AltE {
+  ComponentId ComponentRegistry::add(size_t size, size_t alignment,
+                                     const void *defaultValue) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (componentCount == MAX_COMPONENTS) {
+      spdlog::default_logger()->error(
+          "More than {} component types, raise MAX_COMPONENTS",
+          MAX_COMPONENTS);
+      abort();
+    }
+
+    ComponentInfo &info = components[componentCount];
+    info._size = size;
+    info._alignment = alignment;
+    info._default = std::make_unique<std::byte[]>(size);
+    std::memcpy(info._default.get(), defaultValue, size);
+    return componentCount++;
+  }
+
+  const ComponentInfo &ComponentRegistry::info(ComponentId id) {
+    return components[id];
+  }
+} // namespace AltE
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace AltE {
+  // an index in the World and the generation of that index. A handle to a
+  // destroyed entity is recognized once its index is reused
+  struct Entity {
+      uint32_t _index = UINT32_MAX;
+      uint32_t _generation = 0;
+
+      bool valid() const { return _index != UINT32_MAX; }
+      bool operator==(const Entity &other) const = default;
+  };
+
+  using ComponentId = uint32_t;
+  constexpr uint32_t MAX_COMPONENTS = 64;
+  // the component types of an archetype
+  using ComponentMask = std::bitset<MAX_COMPONENTS>;
+
+  struct ComponentInfo {
+      size_t _size = 0;
+      size_t _alignment = 0;
+      // a default constructed component, copied into the new ones
+      std::unique_ptr<std::byte[]> _default;
+  };
+
+  // every component type, numbered in the order they are first used
+  class ComponentRegistry {
+    public:
+      static ComponentId add(size_t size, size_t alignment,
+                             const void *defaultValue);
+      static const ComponentInfo &info(ComponentId id);
+  };
+
+  // components are plain data, moved between the chunks with memcpy
+  template <typename T> ComponentId component_id() {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "components must be trivially copyable");
+    static const ComponentId id = []() {
+      T value{};
+      return ComponentRegistry::add(sizeof(T), alignof(T), &value);
+    }();
+    return id;
+  }
+
+  template <typename... Ts> ComponentMask component_mask() {
+    ComponentMask mask;
+    (mask.set(component_id<std::remove_const_t<Ts>>()), ...);
+    return mask;
+  }
+} // namespace AltE
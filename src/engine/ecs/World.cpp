@@ -0,0 +1,119 @@
+#include "World.hpp"
+
+namespace AltE {
+  Entity World::create(const ComponentMask &mask) {
+    Entity entity;
+    if (!_freeIndices.empty()) {
+      entity._index = _freeIndices.back();
+      _freeIndices.pop_back();
+    } else {
+      entity._index = (uint32_t)_records.size();
+      _records.emplace_back();
+    }
+
+    Record &record = _records[entity._index];
+    entity._generation = record._generation;
+    record._archetype = &archetype(mask);
+    record._archetype->push(entity, record._chunk, record._row);
+    _aliveCount++;
+    return entity;
+  }
+
+  void World::destroy(Entity entity) {
+    if (!alive(entity)) {
+      return;
+    }
+
+    Record &record = _records[entity._index];
+    Entity moved = record._archetype->swap_remove(record._chunk, record._row);
+    if (moved.valid()) {
+      _records[moved._index]._chunk = record._chunk;
+      _records[moved._index]._row = record._row;
+    }
+
+    // the handles still around now point to a destroyed entity
+    record._archetype = nullptr;
+    record._generation++;
+    _freeIndices.push_back(entity._index);
+    _aliveCount--;
+  }
+
+  bool World::alive(Entity entity) const {
+    return entity._index < _records.size() &&
+           _records[entity._index]._generation == entity._generation &&
+           _records[entity._index]._archetype != nullptr;
+  }
+
+  void World::add(Entity entity, ComponentId id, const void *component) {
+    if (!alive(entity)) {
+      return;
+    }
+
+    Record &record = _records[entity._index];
+    if (!record._archetype->mask().test(id)) {
+      ComponentMask mask = record._archetype->mask();
+      move(entity, archetype(mask.set(id)));
+    }
+    std::memcpy(record._archetype->component(record._chunk, record._row, id),
+                component, ComponentRegistry::info(id)._size);
+  }
+
+  void World::remove(Entity entity, ComponentId id) {
+    if (!alive(entity)) {
+      return;
+    }
+
+    Record &record = _records[entity._index];
+    if (record._archetype->mask().test(id)) {
+      ComponentMask mask = record._archetype->mask();
+      move(entity, archetype(mask.reset(id)));
+    }
+  }
+
+  void *World::get(Entity entity, ComponentId id) {
+    if (!alive(entity)) {
+      return nullptr;
+    }
+
+    Record &record = _records[entity._index];
+    if (!record._archetype->mask().test(id)) {
+      return nullptr;
+    }
+    return record._archetype->component(record._chunk, record._row, id);
+  }
+
+  Archetype &World::archetype(const ComponentMask &mask) {
+    std::unique_ptr<Archetype> &archetype = _archetypes[mask];
+    if (archetype == nullptr) {
+      archetype = std::make_unique<Archetype>(mask);
+      _archetypeList.push_back(archetype.get());
+    }
+    return *archetype;
+  }
+
+  void World::move(Entity entity, Archetype &target) {
+    Record &record = _records[entity._index];
+    Archetype &source = *record._archetype;
+
+    uint32_t chunk, row;
+    target.push(entity, chunk, row);
+    ComponentMask shared = source.mask() & target.mask();
+    for (ComponentId id = 0; id < MAX_COMPONENTS; id++) {
+      if (shared.test(id)) {
+        std::memcpy(target.component(chunk, row, id),
+                    source.component(record._chunk, record._row, id),
+                    ComponentRegistry::info(id)._size);
+      }
+    }
+
+    Entity moved = source.swap_remove(record._chunk, record._row);
+    if (moved.valid()) {
+      _records[moved._index]._chunk = record._chunk;
+      _records[moved._index]._row = record._row;
+    }
+
+    record._archetype = &target;
+    record._chunk = chunk;
+    record._row = row;
+  }
+} // namespace AltE
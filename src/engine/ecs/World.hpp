@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../core/JobSystem.hpp"
+#include "Archetype.hpp"
+#include "Component.hpp"
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace AltE {
+  // the entities and their components, grouped by archetype. Adding or
+  // removing a component moves the entity to another archetype.
+  //
+  // Queries go through the chunks of every archetype having the components
+  // asked for. Nothing may create, destroy, add or remove while a query
+  // runs, the changes are recorded in a CommandBuffer and applied after.
+  // Not thread safe, but a parallel query may read and write the
+  // components of its entities from every job
+  class World {
+    public:
+      // a new entity with default components
+      Entity create(const ComponentMask &mask);
+      template <typename... Ts> Entity create(const Ts &...components) {
+        Entity entity = create(component_mask<Ts...>());
+        (std::memcpy(get(entity, component_id<Ts>()), &components,
+                     sizeof(Ts)),
+         ...);
+        return entity;
+      }
+
+      // does nothing when the entity is already destroyed
+      void destroy(Entity entity);
+      bool alive(Entity entity) const;
+      // alive entities
+      size_t size() const { return _aliveCount; }
+
+      // replaces the component when the entity already has it
+      void add(Entity entity, ComponentId id, const void *component);
+      template <typename T> void add(Entity entity, const T &component) {
+        add(entity, component_id<T>(), &component);
+      }
+
+      void remove(Entity entity, ComponentId id);
+      template <typename T> void remove(Entity entity) {
+        remove(entity, component_id<T>());
+      }
+
+      // nullptr when the entity is destroyed or doesn't have the component.
+      // Valid until the next structural change
+      void *get(Entity entity, ComponentId id);
+      template <typename T> T *get(Entity entity) {
+        return static_cast<T *>(get(entity, component_id<T>()));
+      }
+
+      template <typename T> bool has(Entity entity) const {
+        return alive(entity) &&
+               _records[entity._index]._archetype->mask().test(
+                   component_id<T>());
+      }
+
+      // fn(count, entities, arrays...) for every chunk of the entities
+      // having Ts, an array per component. The loops over whole arrays are
+      // the ones the compiler vectorizes
+      template <typename... Ts, typename F> void each_chunk(F &&fn) {
+        ComponentMask mask = component_mask<Ts...>();
+        for (Archetype *archetype : _archetypeList) {
+          if ((archetype->mask() & mask) != mask) {
+            continue;
+          }
+          for (size_t i = 0; i < archetype->chunk_count(); i++) {
+            Chunk &chunk = archetype->chunk(i);
+            fn(chunk._count, (const Entity *)archetype->entities(chunk),
+               array<Ts>(*archetype, chunk)...);
+          }
+        }
+      }
+
+      // fn(entity, components...) for every entity having Ts
+      template <typename... Ts, typename F> void each(F &&fn) {
+        each_chunk<Ts...>(
+            [&](uint32_t count, const Entity *entities, Ts *...arrays) {
+              for (uint32_t i = 0; i < count; i++) {
+                fn(entities[i], arrays[i]...);
+              }
+            });
+      }
+
+      // each() with the chunks spread over the jobs, fn is called
+      // concurrently. Returns once every entity is done
+      template <typename... Ts, typename F>
+      void parallel_each(JobSystem &jobs, F &&fn) {
+        ComponentMask mask = component_mask<Ts...>();
+        // per call, fn may run another query
+        std::vector<std::pair<Archetype *, Chunk *>> chunks;
+        for (Archetype *archetype : _archetypeList) {
+          if ((archetype->mask() & mask) != mask) {
+            continue;
+          }
+          for (size_t i = 0; i < archetype->chunk_count(); i++) {
+            chunks.push_back({archetype, &archetype->chunk(i)});
+          }
+        }
+
+        auto rows = [&](uint32_t count, const Entity *entities,
+                        Ts *...arrays) {
+          for (uint32_t i = 0; i < count; i++) {
+            fn(entities[i], arrays[i]...);
+          }
+        };
+        jobs.parallel_for(chunks.size(), 1, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; i++) {
+            auto [archetype, chunk] = chunks[i];
+            rows(chunk->_count, archetype->entities(*chunk),
+                 array<Ts>(*archetype, *chunk)...);
+          }
+        });
+      }
+
+    private:
+      struct Record {
+          // nullptr once the entity is destroyed
+          Archetype *_archetype = nullptr;
+          uint32_t _chunk = 0;
+          uint32_t _row = 0;
+          uint32_t _generation = 0;
+      };
+
+      std::vector<Record> _records;
+      // indices of the destroyed entities, reused by the new ones
+      std::vector<uint32_t> _freeIndices;
+      size_t _aliveCount = 0;
+
+      std::unordered_map<ComponentMask, std::unique_ptr<Archetype>>
+          _archetypes;
+      // in creation order, the order queries go through them
+      std::vector<Archetype *> _archetypeList;
+
+      template <typename T>
+      static T *array(Archetype &archetype, Chunk &chunk) {
+        return reinterpret_cast<T *>(archetype.array(
+            chunk, component_id<std::remove_const_t<T>>()));
+      }
+
+      Archetype &archetype(const ComponentMask &mask);
+      // moves an entity to another archetype, keeping the components both
+      // have
+      void move(Entity entity, Archetype &target);
+  };
+} // namespace AltE
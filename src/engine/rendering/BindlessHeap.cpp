@@ -0,0 +1,190 @@
+#include "BindlessHeap.hpp"
+#include "vk_abstract.hpp"
+#include "vk_check.hpp"
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  uint32_t BindlessHeap::Slots::allocate() {
+    if (!_free.empty()) {
+      uint32_t slot = _free.back();
+      _free.pop_back();
+      return slot;
+    }
+    if (_next < _capacity) {
+      return _next++;
+    }
+    return INVALID_BINDLESS_INDEX;
+  }
+
+  void BindlessHeap::init(VkDevice device, uint32_t maxTextures,
+                          uint32_t maxBuffers) {
+    _device = device;
+    _textures._capacity = maxTextures;
+    _buffers._capacity = maxBuffers;
+
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+    bindings[0].binding = TEXTURE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = maxTextures;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1].binding = BUFFER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = maxBuffers;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    // the unused slots are never written, and slots are written while the
+    // set is bound to command buffers the GPU runs, which don't use them
+    VkDescriptorBindingFlags bindingFlags[2];
+    for (VkDescriptorBindingFlags &flags : bindingFlags) {
+      flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+              VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+              VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+    bindingFlagsInfo.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.pNext = nullptr;
+    bindingFlagsInfo.bindingCount = 2;
+    bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.pNext = &bindingFlagsInfo;
+    setLayoutInfo.flags =
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    setLayoutInfo.bindingCount = 2;
+    setLayoutInfo.pBindings = bindings;
+    VK_CHECK(vkCreateDescriptorSetLayout(_device, &setLayoutInfo, nullptr,
+                                         &_setLayout));
+
+    VkDescriptorPoolSize poolSizes[2] = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = maxTextures;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = maxBuffers;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    VK_CHECK(vkCreateDescriptorPool(_device, &poolInfo, nullptr,
+                                    &_descriptorPool));
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.descriptorPool = _descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &_setLayout;
+    VK_CHECK(vkAllocateDescriptorSets(_device, &allocInfo, &_set));
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = PUSH_CONSTANT_STAGES;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = PUSH_CONSTANT_SIZE;
+
+    VkPipelineLayoutCreateInfo layoutInfo =
+        vk_abstract::pipeline_layout_create_info();
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &_setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK(vkCreatePipelineLayout(_device, &layoutInfo, nullptr,
+                                    &_pipelineLayout));
+  }
+
+  void BindlessHeap::cleanup() {
+    vkDestroyPipelineLayout(_device, _pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(_device, _descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(_device, _setLayout, nullptr);
+    _textures = {};
+    _buffers = {};
+  }
+
+  BindlessIndex BindlessHeap::add_texture(VkImageView view,
+                                          VkSampler sampler) {
+    BindlessIndex index = _textures.allocate();
+    if (index == INVALID_BINDLESS_INDEX) {
+      spdlog::default_logger()->error("No bindless slot left for a texture, "
+                                      "all {} are used",
+                                      _textures._capacity);
+      return index;
+    }
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = view;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = nullptr;
+    write.dstSet = _set;
+    write.dstBinding = TEXTURE_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+    return index;
+  }
+
+  BindlessIndex BindlessHeap::add_buffer(VkBuffer buffer, VkDeviceSize offset,
+                                         VkDeviceSize range) {
+    BindlessIndex index = _buffers.allocate();
+    if (index == INVALID_BINDLESS_INDEX) {
+      spdlog::default_logger()->error("No bindless slot left for a buffer, "
+                                      "all {} are used",
+                                      _buffers._capacity);
+      return index;
+    }
+
+    VkDescriptorBufferInfo bufferInfo = {buffer, offset, range};
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = nullptr;
+    write.dstSet = _set;
+    write.dstBinding = BUFFER_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+    return index;
+  }
+
+  void BindlessHeap::release_texture(uint64_t frame, BindlessIndex index) {
+    if (index != INVALID_BINDLESS_INDEX) {
+      _textures._released.push_back({index, frame});
+    }
+  }
+
+  void BindlessHeap::release_buffer(uint64_t frame, BindlessIndex index) {
+    if (index != INVALID_BINDLESS_INDEX) {
+      _buffers._released.push_back({index, frame});
+    }
+  }
+
+  void BindlessHeap::collect(uint64_t completedFrame) {
+    collect(_textures, completedFrame);
+    collect(_buffers, completedFrame);
+  }
+
+  void BindlessHeap::collect(Slots &slots, uint64_t completedFrame) {
+    // released in frame order, the done ones are at the front
+    size_t done = 0;
+    while (done < slots._released.size() &&
+           slots._released[done].second <= completedFrame) {
+      slots._free.push_back(slots._released[done].first);
+      done++;
+    }
+    slots._released.erase(slots._released.begin(),
+                          slots._released.begin() + done);
+  }
+} // namespace AltE
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // slot of a texture or a buffer in the bindless set, handed to the
+  // shaders through push constants or instance data
+  using BindlessIndex = uint32_t;
+  constexpr BindlessIndex INVALID_BINDLESS_INDEX = UINT32_MAX;
+
+  // one descriptor set holding every texture and storage buffer of the
+  // engine, indexed by the shaders (descriptor indexing, Vulkan 1.2). It is
+  // bound once per command buffer and shared by every pipeline using
+  // pipeline_layout(), so drawing never allocates nor switches descriptor
+  // sets, and draws using different textures can still be batched.
+  //
+  // Slots come from free lists. A released slot is only reused once the GPU
+  // is done with the frame that released it, the set being updated after
+  // bind while other slots are in use. Only used from the render thread
+  class BindlessHeap {
+    public:
+      // binding 0: sampler2D textures[], binding 1: buffers[]
+      static constexpr uint32_t TEXTURE_BINDING = 0;
+      static constexpr uint32_t BUFFER_BINDING = 1;
+      // the smallest maxPushConstantsSize the spec allows
+      static constexpr uint32_t PUSH_CONSTANT_SIZE = 128;
+      // the push constants of pipeline_layout() are visible to all of them
+      static constexpr VkShaderStageFlags PUSH_CONSTANT_STAGES =
+          VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT |
+          VK_SHADER_STAGE_COMPUTE_BIT;
+
+      void init(VkDevice device, uint32_t maxTextures = 4096,
+                uint32_t maxBuffers = 4096);
+      void cleanup();
+
+      VkDescriptorSetLayout set_layout() const { return _setLayout; }
+      VkDescriptorSet set() const { return _set; }
+      // set 0 is the heap, PUSH_CONSTANT_SIZE bytes of push constants
+      VkPipelineLayout pipeline_layout() const { return _pipelineLayout; }
+
+      // INVALID_BINDLESS_INDEX when the heap is full. The image must be in
+      // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL when it is sampled
+      BindlessIndex add_texture(VkImageView view, VkSampler sampler);
+      BindlessIndex add_buffer(VkBuffer buffer, VkDeviceSize offset = 0,
+                               VkDeviceSize range = VK_WHOLE_SIZE);
+
+      // the slot is reused once frame is done on the GPU
+      void release_texture(uint64_t frame, BindlessIndex index);
+      void release_buffer(uint64_t frame, BindlessIndex index);
+
+      // gives back the slots released by every frame up to completedFrame
+      void collect(uint64_t completedFrame);
+
+      uint32_t texture_count() const {
+        return _textures._next - (uint32_t)_textures._free.size();
+      }
+      uint32_t buffer_count() const {
+        return _buffers._next - (uint32_t)_buffers._free.size();
+      }
+
+    private:
+      struct Slots {
+          uint32_t _capacity = 0;
+          // slots past this one were never used
+          uint32_t _next = 0;
+          std::vector<uint32_t> _free;
+          // slot and frame that released it, in release order
+          std::vector<std::pair<uint32_t, uint64_t>> _released;
+
+          uint32_t allocate();
+      };
+
+      VkDevice _device = VK_NULL_HANDLE;
+      VkDescriptorSetLayout _setLayout = VK_NULL_HANDLE;
+      VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+      VkDescriptorSet _set = VK_NULL_HANDLE;
+      VkPipelineLayout _pipelineLayout = VK_NULL_HANDLE;
+
+      Slots _textures;
+      Slots _buffers;
+
+      static void collect(Slots &slots, uint64_t completedFrame);
+  };
+} // namespace AltE
@@ -0,0 +1,108 @@
+#include "DeletionQueue.hpp"
+
+namespace {
+  template <typename Handle> Handle from_record(uint64_t handle) {
+    if constexpr (std::is_pointer_v<Handle>) {
+      return reinterpret_cast<Handle>(static_cast<uintptr_t>(handle));
+    } else {
+      return static_cast<Handle>(handle);
+    }
+  }
+} // namespace
+
+namespace AltE {
+  void DeletionQueue::init(VkDevice device, GpuAllocator *allocator) {
+    _device = device;
+    _allocator = allocator;
+  }
+
+  void DeletionQueue::collect(uint64_t completedFrame) {
+    size_t count = 0;
+    while (count < _retired.size() &&
+           _retired[count]._frame <= completedFrame) {
+      destroy(_retired[count]);
+      count++;
+    }
+    _retired.erase(_retired.begin(), _retired.begin() + count);
+  }
+
+  void DeletionQueue::flush() {
+    for (const Record &record : _retired) {
+      destroy(record);
+    }
+    _retired.clear();
+
+    // reverse iterate, objects are destroyed before what they depend on
+    for (auto it = _records.rbegin(); it != _records.rend(); ++it) {
+      destroy(*it);
+    }
+    _records.clear();
+  }
+
+  void DeletionQueue::destroy(const Record &record) {
+    uint64_t handle = record._handle;
+
+    switch (record._type) {
+      case DeletionType::Pipeline:
+        vkDestroyPipeline(_device, from_record<VkPipeline>(handle), nullptr);
+        break;
+      case DeletionType::PipelineLayout:
+        vkDestroyPipelineLayout(_device, from_record<VkPipelineLayout>(handle),
+                                nullptr);
+        break;
+      case DeletionType::RenderPass:
+        vkDestroyRenderPass(_device, from_record<VkRenderPass>(handle),
+                            nullptr);
+        break;
+      case DeletionType::Framebuffer:
+        vkDestroyFramebuffer(_device, from_record<VkFramebuffer>(handle),
+                             nullptr);
+        break;
+      case DeletionType::ImageView:
+        vkDestroyImageView(_device, from_record<VkImageView>(handle), nullptr);
+        break;
+      case DeletionType::Sampler:
+        vkDestroySampler(_device, from_record<VkSampler>(handle), nullptr);
+        break;
+      case DeletionType::DescriptorPool:
+        vkDestroyDescriptorPool(_device, from_record<VkDescriptorPool>(handle),
+                                nullptr);
+        break;
+      case DeletionType::DescriptorSetLayout:
+        vkDestroyDescriptorSetLayout(
+            _device, from_record<VkDescriptorSetLayout>(handle), nullptr);
+        break;
+      case DeletionType::CommandPool:
+        vkDestroyCommandPool(_device, from_record<VkCommandPool>(handle),
+                             nullptr);
+        break;
+      case DeletionType::Fence:
+        vkDestroyFence(_device, from_record<VkFence>(handle), nullptr);
+        break;
+      case DeletionType::Semaphore:
+        vkDestroySemaphore(_device, from_record<VkSemaphore>(handle), nullptr);
+        break;
+      case DeletionType::QueryPool:
+        vkDestroyQueryPool(_device, from_record<VkQueryPool>(handle), nullptr);
+        break;
+      case DeletionType::Swapchain:
+        vkDestroySwapchainKHR(_device, from_record<VkSwapchainKHR>(handle),
+                              nullptr);
+        break;
+      case DeletionType::Buffer:
+        vmaDestroyBuffer(_allocator->get(), from_record<VkBuffer>(handle),
+                         static_cast<VmaAllocation>(record._data));
+        break;
+      case DeletionType::Image:
+        vmaDestroyImage(_allocator->get(), from_record<VkImage>(handle),
+                        static_cast<VmaAllocation>(record._data));
+        break;
+      case DeletionType::Allocation:
+        vmaFreeMemory(_allocator->get(), from_record<VmaAllocation>(handle));
+        break;
+      case DeletionType::Callback:
+        record._callback(record._data);
+        break;
+    }
+  }
+} // namespace AltE
@@ -1,21 +1,104 @@
 #pragma once
 
-#include <deque>
-#include <functional>
+#include "GpuAllocator.hpp"
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan.h>
 
 namespace AltE {
-  struct DeletionQueue {
-      std::deque<std::function<void()>> deletors;
+  // kind of object a deletion record destroys
+  enum class DeletionType : uint8_t {
+    Pipeline,
+    PipelineLayout,
+    RenderPass,
+    Framebuffer,
+    ImageView,
+    Sampler,
+    DescriptorPool,
+    DescriptorSetLayout,
+    CommandPool,
+    Fence,
+    Semaphore,
+    QueryPool,
+    Swapchain,
+    // the allocation goes in the data of the record
+    Buffer,
+    Image,
+    // memory without a resource, the allocation is the handle
+    Allocation,
+    // calls a function with the data of the record
+    Callback,
+  };
 
-      void push_function(std::function<void()> f) { deletors.push_back(f); }
+  // destroys the objects of the engine. Objects pushed live until flush(),
+  // which destroys them in reverse order. Objects retired while the engine
+  // runs are destroyed by collect() once the GPU is done with the frame that
+  // retired them, so nothing has to wait for the whole device to go idle.
+  // Records are plain handles in a flat vector, nothing is allocated per
+  // object. Only used from the render thread
+  class DeletionQueue {
+    public:
+      // allocator is only used for the buffers and the images, it can be
+      // initialized later
+      void init(VkDevice device, GpuAllocator *allocator);
 
-      void flush() {
-        // reverse iterate the deletion queue to execute all the functions
-        for (auto it = deletors.rbegin(); it != deletors.rend(); ++it) {
-          (*it)(); // call the function
-        }
+      // destroyed by flush()
+      template <typename Handle>
+      void push(DeletionType type, Handle handle, void *data = nullptr) {
+        _records.push_back({type, to_record(handle), data, nullptr, 0});
+      }
+
+      void push_callback(void (*callback)(void *), void *data) {
+        _records.push_back({DeletionType::Callback, 0, data, callback, 0});
+      }
+
+      // calls object->cleanup() (or any other method) at flush()
+      template <auto Method, typename T> void push_cleanup(T *object) {
+        push_callback([](void *data) { (static_cast<T *>(data)->*Method)(); },
+                      object);
+      }
+
+      // destroyed by collect() once frame is done on the GPU
+      template <typename Handle>
+      void retire(uint64_t frame, DeletionType type, Handle handle,
+                  void *data = nullptr) {
+        _retired.push_back({type, to_record(handle), data, nullptr, frame});
+      }
+
+      // destroys the retired objects of every frame up to completedFrame
+      void collect(uint64_t completedFrame);
+
+      // destroys everything, the GPU must be idle
+      void flush();
+
+    private:
+      struct Record {
+          DeletionType _type;
+          uint64_t _handle;
+          void *_data;
+          void (*_callback)(void *);
+          // frame that retired the object
+          uint64_t _frame;
+      };
 
-        deletors.clear();
+      VkDevice _device = VK_NULL_HANDLE;
+      GpuAllocator *_allocator = nullptr;
+
+      std::vector<Record> _records;
+      // in retirement order, so frames only grow
+      std::vector<Record> _retired;
+
+      // non dispatchable handles are pointers on 64 bits platforms and
+      // integers elsewhere
+      template <typename Handle> static uint64_t to_record(Handle handle) {
+        if constexpr (std::is_pointer_v<Handle>) {
+          return reinterpret_cast<uintptr_t>(handle);
+        } else {
+          return static_cast<uint64_t>(handle);
+        }
       }
+
+      void destroy(const Record &record);
   };
-} // namespace AltE
\ No newline at end of file
+} // namespace AltE
@@ -0,0 +1,156 @@
+#include "DrawList.hpp"
+#include <cstring>
+
+namespace AltE {
+  void DrawList::push_constants(DrawCommand &draw, const void *data,
+                                uint32_t size, VkShaderStageFlags stages) {
+    draw._pushOffset = (uint32_t)_pushConstants.size();
+    draw._pushSize = size;
+    draw._pushStages = stages;
+    _pushConstants.resize(draw._pushOffset + size);
+    std::memcpy(_pushConstants.data() + draw._pushOffset, data, size);
+  }
+
+  void DrawList::add_mesh(VkPipeline pipeline, const GpuMesh &mesh,
+                          VkPipelineLayout layout, const void *pushConstants,
+                          uint32_t pushSize) {
+    DrawCommand draw = {};
+    draw._pipeline = pipeline;
+    draw._layout = layout;
+    push_constants(draw, pushConstants, pushSize);
+
+    // the vertices and the indices are in the same arena buffer
+    draw._vertexBuffer = mesh._buffer;
+    draw._vertexBufferOffset = 0;
+    draw._indexBuffer = mesh._buffer;
+    draw._indexBufferOffset = mesh._indexBufferOffset;
+    draw._indexType = mesh._indexType;
+
+    draw._count = mesh._indexCount;
+    draw._instanceCount = 1;
+    draw._first = mesh._firstIndex;
+    draw._vertexOffset = mesh._vertexOffset;
+    _draws.push_back(draw);
+  }
+
+  void DrawList::add_instances(VkPipeline pipeline, VkPipelineLayout layout,
+                               VkDescriptorSet descriptorSet,
+                               VkBuffer instanceBuffer,
+                               VkDeviceSize instanceOffset,
+                               uint32_t vertexCount, uint32_t instanceCount,
+                               uint32_t firstInstance,
+                               const void *pushConstants, uint32_t pushSize,
+                               VkShaderStageFlags pushStages) {
+    DrawCommand draw = {};
+    draw._pipeline = pipeline;
+    draw._layout = layout;
+    draw._descriptorSet = descriptorSet;
+    push_constants(draw, pushConstants, pushSize, pushStages);
+
+    draw._vertexBuffer = instanceBuffer;
+    draw._vertexBufferOffset = instanceOffset;
+
+    draw._count = vertexCount;
+    draw._instanceCount = instanceCount;
+    draw._firstInstance = firstInstance;
+    _draws.push_back(draw);
+  }
+
+  void DrawList::add_indirect(VkPipeline pipeline, VkPipelineLayout layout,
+                              VkDescriptorSet descriptorSet,
+                              VkBuffer meshBuffer, VkDeviceSize indexOffset,
+                              VkIndexType indexType, VkBuffer indirectBuffer,
+                              VkBuffer countBuffer, uint32_t maxDrawCount,
+                              const void *pushConstants, uint32_t pushSize) {
+    DrawCommand draw = {};
+    draw._pipeline = pipeline;
+    draw._layout = layout;
+    draw._descriptorSet = descriptorSet;
+    push_constants(draw, pushConstants, pushSize);
+
+    draw._vertexBuffer = meshBuffer;
+    draw._vertexBufferOffset = 0;
+    draw._indexBuffer = meshBuffer;
+    draw._indexBufferOffset = indexOffset;
+    draw._indexType = indexType;
+
+    draw._indirectBuffer = indirectBuffer;
+    draw._countBuffer = countBuffer;
+    draw._count = maxDrawCount;
+    _draws.push_back(draw);
+  }
+
+  void DrawList::record(VkCommandBuffer cmd, size_t first,
+                        size_t count) const {
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkDescriptorSet boundSet = VK_NULL_HANDLE;
+    VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize boundVertexOffset = 0;
+    VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize boundIndexOffset = 0;
+    VkIndexType boundIndexType = VK_INDEX_TYPE_UINT16;
+
+    for (size_t i = first; i < first + count; i++) {
+      const DrawCommand &draw = _draws[i];
+
+      if (draw._pipeline != boundPipeline) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          draw._pipeline);
+        boundPipeline = draw._pipeline;
+      }
+
+      if (draw._descriptorSet != VK_NULL_HANDLE &&
+          draw._descriptorSet != boundSet) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                draw._layout, 0, 1, &draw._descriptorSet, 0,
+                                nullptr);
+        boundSet = draw._descriptorSet;
+      }
+
+      if (draw._pushSize > 0) {
+        vkCmdPushConstants(cmd, draw._layout, draw._pushStages, 0,
+                           draw._pushSize,
+                           _pushConstants.data() + draw._pushOffset);
+      }
+
+      // the meshes share the arena buffer and the sprites of a frame share
+      // one instance buffer, so this mostly happens once per kind of draw
+      if (draw._vertexBuffer != VK_NULL_HANDLE &&
+          (draw._vertexBuffer != boundVertexBuffer ||
+           draw._vertexBufferOffset != boundVertexOffset)) {
+        vkCmdBindVertexBuffers(cmd, 0, 1, &draw._vertexBuffer,
+                               &draw._vertexBufferOffset);
+        boundVertexBuffer = draw._vertexBuffer;
+        boundVertexOffset = draw._vertexBufferOffset;
+      }
+
+      if (draw._indexBuffer == VK_NULL_HANDLE) {
+        vkCmdDraw(cmd, draw._count, draw._instanceCount, draw._first,
+                  draw._firstInstance);
+        continue;
+      }
+
+      if (draw._indexBuffer != boundIndexBuffer ||
+          draw._indexBufferOffset != boundIndexOffset ||
+          draw._indexType != boundIndexType) {
+        vkCmdBindIndexBuffer(cmd, draw._indexBuffer, draw._indexBufferOffset,
+                             draw._indexType);
+        boundIndexBuffer = draw._indexBuffer;
+        boundIndexOffset = draw._indexBufferOffset;
+        boundIndexType = draw._indexType;
+      }
+
+      if (draw._indirectBuffer == VK_NULL_HANDLE) {
+        vkCmdDrawIndexed(cmd, draw._count, draw._instanceCount, draw._first,
+                         draw._vertexOffset, draw._firstInstance);
+      } else if (draw._countBuffer != VK_NULL_HANDLE) {
+        vkCmdDrawIndexedIndirectCount(cmd, draw._indirectBuffer, 0,
+                                      draw._countBuffer, 0, draw._count,
+                                      sizeof(VkDrawIndexedIndirectCommand));
+      } else {
+        vkCmdDrawIndexedIndirect(cmd, draw._indirectBuffer, 0, draw._count,
+                                 sizeof(VkDrawIndexedIndirectCommand));
+      }
+    }
+  }
+} // namespace AltE
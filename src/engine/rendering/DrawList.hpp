@@ -0,0 +1,109 @@
+#pragma once
+
+#include "MeshArena.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // a single draw, indexed when it comes from the mesh arena
+  struct DrawCommand {
+      VkPipeline _pipeline;
+      // only set when the draw has push constants or a descriptor set
+      VkPipelineLayout _layout;
+      // bound to set 0, VK_NULL_HANDLE when the draw has none
+      VkDescriptorSet _descriptorSet;
+      // push constants, in the push constant data of the list
+      uint32_t _pushOffset;
+      uint32_t _pushSize;
+      // every stage of the push constant range of _layout
+      VkShaderStageFlags _pushStages;
+
+      // bound to binding 0, VK_NULL_HANDLE for the draws without vertex
+      // buffer
+      VkBuffer _vertexBuffer;
+      VkDeviceSize _vertexBufferOffset;
+      // VK_NULL_HANDLE for the draws that aren't indexed
+      VkBuffer _indexBuffer;
+      VkDeviceSize _indexBufferOffset;
+      VkIndexType _indexType;
+
+      // indirect draws read _count commands from here, VK_NULL_HANDLE for
+      // the direct ones
+      VkBuffer _indirectBuffer;
+      // draw count written by the GPU, capped by _count. VK_NULL_HANDLE to
+      // always draw _count commands
+      VkBuffer _countBuffer;
+
+      // vertices, indices for the indexed draws, commands for the indirect
+      // ones
+      uint32_t _count;
+      uint32_t _instanceCount;
+      // first vertex, or first index for the indexed draws
+      uint32_t _first;
+      int32_t _vertexOffset;
+      uint32_t _firstInstance;
+  };
+
+  // draws of a frame, in submission order. A range of it can be recorded
+  // into any command buffer, so the list can be split between threads
+  class DrawList {
+    public:
+      void add(VkPipeline pipeline, uint32_t vertexCount,
+               uint32_t instanceCount = 1, uint32_t firstVertex = 0,
+               uint32_t firstInstance = 0) {
+        DrawCommand draw = {};
+        draw._pipeline = pipeline;
+        draw._count = vertexCount;
+        draw._instanceCount = instanceCount;
+        draw._first = firstVertex;
+        draw._firstInstance = firstInstance;
+        _draws.push_back(draw);
+      }
+
+      // indexed draw of a mesh, pushConstants are copied
+      void add_mesh(VkPipeline pipeline, const GpuMesh &mesh,
+                    VkPipelineLayout layout, const void *pushConstants,
+                    uint32_t pushSize);
+
+      // instanceCount instances of vertexCount vertices, reading per
+      // instance data from instanceBuffer. pushConstants are copied
+      void add_instances(
+          VkPipeline pipeline, VkPipelineLayout layout,
+          VkDescriptorSet descriptorSet, VkBuffer instanceBuffer,
+          VkDeviceSize instanceOffset, uint32_t vertexCount,
+          uint32_t instanceCount, uint32_t firstInstance,
+          const void *pushConstants, uint32_t pushSize,
+          VkShaderStageFlags pushStages = VK_SHADER_STAGE_VERTEX_BIT);
+
+      // indexed draws whose commands are read by the GPU from
+      // indirectBuffer, countBuffer holds their count when it is set.
+      // pushConstants are copied
+      void add_indirect(VkPipeline pipeline, VkPipelineLayout layout,
+                        VkDescriptorSet descriptorSet, VkBuffer meshBuffer,
+                        VkDeviceSize indexOffset, VkIndexType indexType,
+                        VkBuffer indirectBuffer, VkBuffer countBuffer,
+                        uint32_t maxDrawCount, const void *pushConstants,
+                        uint32_t pushSize);
+
+      void clear() {
+        _draws.clear();
+        _pushConstants.clear();
+      }
+      size_t size() const { return _draws.size(); }
+      bool empty() const { return _draws.empty(); }
+
+      // records count draws starting at first. The pipeline, the
+      // descriptor set and the buffers are only bound when they change
+      void record(VkCommandBuffer cmd, size_t first, size_t count) const;
+
+    private:
+      std::vector<DrawCommand> _draws;
+      std::vector<std::byte> _pushConstants;
+
+      void
+      push_constants(DrawCommand &draw, const void *data, uint32_t size,
+                     VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT);
+  };
+} // namespace AltE
@@ -0,0 +1,107 @@
+#include "FramePacer.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <thread>
+
+namespace AltE {
+  void FramePacer::init(int refreshRate) {
+    if (refreshRate <= 0) {
+      // most displays, and what SDL reports when it doesn't know
+      refreshRate = 60;
+    }
+    _refreshPeriod = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / refreshRate));
+
+    SPDLOG_DEBUG("Frame pacer initialized for {} Hz", refreshRate);
+  }
+
+  void FramePacer::set_enabled(bool enabled) {
+    _enabled = enabled;
+    // start measuring from scratch, the frames paced differently
+    _workCount = 0;
+    _frameStarted = false;
+    _deadline = {};
+  }
+
+  void FramePacer::wait_for_frame_start() {
+    if (_enabled && _deadline != Clock::time_point{}) {
+      Clock::time_point start = _deadline - predicted_work() - SAFETY_MARGIN;
+
+      // sleep for most of the wait, the OS wakes us up late, and spin the
+      // rest
+      Clock::time_point now = Clock::now();
+      if (start - now > SPIN_THRESHOLD) {
+        std::this_thread::sleep_until(start - SPIN_THRESHOLD);
+      }
+      while (Clock::now() < start) {
+        std::this_thread::yield();
+      }
+    }
+
+    _frameStart = Clock::now();
+    _frameStarted = true;
+  }
+
+  void FramePacer::frame_presented() {
+    Clock::time_point now = Clock::now();
+
+    if (_hasPresented) {
+      _intervalsMs[_intervalCount % PRESENT_HISTORY] =
+          std::chrono::duration<double, std::milli>(now - _lastPresent)
+              .count();
+      _intervalCount++;
+    }
+    _lastPresent = now;
+    _hasPresented = true;
+
+    if (!_enabled || !_frameStarted) {
+      return;
+    }
+    _frameStarted = false;
+
+    _workHistory[_workCount % WORK_HISTORY] = now - _frameStart;
+    _workCount++;
+
+    // the next frame is due one refresh later. When this one was late, the
+    // refresh it aimed for is gone, align on the next one from now
+    _deadline += _refreshPeriod;
+    if (_deadline < now) {
+      _deadline = now + _refreshPeriod;
+    }
+  }
+
+  PresentIntervals FramePacer::take_present_intervals() {
+    PresentIntervals intervals;
+    if (_intervalCount == 0) {
+      return intervals;
+    }
+
+    size_t count = std::min(_intervalCount, PRESENT_HISTORY);
+    _sortedMs.assign(_intervalsMs, _intervalsMs + count);
+    std::sort(_sortedMs.begin(), _sortedMs.end());
+
+    double total = 0.0;
+    for (double interval : _sortedMs) {
+      total += interval;
+    }
+
+    intervals.count = count;
+    intervals.meanMs = total / count;
+    intervals.minMs = _sortedMs.front();
+    intervals.p99Ms = _sortedMs[(count - 1) * 99 / 100];
+    intervals.maxMs = _sortedMs.back();
+
+    _intervalCount = 0;
+    return intervals;
+  }
+
+  FramePacer::Clock::duration FramePacer::predicted_work() const {
+    size_t count = std::min(_workCount, WORK_HISTORY);
+    Clock::duration slowest{};
+    for (size_t i = 0; i < count; i++) {
+      slowest = std::max(slowest, _workHistory[i]);
+    }
+    // never start earlier than a full refresh ahead
+    return std::min(slowest, _refreshPeriod);
+  }
+} // namespace AltE
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AltE {
+  // measured time between two presents, in milliseconds
+  struct PresentIntervals {
+      size_t count = 0;
+      double meanMs = 0.0;
+      double minMs = 0.0;
+      double p99Ms = 0.0;
+      double maxMs = 0.0;
+  };
+
+  // paces the frames for latency. Instead of starting a frame as soon as the
+  // previous one is submitted and letting it wait in the queue, the start of
+  // the frame is delayed until the latest point where it can still be
+  // presented on time. The input read right after that point is then as
+  // recent as possible when the frame reaches the screen.
+  // Also measures the interval between presents, enabled or not
+  class FramePacer {
+    public:
+      using Clock = std::chrono::steady_clock;
+
+      // refreshRate of the display in Hz, 0 when unknown
+      void init(int refreshRate);
+
+      void set_enabled(bool enabled);
+      bool enabled() const { return _enabled; }
+
+      // called before the events of the frame are read. Sleeps until the
+      // predicted start point when enabled
+      void wait_for_frame_start();
+
+      // called once the frame has been presented
+      void frame_presented();
+
+      // intervals measured since the last call, the last PRESENT_HISTORY
+      // of them at most
+      PresentIntervals take_present_intervals();
+
+    private:
+      // the work of a frame is predicted from the slowest of the last few
+      // frames, a single slow frame shouldn't push the others out of their
+      // refresh
+      static constexpr size_t WORK_HISTORY = 16;
+      // slack for the scheduling jitter of the OS
+      static constexpr std::chrono::microseconds SAFETY_MARGIN{1500};
+      // the last part of a sleep is spun, sleeps overshoot by about as much
+      static constexpr std::chrono::microseconds SPIN_THRESHOLD{1000};
+      // present intervals kept, the older ones are dropped
+      static constexpr size_t PRESENT_HISTORY = 1024;
+
+      bool _enabled = false;
+      Clock::duration _refreshPeriod{};
+
+      // when the frame being recorded should be presented by
+      Clock::time_point _deadline{};
+      Clock::time_point _frameStart{};
+      bool _frameStarted = false;
+
+      Clock::duration _workHistory[WORK_HISTORY] = {};
+      size_t _workCount = 0;
+
+      Clock::time_point _lastPresent{};
+      bool _hasPresented = false;
+      // ring of the last intervals, _intervalCount written since the last
+      // take_present_intervals()
+      double _intervalsMs[PRESENT_HISTORY] = {};
+      size_t _intervalCount = 0;
+      // sorted copy, kept to not allocate on every take
+      std::vector<double> _sortedMs;
+
+      Clock::duration predicted_work() const;
+  };
+} // namespace AltE
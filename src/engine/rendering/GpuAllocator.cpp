@@ -0,0 +1,163 @@
+#include "GpuAllocator.hpp"
+#include "vk_check.hpp"
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  void GpuAllocator::init(VkInstance instance, VkPhysicalDevice physicalDevice,
+                          VkDevice device, uint32_t vulkanApiVersion) {
+    _device = device;
+
+    VmaAllocatorCreateInfo allocatorInfo = {};
+    allocatorInfo.physicalDevice = physicalDevice;
+    allocatorInfo.device = device;
+    allocatorInfo.instance = instance;
+    allocatorInfo.vulkanApiVersion = vulkanApiVersion;
+    VK_CHECK(vmaCreateAllocator(&allocatorInfo, &_allocator));
+
+    SPDLOG_DEBUG("GPU allocator initialized");
+  }
+
+  void GpuAllocator::cleanup() {
+    // anything still listed here has leaked
+    log_statistics();
+
+    vmaDestroyAllocator(_allocator);
+    _allocator = VK_NULL_HANDLE;
+  }
+
+  VmaAllocationCreateInfo
+  GpuAllocator::allocation_create_info(MemoryUsage memoryUsage) {
+    VmaAllocationCreateInfo allocInfo = {};
+
+    switch (memoryUsage) {
+      case MemoryUsage::GpuOnly:
+        allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        break;
+      case MemoryUsage::Upload:
+        allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocInfo.flags =
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+            VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        break;
+      case MemoryUsage::Readback:
+        allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
+                          VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        break;
+    }
+
+    return allocInfo;
+  }
+
+  AllocatedBuffer GpuAllocator::create_buffer(VkDeviceSize size,
+                                              VkBufferUsageFlags usage,
+                                              MemoryUsage memoryUsage) {
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.pNext = nullptr;
+
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocInfo = allocation_create_info(memoryUsage);
+
+    AllocatedBuffer buffer;
+    VmaAllocationInfo info;
+    VK_CHECK(vmaCreateBuffer(_allocator, &bufferInfo, &allocInfo,
+                             &buffer._buffer, &buffer._allocation, &info));
+    buffer._size = size;
+    buffer._mapped = info.pMappedData;
+    return buffer;
+  }
+
+  void GpuAllocator::destroy_buffer(AllocatedBuffer &buffer) {
+    vmaDestroyBuffer(_allocator, buffer._buffer, buffer._allocation);
+    buffer = {};
+  }
+
+  AllocatedImage GpuAllocator::create_image(const VkImageCreateInfo &imageInfo,
+                                            MemoryUsage memoryUsage) {
+    AllocatedImage image;
+    image._format = imageInfo.format;
+    image._extent = imageInfo.extent;
+
+    // create the image first, so we know exactly how much memory it needs
+    // before choosing where to put it
+    VK_CHECK(vkCreateImage(_device, &imageInfo, nullptr, &image._image));
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(_device, image._image, &requirements);
+
+    VmaAllocationCreateInfo allocInfo = allocation_create_info(memoryUsage);
+
+    const VkImageUsageFlags renderTargetUsage =
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if ((imageInfo.usage & renderTargetUsage) &&
+        requirements.size >= DEDICATED_THRESHOLD) {
+      allocInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    }
+
+    VK_CHECK(vmaAllocateMemoryForImage(_allocator, image._image, &allocInfo,
+                                       &image._allocation, nullptr));
+    VK_CHECK(vmaBindImageMemory(_allocator, image._allocation, image._image));
+
+    return image;
+  }
+
+  void GpuAllocator::destroy_image(AllocatedImage &image) {
+    vmaDestroyImage(_allocator, image._image, image._allocation);
+    image = {};
+  }
+
+  VmaAllocation
+  GpuAllocator::allocate_memory(const VkMemoryRequirements &requirements,
+                                MemoryUsage memoryUsage) {
+    VmaAllocationCreateInfo allocInfo = allocation_create_info(memoryUsage);
+
+    VmaAllocation allocation;
+    VK_CHECK(vmaAllocateMemory(_allocator, &requirements, &allocInfo,
+                               &allocation, nullptr));
+    return allocation;
+  }
+
+  void GpuAllocator::bind_image_memory(VmaAllocation allocation,
+                                       VkImage image) {
+    VK_CHECK(vmaBindImageMemory(_allocator, allocation, image));
+  }
+
+  void GpuAllocator::free_memory(VmaAllocation allocation) {
+    vmaFreeMemory(_allocator, allocation);
+  }
+
+  void GpuAllocator::log_statistics() const {
+    VmaTotalStatistics stats;
+    vmaCalculateStatistics(_allocator, &stats);
+
+    const VmaDetailedStatistics &total = stats.total;
+    // asked for explicitly, so logged in release builds too
+    spdlog::default_logger()->info(
+        "GPU memory: {} allocations ({} bytes) in {} blocks ({} bytes), {} "
+        "unused ranges",
+        total.statistics.allocationCount, total.statistics.allocationBytes,
+        total.statistics.blockCount, total.statistics.blockBytes,
+        total.unusedRangeCount);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(_allocator, budgets);
+
+    const VkPhysicalDeviceMemoryProperties *memoryProperties;
+    vmaGetMemoryProperties(_allocator, &memoryProperties);
+
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+      if (stats.memoryHeap[i].statistics.blockCount == 0) {
+        continue;
+      }
+      spdlog::default_logger()->info(
+          "  heap {}: {} / {} bytes used, {} allocations", i,
+          budgets[i].usage, budgets[i].budget,
+          stats.memoryHeap[i].statistics.allocationCount);
+    }
+  }
+} // namespace AltE
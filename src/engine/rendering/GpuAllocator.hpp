@@ -0,0 +1,74 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // where the memory of a resource should live
+  enum class MemoryUsage {
+    // only accessed by the GPU
+    GpuOnly,
+    // written sequentially by the CPU, read by the GPU. Persistently mapped
+    Upload,
+    // written by the GPU, read back by the CPU. Persistently mapped
+    Readback,
+  };
+
+  // every buffer and image of the engine is allocated through this, so they
+  // are suballocated from a few large VkDeviceMemory blocks instead of
+  // hitting maxMemoryAllocationCount
+  class GpuAllocator {
+    public:
+      void init(VkInstance instance, VkPhysicalDevice physicalDevice,
+                VkDevice device, uint32_t vulkanApiVersion);
+      void cleanup();
+
+      VmaAllocator get() const { return _allocator; }
+
+      AllocatedBuffer create_buffer(VkDeviceSize size,
+                                    VkBufferUsageFlags usage,
+                                    MemoryUsage memoryUsage);
+      void destroy_buffer(AllocatedBuffer &buffer);
+
+      template <typename T>
+      TypedBuffer<T> create_typed_buffer(size_t count,
+                                         VkBufferUsageFlags usage,
+                                         MemoryUsage memoryUsage) {
+        TypedBuffer<T> buffer;
+        static_cast<AllocatedBuffer &>(buffer) =
+            create_buffer(count * sizeof(T), usage, memoryUsage);
+        buffer._count = count;
+        return buffer;
+      }
+
+      // render targets bigger than DEDICATED_THRESHOLD get their own
+      // VkDeviceMemory, so they don't fragment the shared blocks and the
+      // driver can place them optimally
+      AllocatedImage create_image(const VkImageCreateInfo &imageInfo,
+                                  MemoryUsage memoryUsage =
+                                      MemoryUsage::GpuOnly);
+      void destroy_image(AllocatedImage &image);
+
+      // raw memory, for resources placed by hand like the aliased render
+      // targets of the render graph. Several images can be bound to the same
+      // allocation
+      VmaAllocation allocate_memory(const VkMemoryRequirements &requirements,
+                                    MemoryUsage memoryUsage =
+                                        MemoryUsage::GpuOnly);
+      void bind_image_memory(VmaAllocation allocation, VkImage image);
+      void free_memory(VmaAllocation allocation);
+
+      // logs the blocks, allocations and heap budgets
+      void log_statistics() const;
+
+      static constexpr VkDeviceSize DEDICATED_THRESHOLD = 8ull * 1024 * 1024;
+
+    private:
+      VmaAllocator _allocator = VK_NULL_HANDLE;
+      VkDevice _device = VK_NULL_HANDLE;
+
+      static VmaAllocationCreateInfo
+      allocation_create_info(MemoryUsage memoryUsage);
+  };
+} // namespace AltE
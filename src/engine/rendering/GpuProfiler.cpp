@@ -0,0 +1,203 @@
+#include "GpuProfiler.hpp"
+#include "../core/Profiler.hpp"
+#include "vk_check.hpp"
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  void GpuProfiler::init(VkInstance instance, VkPhysicalDevice physicalDevice,
+                         VkDevice device, float timestampPeriod,
+                         bool calibrated, bool debugLabels,
+                         uint32_t frameCount, uint32_t maxZones) {
+    _device = device;
+    _timestampPeriod = timestampPeriod;
+    _maxZones = maxZones;
+    _frames.resize(frameCount);
+
+    if (debugLabels) {
+      _beginLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(
+          instance, "vkCmdBeginDebugUtilsLabelEXT");
+      _endLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(
+          instance, "vkCmdEndDebugUtilsLabelEXT");
+    }
+
+    if (_timestampPeriod <= 0.f) {
+      return;
+    }
+
+    // two timestamps per zone
+    for (FrameQueries &frame : _frames) {
+      VkQueryPoolCreateInfo queryPoolInfo = {};
+      queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+      queryPoolInfo.pNext = nullptr;
+      queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+      queryPoolInfo.queryCount = maxZones * 2;
+      VK_CHECK(
+          vkCreateQueryPool(_device, &queryPoolInfo, nullptr, &frame._pool));
+    }
+
+    if (!calibrated) {
+      return;
+    }
+
+    // the steady clock is CLOCK_MONOTONIC on Linux, the only host domain
+    // the zones can be compared with
+    auto getTimeDomains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+        vkGetInstanceProcAddr(instance,
+                              "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+    uint32_t domainCount = 0;
+    std::vector<VkTimeDomainEXT> domains;
+    if (getTimeDomains != nullptr &&
+        getTimeDomains(physicalDevice, &domainCount, nullptr) == VK_SUCCESS) {
+      domains.resize(domainCount);
+      getTimeDomains(physicalDevice, &domainCount, domains.data());
+    }
+    bool hasDevice = false;
+    bool hasMonotonic = false;
+    for (VkTimeDomainEXT domain : domains) {
+      hasDevice |= domain == VK_TIME_DOMAIN_DEVICE_EXT;
+      hasMonotonic |= domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+    }
+
+    if (hasDevice && hasMonotonic) {
+      _getCalibratedTimestamps =
+          (PFN_vkGetCalibratedTimestampsEXT)vkGetDeviceProcAddr(
+              _device, "vkGetCalibratedTimestampsEXT");
+    }
+    if (_getCalibratedTimestamps == nullptr) {
+      SPDLOG_DEBUG(
+          "No calibrated timestamps, the GPU zones are aligned on the submits");
+    }
+  }
+
+  void GpuProfiler::cleanup() {
+    for (FrameQueries &frame : _frames) {
+      vkDestroyQueryPool(_device, frame._pool, nullptr);
+    }
+    _frames.clear();
+    _current = nullptr;
+  }
+
+  double GpuProfiler::resolve(uint32_t slot) {
+    FrameQueries &frame = _frames[slot];
+    if (!frame._pending) {
+      return -1.0;
+    }
+    frame._pending = false;
+    if (frame._pool == VK_NULL_HANDLE || frame._zones.empty()) {
+      return -1.0;
+    }
+
+    // the fence of the frame is signaled, so the results are available and
+    // we don't need to wait for them
+    uint32_t queryCount = (uint32_t)frame._zones.size() * 2;
+    _results.resize(queryCount);
+    if (vkGetQueryPoolResults(_device, frame._pool, 0, queryCount,
+                              queryCount * sizeof(uint64_t), _results.data(),
+                              sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+      return -1.0;
+    }
+
+    if (Profiler::enabled()) {
+      uint64_t gpuTick = 0;
+      uint64_t cpuTime = 0;
+      calibrate(frame, gpuTick, cpuTime);
+
+      auto to_cpu = [&](uint64_t tick) {
+        double ns = (double)(int64_t)(tick - gpuTick) * _timestampPeriod;
+        return cpuTime + (uint64_t)(int64_t)ns;
+      };
+      for (const Zone &zone : frame._zones) {
+        Profiler::record_gpu(zone._name, to_cpu(_results[zone._query]),
+                             to_cpu(_results[zone._query + 1]));
+      }
+    }
+
+    // the frame is the first zone
+    return (double)(_results[1] - _results[0]) * _timestampPeriod /
+           1000000.0;
+  }
+
+  void GpuProfiler::calibrate(const FrameQueries &frame, uint64_t &gpuTick,
+                              uint64_t &cpuTime) const {
+    if (_getCalibratedTimestamps != nullptr) {
+      VkCalibratedTimestampInfoEXT infos[2] = {};
+      infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+      infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+      infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+      infos[1].timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+
+      uint64_t timestamps[2];
+      uint64_t maxDeviation;
+      if (_getCalibratedTimestamps(_device, 2, infos, timestamps,
+                                   &maxDeviation) == VK_SUCCESS) {
+        gpuTick = timestamps[0];
+        cpuTime = timestamps[1];
+        return;
+      }
+    }
+
+    // the GPU can't start the frame before it is submitted
+    gpuTick = _results[0];
+    cpuTime = frame._submitTime;
+  }
+
+  void GpuProfiler::begin_frame(VkCommandBuffer cmd, uint32_t slot) {
+    _current = &_frames[slot];
+    _current->_zones.clear();
+    _openZones.clear();
+
+    if (_current->_pool != VK_NULL_HANDLE) {
+      vkCmdResetQueryPool(cmd, _current->_pool, 0, _maxZones * 2);
+    }
+    begin_zone(cmd, "frame");
+  }
+
+  void GpuProfiler::end_frame(VkCommandBuffer cmd) {
+    // zones left open end with the frame
+    while (!_openZones.empty()) {
+      end_zone(cmd);
+    }
+    _current->_submitTime = Profiler::now();
+    _current->_pending = true;
+  }
+
+  void GpuProfiler::begin_zone(VkCommandBuffer cmd, const char *name) {
+    if (_beginLabel != nullptr) {
+      VkDebugUtilsLabelEXT label = {};
+      label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+      label.pNext = nullptr;
+      label.pLabelName = name;
+      _beginLabel(cmd, &label);
+    }
+
+    if (_current->_pool == VK_NULL_HANDLE ||
+        _current->_zones.size() >= _maxZones) {
+      _openZones.push_back(UINT32_MAX);
+      return;
+    }
+
+    uint32_t query = (uint32_t)_current->_zones.size() * 2;
+    _openZones.push_back((uint32_t)_current->_zones.size());
+    _current->_zones.push_back({name, query});
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        _current->_pool, query);
+  }
+
+  void GpuProfiler::end_zone(VkCommandBuffer cmd) {
+    if (_openZones.empty()) {
+      return;
+    }
+    uint32_t zone = _openZones.back();
+    _openZones.pop_back();
+
+    if (zone != UINT32_MAX) {
+      vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                          _current->_pool,
+                          _current->_zones[zone]._query + 1);
+    }
+    if (_endLabel != nullptr) {
+      _endLabel(cmd);
+    }
+  }
+} // namespace AltE
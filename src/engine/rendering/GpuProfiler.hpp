@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // zones of the command buffers of the frames, timed with timestamp
+  // queries and handed to the Profiler once the GPU is done with them. The
+  // zones are also debug labels, shown by RenderDoc and the validation
+  // messages.
+  //
+  // GPU timestamps are moved to the CPU timeline with
+  // VK_EXT_calibrated_timestamps when the device has it. Otherwise a frame
+  // is assumed to start on the GPU when it is submitted, which shows the
+  // GPU zones a bit late. Only used from the render thread
+  class GpuProfiler {
+    public:
+      // timestampPeriod is 0 when the queue can't write timestamps, the
+      // zones are then labels only. calibrated: the device has
+      // VK_EXT_calibrated_timestamps enabled. debugLabels: the instance has
+      // VK_EXT_debug_utils enabled
+      void init(VkInstance instance, VkPhysicalDevice physicalDevice,
+                VkDevice device, float timestampPeriod, bool calibrated,
+                bool debugLabels, uint32_t frameCount,
+                uint32_t maxZones = 64);
+      void cleanup();
+
+      // reads back the zones of the last frame recorded in slot, whose
+      // fence is signaled. Returns the GPU time of that frame in
+      // milliseconds, negative when it isn't known
+      double resolve(uint32_t slot);
+
+      // first and last commands of the command buffer of a frame, outside
+      // of any render pass. The frame is a zone of its own
+      void begin_frame(VkCommandBuffer cmd, uint32_t slot);
+      void end_frame(VkCommandBuffer cmd);
+
+      // zones nest, the name must live until the trace is written
+      void begin_zone(VkCommandBuffer cmd, const char *name);
+      void end_zone(VkCommandBuffer cmd);
+
+    private:
+      struct Zone {
+          const char *_name;
+          // start, the end is the next query
+          uint32_t _query;
+      };
+
+      struct FrameQueries {
+          VkQueryPool _pool = VK_NULL_HANDLE;
+          std::vector<Zone> _zones;
+          // CPU time of end_frame(), right before the submit
+          uint64_t _submitTime = 0;
+          // recorded and not resolved yet
+          bool _pending = false;
+      };
+
+      VkDevice _device = VK_NULL_HANDLE;
+      float _timestampPeriod = 0.f;
+      uint32_t _maxZones = 0;
+
+      std::vector<FrameQueries> _frames;
+      FrameQueries *_current = nullptr;
+      // zones begun and not ended, UINT32_MAX for the ones past _maxZones
+      std::vector<uint32_t> _openZones;
+      std::vector<uint64_t> _results;
+
+      PFN_vkCmdBeginDebugUtilsLabelEXT _beginLabel = nullptr;
+      PFN_vkCmdEndDebugUtilsLabelEXT _endLabel = nullptr;
+      PFN_vkGetCalibratedTimestampsEXT _getCalibratedTimestamps = nullptr;
+
+      // a GPU tick and the steady clock time it happened at, to move the
+      // timestamps of frame to the CPU timeline. _results must hold them
+      void calibrate(const FrameQueries &frame, uint64_t &gpuTick,
+                     uint64_t &cpuTime) const;
+  };
+} // namespace AltE
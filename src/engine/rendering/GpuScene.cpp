@@ -0,0 +1,284 @@
+#include "GpuScene.hpp"
+#include "vk_abstract.hpp"
+#include "vk_check.hpp"
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  namespace {
+    // push constants of cull.comp
+    struct CullPushConstants {
+        // left, right, bottom, top, near, far, pointing inside
+        glm::vec4 _planes[6];
+        uint32_t _objectCount;
+        // 1 to pack the visible draws and count them, 0 to keep one draw
+        // per object
+        uint32_t _compact;
+    };
+
+    // local_size_x of cull.comp
+    constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+    // planes of the frustum from the view-projection matrix, with the
+    // depth in [0, 1] as in Vulkan
+    void frustum_planes(const glm::mat4 &m, glm::vec4 planes[6]) {
+      glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+      glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+      glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+      glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+      planes[0] = row3 + row0;
+      planes[1] = row3 - row0;
+      planes[2] = row3 + row1;
+      planes[3] = row3 - row1;
+      planes[4] = row2;
+      planes[5] = row3 - row2;
+      // normalized so the distance can be compared with a radius
+      for (int i = 0; i < 6; i++) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+      }
+    }
+  } // namespace
+
+  void GpuScene::init(VkDevice device, GpuAllocator &allocator,
+                      UploadQueue &uploads, const MeshArena &meshes,
+                      const GpuDrivenFeatures &features, uint32_t maxObjects,
+                      VkIndexType indexType) {
+    _device = device;
+    _allocator = &allocator;
+    _uploads = &uploads;
+    _meshes = &meshes;
+    _features = features;
+    _maxObjects = maxObjects;
+    _indexType = indexType;
+
+    _objectBuffer = _allocator->create_buffer(
+        (VkDeviceSize)maxObjects * sizeof(GpuObject),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        MemoryUsage::GpuOnly);
+    _drawBuffer = _allocator->create_buffer(
+        (VkDeviceSize)maxObjects * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        MemoryUsage::GpuOnly);
+    _countBuffer = _allocator->create_buffer(
+        sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        MemoryUsage::GpuOnly);
+
+    // objects, draws and count. The vertex shader only reads the objects
+    VkDescriptorSetLayoutBinding bindings[3] = {};
+    for (uint32_t i = 0; i < 3; i++) {
+      bindings[i].binding = i;
+      bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      bindings[i].descriptorCount = 1;
+      bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.pNext = nullptr;
+    setLayoutInfo.bindingCount = 3;
+    setLayoutInfo.pBindings = bindings;
+    VK_CHECK(vkCreateDescriptorSetLayout(_device, &setLayoutInfo, nullptr,
+                                         &_setLayout));
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 3;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    VK_CHECK(vkCreateDescriptorPool(_device, &poolInfo, nullptr,
+                                    &_descriptorPool));
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.descriptorPool = _descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &_setLayout;
+    VK_CHECK(vkAllocateDescriptorSets(_device, &allocInfo, &_set));
+
+    // the buffers never change, the set is written once
+    VkDescriptorBufferInfo bufferInfos[3] = {};
+    bufferInfos[0] = {_objectBuffer._buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[1] = {_drawBuffer._buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[2] = {_countBuffer._buffer, 0, VK_WHOLE_SIZE};
+
+    VkWriteDescriptorSet writes[3] = {};
+    for (uint32_t i = 0; i < 3; i++) {
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].pNext = nullptr;
+      writes[i].dstSet = _set;
+      writes[i].dstBinding = i;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(_device, 3, writes, 0, nullptr);
+
+    VkPushConstantRange cullRange = {};
+    cullRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    cullRange.offset = 0;
+    cullRange.size = sizeof(CullPushConstants);
+
+    VkPipelineLayoutCreateInfo layoutInfo =
+        vk_abstract::pipeline_layout_create_info();
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &_setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &cullRange;
+    VK_CHECK(
+        vkCreatePipelineLayout(_device, &layoutInfo, nullptr, &_cullLayout));
+
+    VkPushConstantRange drawRange = {};
+    drawRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    drawRange.offset = 0;
+    drawRange.size = sizeof(glm::mat4);
+    layoutInfo.pPushConstantRanges = &drawRange;
+    VK_CHECK(
+        vkCreatePipelineLayout(_device, &layoutInfo, nullptr, &_drawLayout));
+
+    if (!supported()) {
+      spdlog::default_logger()->warn(
+          "The GPU can't draw indirectly, the GPU driven scene is disabled");
+    } else if (!_features._drawIndirectCount) {
+      spdlog::default_logger()->info(
+          "No indirect draw count, the culled objects keep an empty draw");
+    }
+  }
+
+  void GpuScene::cleanup() {
+    vkDestroyPipeline(_device, _cullPipeline, nullptr);
+    vkDestroyPipelineLayout(_device, _drawLayout, nullptr);
+    vkDestroyPipelineLayout(_device, _cullLayout, nullptr);
+    vkDestroyDescriptorPool(_device, _descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(_device, _setLayout, nullptr);
+    _allocator->destroy_buffer(_countBuffer);
+    _allocator->destroy_buffer(_drawBuffer);
+    _allocator->destroy_buffer(_objectBuffer);
+  }
+
+  void GpuScene::create_cull_pipeline(VkShaderModule cullShader,
+                                      VkPipelineCache cache) {
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = nullptr;
+    pipelineInfo.stage = vk_abstract::pipeline_shader_stage_create_info(
+        VK_SHADER_STAGE_COMPUTE_BIT, cullShader);
+    pipelineInfo.layout = _cullLayout;
+
+    if (cullShader == VK_NULL_HANDLE ||
+        vkCreateComputePipelines(_device, cache, 1, &pipelineInfo, nullptr,
+                                 &_cullPipeline) != VK_SUCCESS) {
+      spdlog::default_logger()->error("Failed to create the cull pipeline");
+      _cullPipeline = VK_NULL_HANDLE;
+    }
+  }
+
+  uint32_t GpuScene::add_object(const GpuMesh &mesh, const glm::mat4 &model) {
+    if (_objects.size() >= _maxObjects || !mesh.valid() ||
+        mesh._indexType != _indexType) {
+      return UINT32_MAX;
+    }
+
+    GpuObject object;
+    object._model = model;
+    object._sphere = glm::vec4(mesh._center[0], mesh._center[1],
+                               mesh._center[2], mesh._radius);
+    object._firstIndex = mesh._firstIndex;
+    object._indexCount = mesh._indexCount;
+    object._vertexOffset = mesh._vertexOffset;
+    object._padding = 0;
+    _objects.push_back(object);
+    return (uint32_t)_objects.size() - 1;
+  }
+
+  uint64_t GpuScene::upload() {
+    if (_uploadedObjects == _objects.size()) {
+      return 0;
+    }
+
+    // one copy for every new object
+    VkDeviceSize offset = (VkDeviceSize)_uploadedObjects * sizeof(GpuObject);
+    uint64_t value = _uploads->upload_buffer(
+        _objectBuffer._buffer, offset, _objects.data() + _uploadedObjects,
+        (_objects.size() - _uploadedObjects) * sizeof(GpuObject));
+    _uploadedObjects = (uint32_t)_objects.size();
+    return value;
+  }
+
+  void GpuScene::record_cull(VkCommandBuffer cmd,
+                             const glm::mat4 &viewProjection) const {
+    if (!supported() || _cullPipeline == VK_NULL_HANDLE ||
+        _uploadedObjects == 0) {
+      return;
+    }
+
+    // the previous frame may still read the draws and the count
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    vkCmdFillBuffer(cmd, _countBuffer._buffer, 0, sizeof(uint32_t), 0);
+
+    VkMemoryBarrier clearBarrier = {};
+    clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clearBarrier.pNext = nullptr;
+    clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clearBarrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                         &clearBarrier, 0, nullptr, 0, nullptr);
+
+    CullPushConstants constants;
+    frustum_planes(viewProjection, constants._planes);
+    constants._objectCount = _uploadedObjects;
+    constants._compact = _features._drawIndirectCount ? 1 : 0;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _cullLayout,
+                            0, 1, &_set, 0, nullptr);
+    vkCmdPushConstants(cmd, _cullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(constants), &constants);
+    vkCmdDispatch(cmd,
+                  (_uploadedObjects + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE,
+                  1, 1);
+
+    // the draws are read by the indirect draw of the main pass
+    VkMemoryBarrier cullBarrier = {};
+    cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cullBarrier.pNext = nullptr;
+    cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1,
+                         &cullBarrier, 0, nullptr, 0, nullptr);
+  }
+
+  void GpuScene::draw(DrawList &drawList, VkPipeline pipeline,
+                      const glm::mat4 &viewProjection) const {
+    if (!supported() || _cullPipeline == VK_NULL_HANDLE ||
+        _uploadedObjects == 0) {
+      return;
+    }
+
+    drawList.add_indirect(
+        pipeline, _drawLayout, _set, _meshes->buffer(),
+        _meshes->index_offset(), _indexType, _drawBuffer._buffer,
+        _features._drawIndirectCount ? _countBuffer._buffer : VK_NULL_HANDLE,
+        _uploadedObjects, &viewProjection, sizeof(viewProjection));
+  }
+} // namespace AltE
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "DrawList.hpp"
+#include "GpuAllocator.hpp"
+#include "MeshArena.hpp"
+#include "UploadQueue.hpp"
+#include "vk_types.hpp"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // an object of the scene as read by cull.comp and scene.vert
+  struct GpuObject {
+      glm::mat4 _model;
+      // bounding sphere in model space, center then radius
+      glm::vec4 _sphere;
+      uint32_t _firstIndex;
+      uint32_t _indexCount;
+      int32_t _vertexOffset;
+      uint32_t _padding;
+  };
+
+  static_assert(sizeof(GpuObject) == 96, "GpuObject follows the std430 layout");
+
+  // what the GPU needs to cull and draw the scene on its own
+  struct GpuDrivenFeatures {
+      // several draws per indirect call, each with its own first instance.
+      // Without both the scene isn't drawn
+      bool _multiDrawIndirect = false;
+      bool _drawIndirectFirstInstance = false;
+      // the draw count is read from a buffer, the culled objects then cost
+      // nothing. Without it every object keeps a draw of 0 instances
+      bool _drawIndirectCount = false;
+  };
+
+  // objects living in a storage buffer, culled against the frustum by a
+  // compute shader that writes the indirect draws of the visible ones. The
+  // whole scene is then a single indirect draw, whatever the object count,
+  // so the CPU cost doesn't grow with the scene.
+  //
+  // Every object draws a mesh of the arena with the index type given to
+  // init(), the instance index of a draw is the index of its object.
+  // Only used from the render thread
+  class GpuScene {
+    public:
+      void init(VkDevice device, GpuAllocator &allocator, UploadQueue &uploads,
+                const MeshArena &meshes, const GpuDrivenFeatures &features,
+                uint32_t maxObjects, VkIndexType indexType);
+      void cleanup();
+
+      // cull.comp, compiled here since it isn't a graphics pipeline
+      void create_cull_pipeline(VkShaderModule cullShader,
+                                VkPipelineCache cache);
+
+      // set 0 is the objects, the vertex stage push constants the
+      // view-projection matrix
+      VkPipelineLayout pipeline_layout() const { return _drawLayout; }
+
+      bool supported() const {
+        return _features._multiDrawIndirect &&
+               _features._drawIndirectFirstInstance;
+      }
+
+      // index of the object, UINT32_MAX when the scene is full or the mesh
+      // uses another index type. Visible once upload() has been called
+      uint32_t add_object(const GpuMesh &mesh, const glm::mat4 &model);
+
+      // queues the copy of the objects added since the last call. Returns
+      // the upload timeline value, 0 when nothing was uploaded
+      uint64_t upload();
+
+      uint32_t object_count() const { return (uint32_t)_objects.size(); }
+
+      // culls the objects, must be recorded outside of any render pass and
+      // before the draw it feeds
+      void record_cull(VkCommandBuffer cmd,
+                       const glm::mat4 &viewProjection) const;
+
+      // adds the indirect draw of the visible objects
+      void draw(DrawList &drawList, VkPipeline pipeline,
+                const glm::mat4 &viewProjection) const;
+
+    private:
+      VkDevice _device = VK_NULL_HANDLE;
+      GpuAllocator *_allocator = nullptr;
+      UploadQueue *_uploads = nullptr;
+      const MeshArena *_meshes = nullptr;
+      GpuDrivenFeatures _features;
+      uint32_t _maxObjects = 0;
+      VkIndexType _indexType = VK_INDEX_TYPE_UINT16;
+
+      // objects, one indirect command per object, and the draw count
+      AllocatedBuffer _objectBuffer;
+      AllocatedBuffer _drawBuffer;
+      AllocatedBuffer _countBuffer;
+
+      VkDescriptorSetLayout _setLayout = VK_NULL_HANDLE;
+      VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+      VkDescriptorSet _set = VK_NULL_HANDLE;
+      VkPipelineLayout _cullLayout = VK_NULL_HANDLE;
+      VkPipelineLayout _drawLayout = VK_NULL_HANDLE;
+      VkPipeline _cullPipeline = VK_NULL_HANDLE;
+
+      std::vector<GpuObject> _objects;
+      // the objects after these still have to be uploaded
+      uint32_t _uploadedObjects = 0;
+  };
+} // namespace AltE
@@ -0,0 +1,90 @@
+#include "LinearAllocator.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace {
+  VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+} // namespace
+
+namespace AltE {
+  void LinearAllocator::init(GpuAllocator &allocator,
+                             VkPhysicalDevice physicalDevice,
+                             VkDeviceSize frameSize, uint32_t frameCount,
+                             VkBufferUsageFlags usage) {
+    _allocator = &allocator;
+
+    // the offsets we hand out must be usable as dynamic offsets for any kind
+    // of binding the buffer allows, and flushable when the memory isn't
+    // coherent. All of these limits are powers of two
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    const VkPhysicalDeviceLimits &limits = properties.limits;
+
+    _alignment = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 16);
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+      _alignment =
+          std::max(_alignment, limits.minUniformBufferOffsetAlignment);
+    }
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+      _alignment =
+          std::max(_alignment, limits.minStorageBufferOffsetAlignment);
+    }
+
+    _frameSize = align_up(frameSize, _alignment);
+    _buffer = allocator.create_buffer(_frameSize * frameCount, usage,
+                                      MemoryUsage::Upload);
+    _frameStart = 0;
+    _head = 0;
+
+    SPDLOG_DEBUG(
+        "Linear allocator initialized ({} frames of {} bytes, {} bytes "
+        "alignment)",
+        frameCount, _frameSize, _alignment);
+  }
+
+  void LinearAllocator::cleanup() { _allocator->destroy_buffer(_buffer); }
+
+  void LinearAllocator::begin_frame(uint32_t frameIndex) {
+    _frameStart = frameIndex * _frameSize;
+    _head = 0;
+  }
+
+  void LinearAllocator::flush() {
+    if (_head > 0) {
+      vmaFlushAllocation(_allocator->get(), _buffer._allocation, _frameStart,
+                         _head);
+    }
+  }
+
+  LinearAllocation LinearAllocator::allocate(VkDeviceSize size) {
+    VkDeviceSize offset = _head;
+    VkDeviceSize end = align_up(offset + size, _alignment);
+
+    if (end > _frameSize) {
+      spdlog::default_logger()->error(
+          "Linear allocator out of space ({} bytes requested, {} left)", size,
+          _frameSize - offset);
+      return {};
+    }
+    _head = end;
+
+    LinearAllocation allocation;
+    allocation._buffer = _buffer._buffer;
+    allocation._offset = (uint32_t)(_frameStart + offset);
+    allocation._size = size;
+    allocation._mapped =
+        static_cast<uint8_t *>(_buffer._mapped) + _frameStart + offset;
+    return allocation;
+  }
+
+  VkDescriptorBufferInfo
+  LinearAllocator::descriptor_info(VkDeviceSize range) const {
+    VkDescriptorBufferInfo info = {};
+    info.buffer = _buffer._buffer;
+    info.offset = 0;
+    info.range = range;
+    return info;
+  }
+} // namespace AltE
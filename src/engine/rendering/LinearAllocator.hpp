@@ -0,0 +1,73 @@
+#pragma once
+
+#include "GpuAllocator.hpp"
+#include "vk_types.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // piece of the per-frame buffer handed out by LinearAllocator::allocate()
+  struct LinearAllocation {
+      VkBuffer _buffer = VK_NULL_HANDLE;
+      // offset from the start of the buffer. The whole buffer can be bound
+      // once with a dynamic descriptor, this is then the dynamic offset
+      uint32_t _offset = 0;
+      VkDeviceSize _size = 0;
+      // where to write the data, nullptr when the frame ran out of space
+      void *_mapped = nullptr;
+  };
+
+  // persistently mapped ring with one region per frame in flight. Data for
+  // the frame is bump allocated in the current region, which is rewound when
+  // the fence of the frame that last used it has been signaled
+  class LinearAllocator {
+    public:
+      void init(GpuAllocator &allocator, VkPhysicalDevice physicalDevice,
+                VkDeviceSize frameSize, uint32_t frameCount,
+                VkBufferUsageFlags usage);
+      void cleanup();
+
+      // switches to the region of the given frame and forgets everything
+      // allocated in it. The GPU must be done with that frame
+      void begin_frame(uint32_t frameIndex);
+
+      // makes the writes of the current frame visible to the GPU, to be
+      // called before submitting it
+      void flush();
+
+      LinearAllocation allocate(VkDeviceSize size);
+
+      // copies value into the current frame
+      template <typename T>
+      LinearAllocation push(const T &value) {
+        LinearAllocation allocation = allocate(sizeof(T));
+        if (allocation._mapped != nullptr) {
+          std::memcpy(allocation._mapped, &value, sizeof(T));
+        }
+        return allocation;
+      }
+
+      // the whole buffer, to be written once in a dynamic uniform or storage
+      // buffer descriptor. range is the size seen by the shader
+      VkDescriptorBufferInfo descriptor_info(VkDeviceSize range) const;
+
+      VkBuffer buffer() const { return _buffer._buffer; }
+
+      // bytes of a whole frame region, and bytes left in the current one
+      VkDeviceSize frame_size() const { return _frameSize; }
+      VkDeviceSize available() const { return _frameSize - _head; }
+
+    private:
+      GpuAllocator *_allocator = nullptr;
+      AllocatedBuffer _buffer;
+
+      VkDeviceSize _frameSize = 0;
+      // every allocation starts on a multiple of this
+      VkDeviceSize _alignment = 1;
+
+      // start of the current frame region, and next free byte in it
+      VkDeviceSize _frameStart = 0;
+      VkDeviceSize _head = 0;
+  };
+} // namespace AltE
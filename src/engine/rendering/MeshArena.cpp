@@ -0,0 +1,162 @@
+#include "MeshArena.hpp"
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  VertexInputDescription packed_vertex_description() {
+    using mesh_format::Vertex;
+
+    VertexInputDescription description;
+    description._bindings.push_back(
+        {0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX});
+
+    // location, binding, format, offset
+    description._attributes.push_back(
+        {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)});
+    description._attributes.push_back(
+        {1, 0, VK_FORMAT_R16G16_SNORM, offsetof(Vertex, normal)});
+    description._attributes.push_back(
+        {2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(Vertex, uv)});
+    description._attributes.push_back(
+        {3, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(Vertex, color)});
+    return description;
+  }
+
+  void MeshArena::init(GpuAllocator &allocator, UploadQueue &uploads,
+                       uint32_t vertexCapacity, VkDeviceSize indexCapacity) {
+    _allocator = &allocator;
+    _uploads = &uploads;
+
+    _indexRegionOffset =
+        (VkDeviceSize)vertexCapacity * sizeof(mesh_format::Vertex);
+    uint32_t indexWords = (uint32_t)(indexCapacity / sizeof(uint32_t));
+
+    _buffer = _allocator->create_buffer(
+        _indexRegionOffset + (VkDeviceSize)indexWords * sizeof(uint32_t),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        MemoryUsage::GpuOnly);
+
+    _vertexRanges.init(vertexCapacity);
+    _indexWords.init(indexWords);
+
+    SPDLOG_DEBUG("Mesh arena initialized ({} vertices, {} bytes of indices)",
+                 vertexCapacity, (VkDeviceSize)indexWords * sizeof(uint32_t));
+  }
+
+  void MeshArena::cleanup() {
+    _allocator->destroy_buffer(_buffer);
+  }
+
+  GpuMesh MeshArena::upload(std::span<const mesh_format::Vertex> vertices,
+                            const void *indices, uint32_t indexCount,
+                            uint32_t indexSize, const float center[3],
+                            float radius) {
+    GpuMesh mesh;
+    if (vertices.empty() || indexCount == 0 ||
+        (indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t))) {
+      spdlog::default_logger()->error("Can't upload an empty mesh");
+      return mesh;
+    }
+
+    uint32_t vertexCount = (uint32_t)vertices.size();
+    VkDeviceSize indexBytes = (VkDeviceSize)indexCount * indexSize;
+    uint32_t wordCount =
+        (uint32_t)((indexBytes + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+
+    uint32_t firstVertex = _vertexRanges.allocate(vertexCount);
+    uint32_t firstWord = firstVertex == RangeAllocator::INVALID
+                             ? RangeAllocator::INVALID
+                             : _indexWords.allocate(wordCount);
+    if (firstWord == RangeAllocator::INVALID) {
+      if (firstVertex != RangeAllocator::INVALID) {
+        _vertexRanges.free(firstVertex, vertexCount);
+      }
+      spdlog::default_logger()->error(
+          "Mesh arena is full ({} vertices and {} indices requested)",
+          vertexCount, indexCount);
+      return mesh;
+    }
+
+    VkDeviceSize vertexOffset =
+        (VkDeviceSize)firstVertex * sizeof(mesh_format::Vertex);
+    VkDeviceSize indexOffset =
+        _indexRegionOffset + (VkDeviceSize)firstWord * sizeof(uint32_t);
+
+    _uploads->upload_buffer(_buffer._buffer, vertexOffset, vertices.data(),
+                            vertices.size_bytes());
+    mesh._uploadValue = _uploads->upload_buffer(_buffer._buffer, indexOffset,
+                                                indices, indexBytes);
+
+    mesh._buffer = _buffer._buffer;
+    mesh._indexBufferOffset = _indexRegionOffset;
+    mesh._indexType = indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16
+                                                    : VK_INDEX_TYPE_UINT32;
+    mesh._indexCount = indexCount;
+    mesh._firstIndex = firstWord * (uint32_t)(sizeof(uint32_t) / indexSize);
+    mesh._vertexOffset = (int32_t)firstVertex;
+    mesh._vertexCount = vertexCount;
+    std::memcpy(mesh._center, center, sizeof(mesh._center));
+    mesh._radius = radius;
+    return mesh;
+  }
+
+  GpuMesh MeshArena::load(std::span<const std::byte> data) {
+    using namespace mesh_format;
+
+    Header header;
+    if (data.size() < sizeof(header)) {
+      spdlog::default_logger()->error("Mesh file is too small");
+      return {};
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != MAGIC || header.version != VERSION ||
+        (header.indexSize != sizeof(uint16_t) &&
+         header.indexSize != sizeof(uint32_t))) {
+      spdlog::default_logger()->error("Mesh file has an unknown format");
+      return {};
+    }
+
+    // done in 64 bits, the counts come from the file
+    uint64_t vertexBytes = (uint64_t)header.vertexCount * sizeof(Vertex);
+    uint64_t indexBytes = (uint64_t)header.indexCount * header.indexSize;
+    if (data.size() - sizeof(header) < vertexBytes ||
+        data.size() - sizeof(header) - vertexBytes < indexBytes) {
+      spdlog::default_logger()->error("Mesh file is truncated");
+      return {};
+    }
+
+    // the header is a multiple of 4 bytes, the vertices can be read in place
+    // when the file itself is aligned, which the archive guarantees
+    const std::byte *vertices = data.data() + sizeof(header);
+    if (reinterpret_cast<uintptr_t>(vertices) % alignof(Vertex) != 0) {
+      std::vector<Vertex> copy(header.vertexCount);
+      std::memcpy(copy.data(), vertices, vertexBytes);
+      return upload(copy, vertices + vertexBytes, header.indexCount,
+                    header.indexSize, header.center, header.radius);
+    }
+
+    return upload({reinterpret_cast<const Vertex *>(vertices),
+                   header.vertexCount},
+                  vertices + vertexBytes, header.indexCount, header.indexSize,
+                  header.center, header.radius);
+  }
+
+  void MeshArena::free(const GpuMesh &mesh) {
+    if (!mesh.valid()) {
+      return;
+    }
+
+    uint32_t indexSize =
+        mesh._indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t)
+                                                : sizeof(uint32_t);
+    uint32_t firstWord = mesh._firstIndex / (sizeof(uint32_t) / indexSize);
+    uint32_t wordCount = (uint32_t)(((uint64_t)mesh._indexCount * indexSize +
+                                     sizeof(uint32_t) - 1) /
+                                    sizeof(uint32_t));
+
+    _vertexRanges.free((uint32_t)mesh._vertexOffset, mesh._vertexCount);
+    _indexWords.free(firstWord, wordCount);
+  }
+} // namespace AltE
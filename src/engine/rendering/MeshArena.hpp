@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../assets/MeshFormat.hpp"
+#include "../core/RangeAllocator.hpp"
+#include "GpuAllocator.hpp"
+#include "PipelineBuilder.hpp"
+#include "UploadQueue.hpp"
+#include "vk_types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // mesh_format::Vertex as read by mesh.vert
+  VertexInputDescription packed_vertex_description();
+
+  // a mesh living in the arena, everything needed to draw it
+  struct GpuMesh {
+      VkBuffer _buffer = VK_NULL_HANDLE;
+      // start of the index region, where the index buffer is bound
+      VkDeviceSize _indexBufferOffset = 0;
+      VkIndexType _indexType = VK_INDEX_TYPE_UINT16;
+
+      uint32_t _indexCount = 0;
+      // in indices of _indexType from the start of the index region
+      uint32_t _firstIndex = 0;
+      // first vertex in the vertex buffer, added to every index
+      int32_t _vertexOffset = 0;
+      uint32_t _vertexCount = 0;
+
+      // bounding sphere, in model space
+      float _center[3] = {0.f, 0.f, 0.f};
+      float _radius = 0.f;
+
+      // upload timeline value signaled once the data is on the GPU
+      uint64_t _uploadValue = 0;
+
+      bool valid() const { return _indexCount > 0; }
+  };
+
+  // one large GPU buffer holding the vertices and the indices of every mesh,
+  // so a single vertex buffer and a single index buffer per index type are
+  // bound for the whole frame. The buffer is split in a vertex region,
+  // allocated by vertex, and an index region allocated by 4 bytes words.
+  // Only used from the render thread
+  class MeshArena {
+    public:
+      void init(GpuAllocator &allocator, UploadQueue &uploads,
+                uint32_t vertexCapacity, VkDeviceSize indexCapacity);
+      void cleanup();
+
+      // queues the copy of the mesh into the arena. The returned mesh is
+      // invalid when the arena is full
+      GpuMesh upload(std::span<const mesh_format::Vertex> vertices,
+                     const void *indices, uint32_t indexCount,
+                     uint32_t indexSize, const float center[3], float radius);
+
+      // same from a file written by the mesh-importer tool
+      GpuMesh load(std::span<const std::byte> data);
+
+      // gives the space back, the GPU must be done with the mesh
+      void free(const GpuMesh &mesh);
+
+      VkBuffer buffer() const { return _buffer._buffer; }
+      // where the index buffer is bound, GpuMesh::_firstIndex starts there
+      VkDeviceSize index_offset() const { return _indexRegionOffset; }
+
+    private:
+      GpuAllocator *_allocator = nullptr;
+      UploadQueue *_uploads = nullptr;
+      AllocatedBuffer _buffer;
+
+      // vertex region at the start of the buffer, index region after it
+      VkDeviceSize _indexRegionOffset = 0;
+      RangeAllocator _vertexRanges;
+      RangeAllocator _indexWords;
+  };
+} // namespace AltE
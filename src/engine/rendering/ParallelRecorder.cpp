@@ -0,0 +1,124 @@
+#include "ParallelRecorder.hpp"
+#include "../core/Profiler.hpp"
+#include "vk_abstract.hpp"
+#include "vk_check.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  void ParallelRecorder::init(VkDevice device, uint32_t queueFamily,
+                              JobSystem &jobs, uint32_t frameCount) {
+    _device = device;
+    _jobs = &jobs;
+    _chunkCount = jobs.worker_count() + 1;
+
+    // the pools are reset as a whole, their buffers are never reset one by
+    // one
+    VkCommandPoolCreateInfo poolInfo = vk_abstract::command_pool_create_info(
+        queueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+    _pools.resize(frameCount * _chunkCount);
+    for (ChunkPool &chunkPool : _pools) {
+      VK_CHECK(vkCreateCommandPool(_device, &poolInfo, nullptr,
+                                   &chunkPool._pool));
+      chunkPool._used = 0;
+    }
+
+    SPDLOG_DEBUG("Parallel recorder initialized ({} chunks per frame)",
+                 _chunkCount);
+  }
+
+  void ParallelRecorder::cleanup() {
+    // destroying a pool frees its command buffers
+    for (ChunkPool &chunkPool : _pools) {
+      vkDestroyCommandPool(_device, chunkPool._pool, nullptr);
+    }
+    _pools.clear();
+  }
+
+  void ParallelRecorder::begin_frame(uint32_t frameIndex) {
+    _frameIndex = frameIndex;
+
+    for (uint32_t i = 0; i < _chunkCount; i++) {
+      ChunkPool &chunkPool = _pools[_frameIndex * _chunkCount + i];
+      VK_CHECK(vkResetCommandPool(_device, chunkPool._pool, 0));
+      chunkPool._used = 0;
+    }
+  }
+
+  void ParallelRecorder::record(
+      VkCommandBuffer primary, const DrawList &draws,
+      const VkCommandBufferInheritanceInfo &inheritance,
+      const VkViewport &viewport, const VkRect2D &scissor) {
+    if (draws.empty()) {
+      return;
+    }
+
+    size_t chunks = std::clamp<size_t>(draws.size() / MIN_DRAWS_PER_CHUNK, 1,
+                                       _chunkCount);
+    size_t chunkSize = (draws.size() + chunks - 1) / chunks;
+
+    std::vector<VkCommandBuffer> secondaries(chunks);
+    JobCounter recordings;
+
+    // the workers take every chunk but the first one, which this thread
+    // records while they run
+    for (size_t chunk = 1; chunk < chunks; chunk++) {
+      size_t first = chunk * chunkSize;
+      size_t count = std::min(chunkSize, draws.size() - first);
+
+      _jobs->run(
+          [&, chunk, first, count]() {
+            secondaries[chunk] = record_chunk(chunk, draws, first, count,
+                                              inheritance, viewport, scissor);
+          },
+          &recordings);
+    }
+    secondaries[0] = record_chunk(0, draws, 0,
+                                  std::min(chunkSize, draws.size()),
+                                  inheritance, viewport, scissor);
+
+    // helps with the chunks nobody picked up yet
+    _jobs->wait(recordings);
+
+    // the chunks run in list order, as if they were recorded inline
+    vkCmdExecuteCommands(primary, secondaries.size(), secondaries.data());
+  }
+
+  VkCommandBuffer ParallelRecorder::record_chunk(
+      uint32_t chunk, const DrawList &draws, size_t first, size_t count,
+      const VkCommandBufferInheritanceInfo &inheritance,
+      const VkViewport &viewport, const VkRect2D &scissor) {
+    ALTE_PROFILE_SCOPE("record draws");
+    ChunkPool &chunkPool = _pools[_frameIndex * _chunkCount + chunk];
+
+    if (chunkPool._used == chunkPool._buffers.size()) {
+      VkCommandBufferAllocateInfo allocInfo =
+          vk_abstract::command_buffer_allocate_info(
+              chunkPool._pool, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+      VkCommandBuffer buffer;
+      VK_CHECK(vkAllocateCommandBuffers(_device, &allocInfo, &buffer));
+      chunkPool._buffers.push_back(buffer);
+    }
+    VkCommandBuffer cmd = chunkPool._buffers[chunkPool._used++];
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pNext = nullptr;
+
+    // the commands continue the render pass of the primary
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                      VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+
+    VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    draws.record(cmd, first, count);
+
+    VK_CHECK(vkEndCommandBuffer(cmd));
+    return cmd;
+  }
+} // namespace AltE
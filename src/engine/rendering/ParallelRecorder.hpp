@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../core/JobSystem.hpp"
+#include "DrawList.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // records a draw list on several threads. The list is split in chunks,
+  // each chunk is recorded into a secondary command buffer, and the primary
+  // command buffer executes them in order. Each chunk gets its own command
+  // pool per frame in flight, so the threads never share a pool and a whole
+  // frame can be reset at once
+  class ParallelRecorder {
+    public:
+      // below this many draws a chunk costs more to schedule than to record
+      static constexpr size_t MIN_DRAWS_PER_CHUNK = 512;
+
+      void init(VkDevice device, uint32_t queueFamily, JobSystem &jobs,
+                uint32_t frameCount);
+      void cleanup();
+
+      // resets the pools of a frame slot, its fence must be signaled
+      void begin_frame(uint32_t frameIndex);
+
+      // true when the draws are worth splitting between threads, otherwise
+      // recording them inline is cheaper
+      static bool worth_parallel(size_t drawCount) {
+        return drawCount >= 2 * MIN_DRAWS_PER_CHUNK;
+      }
+
+      // records the draws and executes them into primary. The render pass
+      // must have been begun with secondary command buffers contents.
+      // Dynamic state isn't inherited, so the viewport and the scissor are
+      // set again in every secondary command buffer
+      void record(VkCommandBuffer primary, const DrawList &draws,
+                  const VkCommandBufferInheritanceInfo &inheritance,
+                  const VkViewport &viewport, const VkRect2D &scissor);
+
+    private:
+      // command pool of one chunk for one frame in flight
+      struct ChunkPool {
+          VkCommandPool _pool;
+          // allocated once, reused every time the frame comes back
+          std::vector<VkCommandBuffer> _buffers;
+          size_t _used;
+      };
+
+      VkDevice _device = VK_NULL_HANDLE;
+      JobSystem *_jobs = nullptr;
+
+      // the calling thread records a chunk too
+      uint32_t _chunkCount = 0;
+      uint32_t _frameIndex = 0;
+      // _chunkCount pools per frame in flight
+      std::vector<ChunkPool> _pools;
+
+      VkCommandBuffer record_chunk(
+          uint32_t chunk, const DrawList &draws, size_t first, size_t count,
+          const VkCommandBufferInheritanceInfo &inheritance,
+          const VkViewport &viewport, const VkRect2D &scissor);
+  };
+} // namespace AltE
@@ -1,56 +1,101 @@
 #include "PipelineBuilder.hpp"
+#include "vk_abstract.hpp"
 #include <spdlog/spdlog.h>
 
-VkPipeline
-AltE::PipelineBuilder::build_pipeline(const VkDevice &device,
-                                      const VkRenderPass &renderPass) {
-  // make viewport state from our stored viewport and scissor
+AltE::PipelineCreateInfo::PipelineCreateInfo(
+    const PipelineDescription &description) {
+  // vertex input controls how to read vertices from vertex buffers
+  _vertexInputInfo = vk_abstract::vertex_input_state_create_info();
+  _vertexInputInfo.vertexBindingDescriptionCount =
+      description._vertexInput._bindings.size();
+  _vertexInputInfo.pVertexBindingDescriptions =
+      description._vertexInput._bindings.data();
+  _vertexInputInfo.vertexAttributeDescriptionCount =
+      description._vertexInput._attributes.size();
+  _vertexInputInfo.pVertexAttributeDescriptions =
+      description._vertexInput._attributes.data();
+
+  // one viewport and one scissor, both set when recording the commands so
+  // the pipeline survives swapchain resizes
   // at the moment we won't support multiple viewports or scissors
-  VkPipelineViewportStateCreateInfo viewportState = {};
-  viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-  viewportState.pNext = nullptr;
+  _viewportState = {};
+  _viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  _viewportState.pNext = nullptr;
+
+  _viewportState.viewportCount = 1;
+  _viewportState.pViewports = nullptr;
+  _viewportState.scissorCount = 1;
+  _viewportState.pScissors = nullptr;
 
-  viewportState.viewportCount = 1;
-  viewportState.pViewports = &_viewport;
-  viewportState.scissorCount = 1;
-  viewportState.pScissors = &_scissor;
+  _dynamicStates[0] = VK_DYNAMIC_STATE_VIEWPORT;
+  _dynamicStates[1] = VK_DYNAMIC_STATE_SCISSOR;
+
+  _dynamicState = {};
+  _dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  _dynamicState.pNext = nullptr;
+
+  _dynamicState.dynamicStateCount = 2;
+  _dynamicState.pDynamicStates = _dynamicStates;
 
   // setup dummy color blending. we aren't using transparent objects yet
   // the blending is just "no blend", but we do write to the color attachment
-  VkPipelineColorBlendStateCreateInfo colorBlending = {};
-  colorBlending.sType =
+  _colorBlending = {};
+  _colorBlending.sType =
       VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-  colorBlending.logicOpEnable = VK_FALSE;
+  _colorBlending.pNext = nullptr;
 
-  colorBlending.logicOpEnable = VK_FALSE;
-  colorBlending.logicOp = VK_LOGIC_OP_COPY;
-  colorBlending.attachmentCount = 1;
-  colorBlending.pAttachments = &_colorBlendAttachment;
+  _colorBlending.logicOpEnable = VK_FALSE;
+  _colorBlending.logicOp = VK_LOGIC_OP_COPY;
+  _colorBlending.attachmentCount = 1;
+  _colorBlending.pAttachments = &description._colorBlendAttachment;
 
   // build the actual pipeline
   // we now use all of the info structs we have been writing into this one to
   // create the pipeline
-  VkGraphicsPipelineCreateInfo pipelineInfo = {};
-  pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  pipelineInfo.pNext = nullptr;
-
-  pipelineInfo.stageCount = _shaderStages.size();
-  pipelineInfo.pStages = _shaderStages.data();
-  pipelineInfo.pVertexInputState = &_vertexInputInfo;
-  pipelineInfo.pInputAssemblyState = &_inputAssembly;
-  pipelineInfo.pViewportState = &viewportState;
-  pipelineInfo.pRasterizationState = &_rasterizer;
-  pipelineInfo.pMultisampleState = &_multisampling;
-  pipelineInfo.pColorBlendState = &colorBlending;
-  pipelineInfo.layout = _pipelineLayout;
-  pipelineInfo.renderPass = renderPass;
-  pipelineInfo.subpass = 0;
-  pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+  _info = {};
+  _info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  _info.pNext = nullptr;
+
+  _info.stageCount = description._shaderStages.size();
+  _info.pStages = description._shaderStages.data();
+  _info.pVertexInputState = &_vertexInputInfo;
+  _info.pInputAssemblyState = &description._inputAssembly;
+  _info.pViewportState = &_viewportState;
+  _info.pRasterizationState = &description._rasterizer;
+  _info.pMultisampleState = &description._multisampling;
+  _info.pColorBlendState = &_colorBlending;
+  _info.pDynamicState = &_dynamicState;
+  _info.layout = description._pipelineLayout;
+  _info.renderPass = description._renderPass;
+  _info.subpass = 0;
+  _info.basePipelineHandle = VK_NULL_HANDLE;
+}
+
+AltE::PipelineDescription
+AltE::PipelineBuilder::describe(const VkRenderPass &renderPass) const {
+  PipelineDescription description;
+  description._shaderStages = _shaderStages;
+  description._vertexInput = _vertexInput;
+  description._inputAssembly = _inputAssembly;
+  description._rasterizer = _rasterizer;
+  description._colorBlendAttachment = _colorBlendAttachment;
+  description._multisampling = _multisampling;
+  description._pipelineLayout = _pipelineLayout;
+  description._renderPass = renderPass;
+  return description;
+}
+
+VkPipeline
+AltE::PipelineBuilder::build_pipeline(const VkDevice &device,
+                                      const VkRenderPass &renderPass,
+                                      VkPipelineCache cache) {
+  PipelineDescription description = describe(renderPass);
+  PipelineCreateInfo pipelineInfo(description);
 
   // it's easy to error out on create graphics pipeline, so we handle it a bit
   // better than the common VK_CHECK case
   VkPipeline newPipeline;
-  if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo,
+  if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo._info,
                                 nullptr, &newPipeline) != VK_SUCCESS) {
     spdlog::default_logger()->error("Failed to create pipeline");
     return VK_NULL_HANDLE; // failed to create graphics pipeline
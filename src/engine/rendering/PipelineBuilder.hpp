@@ -4,19 +4,62 @@
 #include <vulkan/vulkan.h>
 
 namespace AltE {
+  // bindings and attributes of a vertex format. Empty for the pipelines
+  // generating their vertices in the shaders
+  struct VertexInputDescription {
+      std::vector<VkVertexInputBindingDescription> _bindings;
+      std::vector<VkVertexInputAttributeDescription> _attributes;
+  };
+
+  // snapshot of everything needed to create a graphics pipeline. It is passed
+  // around by value, so it can be compiled on another thread while the
+  // PipelineBuilder that produced it keeps being modified. The viewport and
+  // the scissor are dynamic, they are set when recording so the pipelines
+  // don't depend on the size of the swapchain
+  struct PipelineDescription {
+      std::vector<VkPipelineShaderStageCreateInfo> _shaderStages;
+      VertexInputDescription _vertexInput;
+      VkPipelineInputAssemblyStateCreateInfo _inputAssembly;
+      VkPipelineRasterizationStateCreateInfo _rasterizer;
+      VkPipelineColorBlendAttachmentState _colorBlendAttachment;
+      VkPipelineMultisampleStateCreateInfo _multisampling;
+      VkPipelineLayout _pipelineLayout;
+      VkRenderPass _renderPass;
+  };
+
+  // create info of a pipeline along with the state it points to. It also
+  // points into the description, so both must outlive the
+  // vkCreateGraphicsPipelines call
+  struct PipelineCreateInfo {
+      VkPipelineVertexInputStateCreateInfo _vertexInputInfo;
+      VkPipelineViewportStateCreateInfo _viewportState;
+      VkPipelineColorBlendStateCreateInfo _colorBlending;
+      VkDynamicState _dynamicStates[2];
+      VkPipelineDynamicStateCreateInfo _dynamicState;
+      VkGraphicsPipelineCreateInfo _info;
+
+      explicit PipelineCreateInfo(const PipelineDescription &description);
+
+      // the create info points to the other members
+      PipelineCreateInfo(const PipelineCreateInfo &) = delete;
+      PipelineCreateInfo &operator=(const PipelineCreateInfo &) = delete;
+  };
+
   class PipelineBuilder {
     public:
       std::vector<VkPipelineShaderStageCreateInfo> _shaderStages;
-      VkPipelineVertexInputStateCreateInfo _vertexInputInfo;
+      VertexInputDescription _vertexInput;
       VkPipelineInputAssemblyStateCreateInfo _inputAssembly;
-      VkViewport _viewport;
-      VkRect2D _scissor;
       VkPipelineRasterizationStateCreateInfo _rasterizer;
       VkPipelineColorBlendAttachmentState _colorBlendAttachment;
       VkPipelineMultisampleStateCreateInfo _multisampling;
       VkPipelineLayout _pipelineLayout;
 
+      // snapshot of the current state, to be compiled later
+      PipelineDescription describe(const VkRenderPass &renderPass) const;
+
       VkPipeline build_pipeline(const VkDevice &device,
-                                const VkRenderPass &renderPass);
+                                const VkRenderPass &renderPass,
+                                VkPipelineCache cache = VK_NULL_HANDLE);
   };
-} // namespace AltE
\ No newline at end of file
+} // namespace AltE
@@ -0,0 +1,203 @@
+#include "PipelineCache.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+namespace {
+  // FNV-1a, enough to detect a truncated or corrupted file
+  uint64_t checksum(const uint8_t *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= data[i];
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+} // namespace
+
+namespace AltE {
+  void PipelineCache::init(VkDevice device, VkPhysicalDevice physicalDevice) {
+    _device = device;
+
+    // the driver UUID changes with every driver update, which invalidates the
+    // compiled pipelines even when the device stays the same
+    VkPhysicalDeviceIDProperties idProperties = {};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+    idProperties.pNext = nullptr;
+
+    VkPhysicalDeviceProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &idProperties;
+
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+    _properties = properties.properties;
+    std::memcpy(_driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+
+    // one file per device, so machines with several GPUs don't keep
+    // overwriting each other's cache
+    char fileName[64];
+    std::snprintf(fileName, sizeof(fileName), "pipelines_%04x_%04x.bin",
+                  _properties.vendorID, _properties.deviceID);
+    _path = cache_directory() / fileName;
+
+    std::vector<uint8_t> data;
+    std::ifstream file(_path, std::ios::binary | std::ios::ate);
+    if (file.is_open()) {
+      size_t fileSize = (size_t)file.tellg();
+      file.seekg(0);
+
+      FileHeader header;
+      if (fileSize >= sizeof(header) &&
+          file.read((char *)&header, sizeof(header))) {
+        data.resize(fileSize - sizeof(header));
+        file.read((char *)data.data(), data.size());
+
+        if (!file || !is_compatible(header, data.data(), data.size())) {
+          spdlog::default_logger()->info(
+              "Pipeline cache {} is outdated, starting from scratch",
+              _path.string());
+          data.clear();
+        }
+      }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.pNext = nullptr;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(_device, &cacheInfo, nullptr, &_cache) !=
+        VK_SUCCESS) {
+      // pipelines can still be built without a cache, just slower
+      spdlog::default_logger()->warn("Failed to create the pipeline cache");
+      _cache = VK_NULL_HANDLE;
+      return;
+    }
+
+    SPDLOG_DEBUG("Pipeline cache initialized ({} bytes loaded from {})",
+                 data.size(), _path.string());
+  }
+
+  void PipelineCache::cleanup() {
+    if (_cache == VK_NULL_HANDLE) {
+      return;
+    }
+
+    save();
+
+    vkDestroyPipelineCache(_device, _cache, nullptr);
+    _cache = VK_NULL_HANDLE;
+  }
+
+  std::filesystem::path PipelineCache::cache_directory() {
+#ifdef _WIN32
+    if (const char *localAppData = std::getenv("LOCALAPPDATA")) {
+      return std::filesystem::path(localAppData) / "alternative-engine";
+    }
+#else
+    if (const char *xdgCache = std::getenv("XDG_CACHE_HOME")) {
+      if (xdgCache[0] != '\0') {
+        return std::filesystem::path(xdgCache) / "alternative-engine";
+      }
+    }
+    if (const char *home = std::getenv("HOME")) {
+      return std::filesystem::path(home) / ".cache" / "alternative-engine";
+    }
+#endif
+    // nowhere better to go, keep it next to the working directory
+    return std::filesystem::path(".cache");
+  }
+
+  bool PipelineCache::is_compatible(const FileHeader &header,
+                                    const uint8_t *data, size_t size) const {
+    if (header.magic != MAGIC || header.version != VERSION ||
+        header.vendorID != _properties.vendorID ||
+        header.deviceID != _properties.deviceID ||
+        std::memcmp(header.driverUUID, _driverUUID, VK_UUID_SIZE) != 0 ||
+        header.dataSize != size || header.checksum != checksum(data, size)) {
+      return false;
+    }
+
+    // also check the header the driver wrote at the start of its own blob
+    VkPipelineCacheHeaderVersionOne vkHeader;
+    if (size < sizeof(vkHeader)) {
+      return false;
+    }
+    std::memcpy(&vkHeader, data, sizeof(vkHeader));
+
+    return vkHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           vkHeader.vendorID == _properties.vendorID &&
+           vkHeader.deviceID == _properties.deviceID &&
+           std::memcmp(vkHeader.pipelineCacheUUID,
+                       _properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+  }
+
+  void PipelineCache::save() {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(_device, _cache, &size, nullptr) !=
+        VK_SUCCESS) {
+      spdlog::default_logger()->warn("Failed to read the pipeline cache");
+      return;
+    }
+
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(_device, _cache, &size, data.data()) !=
+        VK_SUCCESS) {
+      spdlog::default_logger()->warn("Failed to read the pipeline cache");
+      return;
+    }
+    data.resize(size);
+
+    FileHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vendorID = _properties.vendorID;
+    header.deviceID = _properties.deviceID;
+    std::memcpy(header.driverUUID, _driverUUID, VK_UUID_SIZE);
+    header.dataSize = data.size();
+    header.checksum = checksum(data.data(), data.size());
+
+    std::error_code error;
+    std::filesystem::create_directories(_path.parent_path(), error);
+    if (error) {
+      spdlog::default_logger()->warn("Can't create the cache directory {}: {}",
+                                     _path.parent_path().string(),
+                                     error.message());
+      return;
+    }
+
+    // write everything to a temporary file first, then rename it over the
+    // previous cache, so a crash while saving never leaves a half written
+    // cache behind
+    std::filesystem::path tmpPath = _path;
+    tmpPath += ".tmp";
+    {
+      std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+      file.write((const char *)&header, sizeof(header));
+      file.write((const char *)data.data(), data.size());
+      file.flush();
+
+      if (!file) {
+        spdlog::default_logger()->warn("Failed to write {}", tmpPath.string());
+        file.close();
+        std::filesystem::remove(tmpPath, error);
+        return;
+      }
+    }
+
+    std::filesystem::rename(tmpPath, _path, error);
+    if (error) {
+      spdlog::default_logger()->warn("Failed to replace {}: {}",
+                                     _path.string(), error.message());
+      std::filesystem::remove(tmpPath, error);
+      return;
+    }
+
+    SPDLOG_DEBUG("Pipeline cache saved ({} bytes to {})", data.size(),
+                 _path.string());
+  }
+} // namespace AltE
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // VkPipelineCache persisted in the user cache directory, so pipelines
+  // compiled during a run don't have to be compiled again on the next launch
+  class PipelineCache {
+    public:
+      // loads the blob saved for this device if it is still valid, otherwise
+      // starts from an empty cache
+      void init(VkDevice device, VkPhysicalDevice physicalDevice);
+
+      // writes the cache back to disk and destroys it
+      void cleanup();
+
+      // cache to pass to every vkCreate*Pipelines call
+      VkPipelineCache get() const { return _cache; }
+
+    private:
+      // header written before the Vulkan blob, identifies the driver that
+      // produced it
+      struct FileHeader {
+          uint32_t magic;
+          uint32_t version;
+          uint32_t vendorID;
+          uint32_t deviceID;
+          uint8_t driverUUID[VK_UUID_SIZE];
+          uint64_t dataSize;
+          uint64_t checksum;
+      };
+
+      static constexpr uint32_t MAGIC = 0x43504c41; // "ALPC"
+      static constexpr uint32_t VERSION = 1;
+
+      VkDevice _device = VK_NULL_HANDLE;
+      VkPipelineCache _cache = VK_NULL_HANDLE;
+
+      VkPhysicalDeviceProperties _properties;
+      uint8_t _driverUUID[VK_UUID_SIZE];
+
+      std::filesystem::path _path;
+
+      // directory where the cache files of the engine are stored
+      static std::filesystem::path cache_directory();
+
+      bool is_compatible(const FileHeader &header, const uint8_t *data,
+                         size_t size) const;
+      void save();
+  };
+} // namespace AltE
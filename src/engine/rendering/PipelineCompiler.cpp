@@ -0,0 +1,85 @@
+#include "PipelineCompiler.hpp"
+#include <algorithm>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  void PipelineCompiler::init(VkDevice device, VkPipelineCache cache,
+                              JobSystem &jobs) {
+    _device = device;
+    _cache = cache;
+    _jobs = &jobs;
+  }
+
+  std::future<VkPipeline>
+  PipelineCompiler::compile(PipelineDescription description) {
+    std::vector<PipelineDescription> descriptions;
+    descriptions.push_back(std::move(description));
+    return std::move(compile_batch(std::move(descriptions), 1).front());
+  }
+
+  std::vector<std::future<VkPipeline>>
+  PipelineCompiler::compile_batch(std::vector<PipelineDescription> descriptions,
+                                  size_t batchSize) {
+    if (batchSize == 0) {
+      size_t workers = std::max(_jobs->worker_count(), 1u);
+      batchSize = std::max<size_t>(
+          (descriptions.size() + workers - 1) / workers, 1);
+    }
+
+    // every batch owns its descriptions and promises, the caller doesn't need
+    // to keep anything alive
+    struct Batch {
+        std::vector<PipelineDescription> descriptions;
+        std::vector<std::promise<VkPipeline>> promises;
+    };
+
+    std::vector<std::future<VkPipeline>> futures;
+    futures.reserve(descriptions.size());
+
+    for (size_t first = 0; first < descriptions.size(); first += batchSize) {
+      size_t last = std::min(first + batchSize, descriptions.size());
+
+      auto batch = std::make_shared<Batch>();
+      batch->descriptions.assign(
+          std::make_move_iterator(descriptions.begin() + first),
+          std::make_move_iterator(descriptions.begin() + last));
+      batch->promises.resize(last - first);
+
+      for (std::promise<VkPipeline> &promise : batch->promises) {
+        futures.push_back(promise.get_future());
+      }
+
+      _jobs->run([this, batch]() {
+        size_t count = batch->descriptions.size();
+
+        // the create infos point into the descriptions, which don't move
+        // anymore
+        std::vector<std::unique_ptr<PipelineCreateInfo>> createInfos;
+        std::vector<VkGraphicsPipelineCreateInfo> infos;
+        createInfos.reserve(count);
+        infos.reserve(count);
+        for (const PipelineDescription &description : batch->descriptions) {
+          createInfos.push_back(
+              std::make_unique<PipelineCreateInfo>(description));
+          infos.push_back(createInfos.back()->_info);
+        }
+
+        // pipelines that failed to compile are left to VK_NULL_HANDLE
+        std::vector<VkPipeline> pipelines(count, VK_NULL_HANDLE);
+        VkResult result = vkCreateGraphicsPipelines(
+            _device, _cache, count, infos.data(), nullptr, pipelines.data());
+        if (result != VK_SUCCESS) {
+          spdlog::default_logger()->error(
+              "Failed to create a batch of {} pipelines: {}", count, result);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+          batch->promises[i].set_value(pipelines[i]);
+        }
+      });
+    }
+
+    return futures;
+  }
+} // namespace AltE
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../core/JobSystem.hpp"
+#include "PipelineBuilder.hpp"
+#include <future>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // compiles pipeline descriptions on the worker threads. The pipelines are
+  // handed back through futures, a VK_NULL_HANDLE result means the
+  // compilation failed
+  class PipelineCompiler {
+    public:
+      void init(VkDevice device, VkPipelineCache cache, JobSystem &jobs);
+
+      // compiles a single pipeline
+      std::future<VkPipeline> compile(PipelineDescription description);
+
+      // compiles every description, grouping them in batches of batchSize
+      // pipelines created with a single vkCreateGraphicsPipelines call. A
+      // batchSize of 0 splits the work evenly across the workers
+      std::vector<std::future<VkPipeline>>
+      compile_batch(std::vector<PipelineDescription> descriptions,
+                    size_t batchSize = 0);
+
+    private:
+      VkDevice _device = VK_NULL_HANDLE;
+      // the cache is internally synchronized, every worker can use it
+      VkPipelineCache _cache = VK_NULL_HANDLE;
+      JobSystem *_jobs = nullptr;
+  };
+} // namespace AltE
@@ -0,0 +1,742 @@
+#include "RenderGraph.hpp"
+#include "vk_check.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <spdlog/spdlog.h>
+
+namespace {
+  // every stage a pass of the graph reads or writes an image in
+  constexpr VkPipelineStageFlags GRAPH_STAGES =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+  constexpr VkAccessFlags WRITE_ACCESS =
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+  bool is_depth_format(VkFormat format) {
+    switch (format) {
+      case VK_FORMAT_D16_UNORM:
+      case VK_FORMAT_X8_D24_UNORM_PACK32:
+      case VK_FORMAT_D32_SFLOAT:
+      case VK_FORMAT_D16_UNORM_S8_UINT:
+      case VK_FORMAT_D24_UNORM_S8_UINT:
+      case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  VkImageAspectFlags aspect_mask(VkFormat format) {
+    switch (format) {
+      case VK_FORMAT_D16_UNORM_S8_UINT:
+      case VK_FORMAT_D24_UNORM_S8_UINT:
+      case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+      default:
+        return is_depth_format(format) ? VK_IMAGE_ASPECT_DEPTH_BIT
+                                       : VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+  }
+
+  // how the image is used once it reaches its final layout
+  void final_dependency(VkImageLayout layout, VkPipelineStageFlags &stage,
+                        VkAccessFlags &access) {
+    switch (layout) {
+      case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+        // the present waits on a semaphore, which covers the memory
+        stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        access = 0;
+        break;
+      case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        access = VK_ACCESS_TRANSFER_READ_BIT;
+        break;
+      case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        access = VK_ACCESS_SHADER_READ_BIT;
+        break;
+      default:
+        stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        access = VK_ACCESS_MEMORY_READ_BIT;
+        break;
+    }
+  }
+} // namespace
+
+namespace AltE {
+  void RenderGraph::init(VkDevice device, GpuAllocator &allocator) {
+    _device = device;
+    _allocator = &allocator;
+  }
+
+  void RenderGraph::cleanup() {
+    for (Pass &pass : _passes) {
+      for (VkFramebuffer framebuffer : pass._framebuffers) {
+        vkDestroyFramebuffer(_device, framebuffer, nullptr);
+      }
+      pass._framebuffers.clear();
+
+      if (pass._renderPass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(_device, pass._renderPass, nullptr);
+        pass._renderPass = VK_NULL_HANDLE;
+      }
+    }
+
+    for (Image &image : _images) {
+      if (!image._imported) {
+        for (VkImageView view : image._views) {
+          vkDestroyImageView(_device, view, nullptr);
+        }
+        for (VkImage handle : image._images) {
+          vkDestroyImage(_device, handle, nullptr);
+        }
+      }
+      image._views.clear();
+      image._images.clear();
+    }
+
+    for (VmaAllocation memory : _memory) {
+      _allocator->free_memory(memory);
+    }
+    _memory.clear();
+  }
+
+  RenderImage RenderGraph::import_image(const char *name, VkFormat format,
+                                        VkImageLayout finalLayout) {
+    Image image = {};
+    image._name = name;
+    image._format = format;
+    image._imported = true;
+    image._scale = 1.f;
+    image._finalLayout = finalLayout;
+    _images.push_back(std::move(image));
+    return (RenderImage)(_images.size() - 1);
+  }
+
+  RenderImage RenderGraph::create_image(const char *name, VkFormat format,
+                                        float scale) {
+    Image image = {};
+    image._name = name;
+    image._format = format;
+    image._imported = false;
+    image._scale = scale;
+    image._finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    _images.push_back(std::move(image));
+    return (RenderImage)(_images.size() - 1);
+  }
+
+  RenderPassId RenderGraph::add_pass(const char *name,
+                                     RenderPassExecute execute) {
+    Pass pass = {};
+    pass._name = name;
+    pass._execute = std::move(execute);
+    pass._hasDepth = false;
+    pass._contents = VK_SUBPASS_CONTENTS_INLINE;
+    pass._culled = false;
+    pass._renderPass = VK_NULL_HANDLE;
+    _passes.push_back(std::move(pass));
+    return (RenderPassId)(_passes.size() - 1);
+  }
+
+  void RenderGraph::write_color(RenderPassId pass, RenderImage image,
+                                bool clear) {
+    _passes[pass]._colorWrites.push_back({image, clear});
+    _images[image]._usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  }
+
+  void RenderGraph::write_depth(RenderPassId pass, RenderImage image,
+                                bool clear) {
+    if (!is_depth_format(_images[image]._format)) {
+      spdlog::default_logger()->error(
+          "Render graph: {} isn't a depth image, pass {} can't use it",
+          _images[image]._name, _passes[pass]._name);
+      return;
+    }
+    _passes[pass]._hasDepth = true;
+    _passes[pass]._depthWrite = {image, clear};
+    _images[image]._usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  }
+
+  void RenderGraph::read_image(RenderPassId pass, RenderImage image) {
+    _passes[pass]._reads.push_back(image);
+    _images[image]._usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+  }
+
+  void RenderGraph::compile() {
+    cull();
+    plan_barriers();
+
+    for (Pass &pass : _passes) {
+      if (!pass._culled) {
+        create_render_pass(pass);
+      }
+    }
+
+    SPDLOG_DEBUG(
+        "Render graph compiled ({} passes, {} culled, {} images)",
+        _passes.size(),
+        std::count_if(_passes.begin(), _passes.end(),
+                      [](const Pass &pass) { return pass._culled; }),
+        _images.size());
+  }
+
+  void RenderGraph::cull() {
+    // walk the passes backwards, keeping those writing an image that is
+    // needed afterwards. The imported images are the outputs of the frame
+    std::vector<bool> needed(_images.size());
+    for (size_t i = 0; i < _images.size(); i++) {
+      needed[i] = _images[i]._imported;
+    }
+
+    for (size_t i = _passes.size(); i-- > 0;) {
+      Pass &pass = _passes[i];
+      std::vector<Attachment> written = attachments(pass);
+
+      pass._culled = std::none_of(
+          written.begin(), written.end(),
+          [&](const Attachment &write) { return needed[write._image]; });
+      if (pass._culled) {
+        SPDLOG_DEBUG(
+            "Render graph: pass {} culled, nothing uses what it writes",
+            pass._name);
+        continue;
+      }
+
+      for (const Attachment &write : written) {
+        // a pass loading an image builds on the passes before it, a clear
+        // makes them useless unless something reads the image in between
+        if (write._clear) {
+          needed[write._image] = _images[write._image]._imported;
+        } else {
+          needed[write._image] = true;
+        }
+      }
+      for (RenderImage read : pass._reads) {
+        needed[read] = true;
+      }
+    }
+  }
+
+  void RenderGraph::plan_barriers() {
+    // where each image is left by the passes recorded so far
+    struct State {
+        VkImageLayout _layout;
+        VkPipelineStageFlags _stage;
+        VkAccessFlags _access;
+    };
+    std::vector<State> states(_images.size());
+
+    for (Image &image : _images) {
+      image._firstUse = -1;
+      image._lastUse = -1;
+    }
+    _finalTransitions.clear();
+
+    auto use = [&](Pass &pass, int index, RenderImage id, VkImageLayout layout,
+                   VkPipelineStageFlags stage, VkAccessFlags access) {
+      Image &image = _images[id];
+      State &state = states[id];
+
+      if (image._firstUse < 0) {
+        // the content of the previous frame is dropped. The memory may have
+        // been written by the previous frame or by an aliased image, so wait
+        // for every write the graph could have done
+        image._firstUse = index;
+        pass._transitions.push_back({id, VK_IMAGE_LAYOUT_UNDEFINED, layout,
+                                     GRAPH_STAGES, stage, WRITE_ACCESS,
+                                     access});
+      } else if (state._layout != layout || (state._access & WRITE_ACCESS) ||
+                 (access & WRITE_ACCESS)) {
+        // only two reads in the same layout don't need anything between
+        pass._transitions.push_back({id, state._layout, layout, state._stage,
+                                     stage, state._access & WRITE_ACCESS,
+                                     access});
+      }
+
+      image._lastUse = index;
+      state = {layout, stage, access};
+    };
+
+    for (size_t i = 0; i < _passes.size(); i++) {
+      Pass &pass = _passes[i];
+      pass._transitions.clear();
+      pass._loadOps.clear();
+      pass._storeOps.clear();
+      if (pass._culled) {
+        continue;
+      }
+
+      for (RenderImage read : pass._reads) {
+        if (_images[read]._firstUse < 0) {
+          spdlog::default_logger()->warn(
+              "Render graph: pass {} reads {} before anything wrote it",
+              pass._name, _images[read]._name);
+        }
+        use(pass, (int)i, read, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+      }
+
+      for (const Attachment &write : attachments(pass)) {
+        bool firstWrite = _images[write._image]._firstUse < 0;
+        VkAttachmentLoadOp loadOp;
+        if (write._clear) {
+          loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        } else if (firstWrite) {
+          // nothing to keep from the previous frame
+          loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        } else {
+          loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        }
+        pass._loadOps.push_back(loadOp);
+
+        bool loads = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+        if (is_depth_format(_images[write._image]._format)) {
+          use(pass, (int)i, write._image,
+              VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                  VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+              VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+        } else {
+          use(pass, (int)i, write._image,
+              VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+              VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+              VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                  (loads ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0));
+        }
+      }
+    }
+
+    // now that the lifetimes are known, only store what is used later
+    for (size_t i = 0; i < _passes.size(); i++) {
+      Pass &pass = _passes[i];
+      if (pass._culled) {
+        continue;
+      }
+      for (const Attachment &write : attachments(pass)) {
+        const Image &image = _images[write._image];
+        pass._storeOps.push_back(image._imported || image._lastUse > (int)i
+                                     ? VK_ATTACHMENT_STORE_OP_STORE
+                                     : VK_ATTACHMENT_STORE_OP_DONT_CARE);
+      }
+    }
+
+    for (size_t i = 0; i < _images.size(); i++) {
+      const Image &image = _images[i];
+      if (!image._imported) {
+        continue;
+      }
+      if (image._firstUse < 0) {
+        spdlog::default_logger()->warn("Render graph: nothing writes {}",
+                                       image._name);
+        continue;
+      }
+
+      const State &state = states[i];
+      VkPipelineStageFlags stage;
+      VkAccessFlags access;
+      final_dependency(image._finalLayout, stage, access);
+      _finalTransitions.push_back({(RenderImage)i, state._layout,
+                                   image._finalLayout, state._stage, stage,
+                                   state._access & WRITE_ACCESS, access});
+    }
+  }
+
+  void RenderGraph::create_render_pass(Pass &pass) {
+    std::vector<Attachment> written = attachments(pass);
+
+    std::vector<VkAttachmentDescription> descriptions(written.size());
+    std::vector<VkAttachmentReference> colorReferences;
+    VkAttachmentReference depthReference = {};
+
+    for (size_t i = 0; i < written.size(); i++) {
+      VkFormat format = _images[written[i]._image]._format;
+      bool depth = is_depth_format(format);
+      // the barriers recorded before the pass already put the image in the
+      // right layout, the render pass doesn't transition anything
+      VkImageLayout layout =
+          depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+                : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+      VkAttachmentDescription &description = descriptions[i];
+      description.format = format;
+      description.samples = VK_SAMPLE_COUNT_1_BIT;
+      description.loadOp = pass._loadOps[i];
+      description.storeOp = pass._storeOps[i];
+      description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+      description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+      description.initialLayout = layout;
+      description.finalLayout = layout;
+
+      if (depth) {
+        depthReference = {(uint32_t)i, layout};
+      } else {
+        colorReferences.push_back({(uint32_t)i, layout});
+      }
+    }
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = (uint32_t)colorReferences.size();
+    subpass.pColorAttachments = colorReferences.data();
+    subpass.pDepthStencilAttachment =
+        pass._hasDepth ? &depthReference : nullptr;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.pNext = nullptr;
+    renderPassInfo.attachmentCount = (uint32_t)descriptions.size();
+    renderPassInfo.pAttachments = descriptions.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    VK_CHECK(vkCreateRenderPass(_device, &renderPassInfo, nullptr,
+                                &pass._renderPass));
+  }
+
+  VkRenderPass RenderGraph::render_pass(RenderPassId pass) const {
+    return _passes[pass]._renderPass;
+  }
+
+  bool RenderGraph::is_culled(RenderPassId pass) const {
+    return _passes[pass]._culled;
+  }
+
+  void RenderGraph::set_imported(RenderImage image,
+                                 std::vector<VkImage> images,
+                                 std::vector<VkImageView> views) {
+    _images[image]._images = std::move(images);
+    _images[image]._views = std::move(views);
+  }
+
+  void RenderGraph::create_resources(VkExtent2D extent) {
+    _extent = extent;
+
+    create_transient_images();
+    for (Pass &pass : _passes) {
+      if (!pass._culled) {
+        create_framebuffers(pass);
+      }
+    }
+  }
+
+  void RenderGraph::create_transient_images() {
+    std::vector<RenderImage> transients;
+    std::vector<VkMemoryRequirements> requirements(_images.size());
+
+    for (size_t i = 0; i < _images.size(); i++) {
+      Image &image = _images[i];
+      if (image._imported || image._firstUse < 0) {
+        continue;
+      }
+
+      VkExtent2D extent = image_extent((RenderImage)i);
+
+      VkImageCreateInfo imageInfo = {};
+      imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+      imageInfo.pNext = nullptr;
+      imageInfo.imageType = VK_IMAGE_TYPE_2D;
+      imageInfo.format = image._format;
+      imageInfo.extent = {extent.width, extent.height, 1};
+      imageInfo.mipLevels = 1;
+      imageInfo.arrayLayers = 1;
+      imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+      imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+      imageInfo.usage = image._usage;
+      imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+      VkImage handle;
+      VK_CHECK(vkCreateImage(_device, &imageInfo, nullptr, &handle));
+      image._images = {handle};
+
+      vkGetImageMemoryRequirements(_device, handle, &requirements[i]);
+      transients.push_back((RenderImage)i);
+    }
+
+    // biggest first, so the small images fit in the memory of the big ones
+    std::sort(transients.begin(), transients.end(),
+              [&](RenderImage a, RenderImage b) {
+                return requirements[a].size > requirements[b].size;
+              });
+
+    // images whose lifetimes don't overlap can live in the same memory, the
+    // barrier of their first use waits for the previous one to be done
+    struct Block {
+        VkMemoryRequirements _requirements;
+        std::vector<RenderImage> _images;
+    };
+    std::vector<Block> blocks;
+    VkDeviceSize unaliasedSize = 0;
+
+    for (RenderImage id : transients) {
+      const VkMemoryRequirements &needs = requirements[id];
+      const Image &image = _images[id];
+      unaliasedSize += needs.size;
+
+      auto fits = [&](const Block &block) {
+        if ((block._requirements.memoryTypeBits & needs.memoryTypeBits) ==
+            0) {
+          return false;
+        }
+        return std::none_of(
+            block._images.begin(), block._images.end(), [&](RenderImage other) {
+              return image._firstUse <= _images[other]._lastUse &&
+                     _images[other]._firstUse <= image._lastUse;
+            });
+      };
+
+      auto block = std::find_if(blocks.begin(), blocks.end(), fits);
+      if (block == blocks.end()) {
+        blocks.push_back({needs, {id}});
+        continue;
+      }
+
+      VkMemoryRequirements &shared = block->_requirements;
+      shared.size = std::max(shared.size, needs.size);
+      shared.alignment = std::max(shared.alignment, needs.alignment);
+      shared.memoryTypeBits &= needs.memoryTypeBits;
+      block->_images.push_back(id);
+    }
+
+    VkDeviceSize aliasedSize = 0;
+    for (const Block &block : blocks) {
+      VmaAllocation memory = _allocator->allocate_memory(block._requirements);
+      _memory.push_back(memory);
+      aliasedSize += block._requirements.size;
+
+      for (RenderImage id : block._images) {
+        Image &image = _images[id];
+        _allocator->bind_image_memory(memory, image._images[0]);
+
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.pNext = nullptr;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.image = image._images[0];
+        viewInfo.format = image._format;
+        viewInfo.subresourceRange.aspectMask = aspect_mask(image._format);
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        VkImageView view;
+        VK_CHECK(vkCreateImageView(_device, &viewInfo, nullptr, &view));
+        image._views = {view};
+      }
+    }
+
+    if (!transients.empty()) {
+      SPDLOG_DEBUG(
+          "Render graph: {} transient images in {} allocations, {} bytes "
+          "instead of {}",
+          transients.size(), blocks.size(), aliasedSize, unaliasedSize);
+    }
+  }
+
+  void RenderGraph::create_framebuffers(Pass &pass) {
+    std::vector<Attachment> written = attachments(pass);
+
+    // one framebuffer per variant of the imported images it renders to
+    uint32_t variantCount = 1;
+    for (const Attachment &write : written) {
+      const Image &image = _images[write._image];
+      if (image._imported) {
+        variantCount = std::max(variantCount, (uint32_t)image._views.size());
+      }
+    }
+
+    pass._extent = written.empty() ? _extent : image_extent(written[0]._image);
+
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.pNext = nullptr;
+    framebufferInfo.renderPass = pass._renderPass;
+    framebufferInfo.attachmentCount = (uint32_t)written.size();
+    framebufferInfo.width = pass._extent.width;
+    framebufferInfo.height = pass._extent.height;
+    framebufferInfo.layers = 1;
+
+    std::vector<VkImageView> views(written.size());
+    pass._framebuffers.resize(variantCount);
+    for (uint32_t variant = 0; variant < variantCount; variant++) {
+      for (size_t i = 0; i < written.size(); i++) {
+        views[i] = view_handle(written[i]._image, variant);
+      }
+      framebufferInfo.pAttachments = views.data();
+      VK_CHECK(vkCreateFramebuffer(_device, &framebufferInfo, nullptr,
+                                   &pass._framebuffers[variant]));
+    }
+  }
+
+  void RenderGraph::retire_resources(DeletionQueue &queue, uint64_t frame) {
+    for (Pass &pass : _passes) {
+      for (VkFramebuffer framebuffer : pass._framebuffers) {
+        queue.retire(frame, DeletionType::Framebuffer, framebuffer);
+      }
+      pass._framebuffers.clear();
+    }
+
+    for (Image &image : _images) {
+      if (!image._imported) {
+        for (VkImageView view : image._views) {
+          queue.retire(frame, DeletionType::ImageView, view);
+        }
+        // the memory isn't owned by the image, it goes right after
+        for (VkImage handle : image._images) {
+          queue.retire(frame, DeletionType::Image, handle);
+        }
+      }
+      image._views.clear();
+      image._images.clear();
+    }
+
+    for (VmaAllocation memory : _memory) {
+      queue.retire(frame, DeletionType::Allocation, memory);
+    }
+    _memory.clear();
+  }
+
+  VkImageView RenderGraph::image_view(RenderImage image) const {
+    return view_handle(image, 0);
+  }
+
+  void RenderGraph::set_clear_value(RenderImage image, VkClearValue value) {
+    _images[image]._clearValue = value;
+  }
+
+  void RenderGraph::set_contents(RenderPassId pass,
+                                 VkSubpassContents contents) {
+    _passes[pass]._contents = contents;
+  }
+
+  void RenderGraph::execute(VkCommandBuffer cmd, uint32_t variant,
+                            GpuProfiler *profiler) {
+    std::vector<VkClearValue> clearValues;
+
+    for (Pass &pass : _passes) {
+      if (pass._culled) {
+        continue;
+      }
+
+      if (profiler != nullptr) {
+        profiler->begin_zone(cmd, pass._name.c_str());
+      }
+
+      record_transitions(cmd, pass._transitions, variant);
+
+      std::vector<Attachment> written = attachments(pass);
+      clearValues.resize(written.size());
+      for (size_t i = 0; i < written.size(); i++) {
+        clearValues[i] = _images[written[i]._image]._clearValue;
+      }
+
+      VkFramebuffer framebuffer =
+          pass._framebuffers[pass._framebuffers.size() == 1 ? 0 : variant];
+
+      VkRenderPassBeginInfo beginInfo = {};
+      beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+      beginInfo.pNext = nullptr;
+      beginInfo.renderPass = pass._renderPass;
+      beginInfo.framebuffer = framebuffer;
+      beginInfo.renderArea.offset = {0, 0};
+      beginInfo.renderArea.extent = pass._extent;
+      beginInfo.clearValueCount = (uint32_t)clearValues.size();
+      beginInfo.pClearValues = clearValues.data();
+
+      vkCmdBeginRenderPass(cmd, &beginInfo, pass._contents);
+
+      RenderPassContext context = {pass._renderPass, framebuffer,
+                                   pass._extent, pass._contents};
+      pass._execute(cmd, context);
+
+      vkCmdEndRenderPass(cmd);
+
+      if (profiler != nullptr) {
+        profiler->end_zone(cmd);
+      }
+    }
+
+    record_transitions(cmd, _finalTransitions, variant);
+  }
+
+  void RenderGraph::record_transitions(
+      VkCommandBuffer cmd, const std::vector<Transition> &transitions,
+      uint32_t variant) {
+    if (transitions.empty()) {
+      return;
+    }
+
+    VkPipelineStageFlags srcStage = 0;
+    VkPipelineStageFlags dstStage = 0;
+    VkImageMemoryBarrier barriers[16];
+    uint32_t count = 0;
+
+    for (const Transition &transition : transitions) {
+      if (count == std::size(barriers)) {
+        vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0,
+                             nullptr, count, barriers);
+        srcStage = 0;
+        dstStage = 0;
+        count = 0;
+      }
+
+      const Image &image = _images[transition._image];
+
+      VkImageMemoryBarrier &barrier = barriers[count++];
+      barrier = {};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.pNext = nullptr;
+      barrier.srcAccessMask = transition._srcAccess;
+      barrier.dstAccessMask = transition._dstAccess;
+      barrier.oldLayout = transition._oldLayout;
+      barrier.newLayout = transition._newLayout;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = image_handle(transition._image, variant);
+      barrier.subresourceRange.aspectMask = aspect_mask(image._format);
+      barrier.subresourceRange.baseMipLevel = 0;
+      barrier.subresourceRange.levelCount = 1;
+      barrier.subresourceRange.baseArrayLayer = 0;
+      barrier.subresourceRange.layerCount = 1;
+
+      srcStage |= transition._srcStage;
+      dstStage |= transition._dstStage;
+    }
+
+    vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr,
+                         count, barriers);
+  }
+
+  std::vector<RenderGraph::Attachment>
+  RenderGraph::attachments(const Pass &pass) {
+    std::vector<Attachment> written = pass._colorWrites;
+    if (pass._hasDepth) {
+      written.push_back(pass._depthWrite);
+    }
+    return written;
+  }
+
+  VkImage RenderGraph::image_handle(RenderImage image,
+                                    uint32_t variant) const {
+    const Image &resource = _images[image];
+    return resource._images[resource._imported ? variant : 0];
+  }
+
+  VkImageView RenderGraph::view_handle(RenderImage image,
+                                       uint32_t variant) const {
+    const Image &resource = _images[image];
+    return resource._views[resource._imported ? variant : 0];
+  }
+
+  VkExtent2D RenderGraph::image_extent(RenderImage image) const {
+    float scale = _images[image]._scale;
+    return {std::max(1u, (uint32_t)std::lround(_extent.width * scale)),
+            std::max(1u, (uint32_t)std::lround(_extent.height * scale))};
+  }
+} // namespace AltE
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "DeletionQueue.hpp"
+#include "GpuAllocator.hpp"
+#include "GpuProfiler.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // images and passes of a graph are referred to by their index
+  using RenderImage = uint32_t;
+  using RenderPassId = uint32_t;
+
+  // what the execute callback of a pass needs to record its commands
+  struct RenderPassContext {
+      VkRenderPass _renderPass;
+      VkFramebuffer _framebuffer;
+      VkExtent2D _extent;
+      // secondary command buffers must be recorded when it isn't inline
+      VkSubpassContents _contents;
+  };
+
+  using RenderPassExecute =
+      std::function<void(VkCommandBuffer, const RenderPassContext &)>;
+
+  // describes the frame as passes reading and writing images, instead of
+  // render passes and barriers written by hand.
+  //
+  // The graph is built once: the images and the passes are declared, then
+  // compile() culls the passes whose results are never used, works out the
+  // layout transitions, the barriers and the load/store operations, and
+  // creates one VkRenderPass per pass. create_resources() then creates the
+  // size dependent objects, again after every resize. The transient images
+  // whose lifetimes don't overlap share the same memory.
+  //
+  // Each pass is its own render pass, the barriers between them are
+  // recorded by execute(). Only used from the render thread
+  class RenderGraph {
+    public:
+      void init(VkDevice device, GpuAllocator &allocator);
+
+      // destroys everything, the GPU must be idle
+      void cleanup();
+
+      // --- building ---
+
+      // image owned outside the graph, like the swapchain images. It may have
+      // several variants (one per swapchain image), execute() is told which
+      // one to use. It is left in finalLayout at the end of the frame, and
+      // the passes writing to it are never culled
+      RenderImage import_image(const char *name, VkFormat format,
+                               VkImageLayout finalLayout);
+
+      // image created and owned by the graph, scale is relative to the size
+      // given to create_resources(). Its content doesn't survive the frame
+      RenderImage create_image(const char *name, VkFormat format,
+                               float scale = 1.f);
+
+      // passes are executed in the order they are added
+      RenderPassId add_pass(const char *name, RenderPassExecute execute);
+
+      // the pass renders to the image. clear: starts from the clear value of
+      // the image instead of the previous content
+      void write_color(RenderPassId pass, RenderImage image, bool clear);
+      void write_depth(RenderPassId pass, RenderImage image, bool clear);
+
+      // the pass samples the image in its fragment shaders
+      void read_image(RenderPassId pass, RenderImage image);
+
+      void compile();
+
+      // --- after compile() ---
+
+      // compatible with every framebuffer of the pass, for the pipelines
+      VkRenderPass render_pass(RenderPassId pass) const;
+      bool is_culled(RenderPassId pass) const;
+
+      // --- sizing ---
+
+      // images and views of every variant of an imported image
+      void set_imported(RenderImage image, std::vector<VkImage> images,
+                        std::vector<VkImageView> views);
+
+      // creates the transient images and the framebuffers
+      void create_resources(VkExtent2D extent);
+
+      // hands the objects made by create_resources() to the queue, to be
+      // destroyed once frame is done on the GPU
+      void retire_resources(DeletionQueue &queue, uint64_t frame);
+
+      // view of a transient image, or of variant 0 of an imported one
+      VkImageView image_view(RenderImage image) const;
+
+      // --- every frame ---
+
+      void set_clear_value(RenderImage image, VkClearValue value);
+      void set_contents(RenderPassId pass, VkSubpassContents contents);
+
+      // records every pass that wasn't culled, using variant of the imported
+      // images. Each pass is a zone of profiler when there is one
+      void execute(VkCommandBuffer cmd, uint32_t variant,
+                   GpuProfiler *profiler = nullptr);
+
+    private:
+      struct Image {
+          std::string _name;
+          VkFormat _format;
+          bool _imported;
+          float _scale;
+          // imported images only
+          VkImageLayout _finalLayout;
+          // usage of the transient images, from the passes using them
+          VkImageUsageFlags _usage;
+          VkClearValue _clearValue;
+
+          // one per variant for imported images, one for transient images
+          std::vector<VkImage> _images;
+          std::vector<VkImageView> _views;
+
+          // first and last kept pass using it, -1 when none does
+          int _firstUse;
+          int _lastUse;
+      };
+
+      struct Attachment {
+          RenderImage _image;
+          bool _clear;
+      };
+
+      // layout transition and dependency recorded before a pass
+      struct Transition {
+          RenderImage _image;
+          VkImageLayout _oldLayout;
+          VkImageLayout _newLayout;
+          VkPipelineStageFlags _srcStage;
+          VkPipelineStageFlags _dstStage;
+          VkAccessFlags _srcAccess;
+          VkAccessFlags _dstAccess;
+      };
+
+      struct Pass {
+          std::string _name;
+          RenderPassExecute _execute;
+          std::vector<Attachment> _colorWrites;
+          bool _hasDepth;
+          Attachment _depthWrite;
+          std::vector<RenderImage> _reads;
+          VkSubpassContents _contents;
+
+          bool _culled;
+          std::vector<Transition> _transitions;
+          // in framebuffer order
+          std::vector<VkAttachmentLoadOp> _loadOps;
+          std::vector<VkAttachmentStoreOp> _storeOps;
+          VkRenderPass _renderPass;
+          VkExtent2D _extent;
+          // one per variant of the imported images it renders to
+          std::vector<VkFramebuffer> _framebuffers;
+      };
+
+      VkDevice _device = VK_NULL_HANDLE;
+      GpuAllocator *_allocator = nullptr;
+
+      std::vector<Image> _images;
+      std::vector<Pass> _passes;
+      // into the final layouts of the imported images
+      std::vector<Transition> _finalTransitions;
+
+      VkExtent2D _extent = {};
+      // memory shared by the transient images
+      std::vector<VmaAllocation> _memory;
+
+      void cull();
+      void plan_barriers();
+      void create_render_pass(Pass &pass);
+      void create_transient_images();
+      void create_framebuffers(Pass &pass);
+      void record_transitions(VkCommandBuffer cmd,
+                              const std::vector<Transition> &transitions,
+                              uint32_t variant);
+
+      // the attachments of a pass, in framebuffer order
+      static std::vector<Attachment> attachments(const Pass &pass);
+      VkImage image_handle(RenderImage image, uint32_t variant) const;
+      VkImageView view_handle(RenderImage image, uint32_t variant) const;
+      VkExtent2D image_extent(RenderImage image) const;
+  };
+} // namespace AltE
@@ -0,0 +1,146 @@
+#include "ShaderLibrary.hpp"
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+  constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+  // magic, version, generator, bound and schema words
+  constexpr size_t SPIRV_HEADER_SIZE = 5 * sizeof(uint32_t);
+
+  // FNV-1a over the size and the words of the module
+  uint64_t hash_code(std::span<const std::byte> code) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash ^= code.size();
+    hash *= 0x100000001b3ull;
+    for (size_t i = 0; i < code.size(); i += sizeof(uint32_t)) {
+      uint32_t word;
+      std::memcpy(&word, code.data() + i, sizeof(word));
+      hash ^= word;
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+} // namespace
+
+namespace AltE {
+  void ShaderLibrary::init(VkDevice device,
+                           std::filesystem::path shaderDirectory,
+                           const AssetManager *assets) {
+    _device = device;
+    _shaderDirectory = std::move(shaderDirectory);
+    _assets = assets;
+
+    SPDLOG_DEBUG("Shader library initialized from {}",
+                 _shaderDirectory.string());
+  }
+
+  void ShaderLibrary::cleanup() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto &[hash, cached] : _modulesByHash) {
+      vkDestroyShaderModule(_device, cached._module, nullptr);
+    }
+    _modulesByHash.clear();
+    _modulesByName.clear();
+  }
+
+  VkShaderModule ShaderLibrary::get(const std::string &name) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto found = _modulesByName.find(name);
+    if (found != _modulesByName.end()) {
+      return found->second;
+    }
+
+    return load_named_locked(name, true);
+  }
+
+  VkShaderModule ShaderLibrary::reload(const std::string &name) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // the archive is only rebuilt by the Assets target, the fresh shader is
+    // the loose file
+    return load_named_locked(name, false);
+  }
+
+  VkShaderModule ShaderLibrary::load_named_locked(const std::string &name,
+                                                  bool useArchive) {
+    // the module is created from the mapping, the file is never copied. A
+    // loose file stays mapped in the cache next to its module
+    std::span<const std::byte> code;
+    std::string source;
+    MappedFile file;
+
+    if (useArchive && _assets != nullptr && _assets->is_open()) {
+      source = "shaders/" + name + ".spv";
+      code = _assets->get(source);
+    }
+    if (code.empty()) {
+      std::filesystem::path path = _shaderDirectory / (name + ".spv");
+      source = path.string();
+      if (!file.open(path)) {
+        spdlog::default_logger()->error("Can't open shader {}", source);
+        return VK_NULL_HANDLE;
+      }
+      code = file.data();
+    }
+
+    VkShaderModule module = load_locked(code, std::move(file));
+    if (module == VK_NULL_HANDLE) {
+      spdlog::default_logger()->error("Invalid shader {}", source);
+      return VK_NULL_HANDLE;
+    }
+
+    _modulesByName.insert_or_assign(name, module);
+    SPDLOG_DEBUG("Shader {} loaded", name);
+    return module;
+  }
+
+  VkShaderModule ShaderLibrary::load(std::span<const std::byte> code) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return load_locked(code);
+  }
+
+  VkShaderModule ShaderLibrary::load_locked(std::span<const std::byte> code,
+                                            MappedFile file) {
+    // SPIR-V is a stream of 32 bits words starting with the magic number.
+    // Mappings are page aligned, so the words can be read in place
+    if (code.size() < SPIRV_HEADER_SIZE ||
+        code.size() % sizeof(uint32_t) != 0) {
+      return VK_NULL_HANDLE;
+    }
+    uint32_t magic;
+    std::memcpy(&magic, code.data(), sizeof(magic));
+    if (magic != SPIRV_MAGIC) {
+      return VK_NULL_HANDLE;
+    }
+
+    uint64_t hash = hash_code(code);
+    auto [first, last] = _modulesByHash.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+      std::span<const std::byte> cached = it->second._code;
+      if (cached.size() == code.size() &&
+          std::memcmp(cached.data(), code.data(), code.size()) == 0) {
+        return it->second._module;
+      }
+    }
+
+    VkShaderModuleCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.pNext = nullptr;
+
+    // codeSize is in bytes
+    createInfo.codeSize = code.size();
+    createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+
+    VkShaderModule module;
+    if (vkCreateShaderModule(_device, &createInfo, nullptr, &module) !=
+        VK_SUCCESS) {
+      return VK_NULL_HANDLE;
+    }
+
+    _modulesByHash.emplace(hash,
+                           CachedModule{code, std::move(file), module});
+    return module;
+  }
+} // namespace AltE
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../assets/AssetManager.hpp"
+#include "../core/MappedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // owns every shader module of the engine. The compiled shaders are mapped
+  // in memory and the modules are created straight from the mapping, then
+  // cached by content so a shader used by many pipelines is only created
+  // once. Modules live until cleanup()
+  class ShaderLibrary {
+    public:
+      // shaderDirectory contains the .spv files written by the Shaders target.
+      // When given, shaders are looked up in the archive first, as
+      // "shaders/<name>.spv", and only read from the directory when missing
+      void init(VkDevice device, std::filesystem::path shaderDirectory,
+                const AssetManager *assets = nullptr);
+      void cleanup();
+
+      // module of a compiled shader, by source name (e.g. "triangle.vert"),
+      // VK_NULL_HANDLE if it can't be loaded
+      VkShaderModule get(const std::string &name);
+
+      // reads the compiled shader again from its .spv file, used for hot
+      // reloading. The previous module stays alive until cleanup(), so
+      // pipelines still being compiled from it aren't affected
+      VkShaderModule reload(const std::string &name);
+
+      // module for SPIR-V code already in memory, VK_NULL_HANDLE if the code
+      // isn't valid SPIR-V. The cache compares against the code, it must
+      // stay valid until cleanup()
+      VkShaderModule load(std::span<const std::byte> code);
+
+    private:
+      VkDevice _device = VK_NULL_HANDLE;
+      std::filesystem::path _shaderDirectory;
+      const AssetManager *_assets = nullptr;
+
+      // shaders can be requested from the pipeline compilation workers
+      std::mutex _mutex;
+      // a module and the code it was created from, compared on a hash hit
+      // since two shaders can share a hash. Loose files stay mapped with
+      // their module, the archive is mapped until after cleanup()
+      struct CachedModule {
+          std::span<const std::byte> _code;
+          MappedFile _file;
+          VkShaderModule _module;
+      };
+      std::unordered_multimap<uint64_t, CachedModule> _modulesByHash;
+      std::unordered_map<std::string, VkShaderModule> _modulesByName;
+
+      VkShaderModule load_locked(std::span<const std::byte> code,
+                                 MappedFile file = {});
+      VkShaderModule load_named_locked(const std::string &name,
+                                       bool useArchive);
+  };
+} // namespace AltE
@@ -0,0 +1,222 @@
+#include "ShaderWatcher.hpp"
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <set>
+#include <spawn.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+namespace {
+  // editors save through several writes and renames, the directory has to be
+  // quiet for that long before the changed sources are compiled
+  constexpr int SETTLE_DELAY_MS = 50;
+
+  [[maybe_unused]] bool is_shader_source(const std::string &name) {
+    std::string extension = std::filesystem::path(name).extension().string();
+    return extension == ".vert" || extension == ".frag" ||
+           extension == ".comp";
+  }
+} // namespace
+
+namespace AltE {
+#if defined(__linux__) && defined(ALTE_GLSL_VALIDATOR)
+  bool ShaderWatcher::start(std::filesystem::path shaderDirectory) {
+    _shaderDirectory = std::move(shaderDirectory);
+
+    _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotifyFd < 0) {
+      spdlog::default_logger()->warn("Can't watch the shaders: {}",
+                                     std::strerror(errno));
+      return false;
+    }
+
+    // editors either write the file in place or write a new file and move it
+    // over the old one
+    if (inotify_add_watch(_inotifyFd, _shaderDirectory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        pipe2(_stopPipe, O_CLOEXEC) != 0) {
+      spdlog::default_logger()->warn("Can't watch {}: {}",
+                                     _shaderDirectory.string(),
+                                     std::strerror(errno));
+      close(_inotifyFd);
+      _inotifyFd = -1;
+      return false;
+    }
+
+    _thread = std::thread(&ShaderWatcher::thread_loop, this);
+
+    spdlog::default_logger()->info("Watching {} for shader changes",
+                                   _shaderDirectory.string());
+    return true;
+  }
+
+  void ShaderWatcher::stop() {
+    if (!_thread.joinable()) {
+      return;
+    }
+
+    char wake = 0;
+    if (write(_stopPipe[1], &wake, sizeof(wake)) < 0) {
+      spdlog::default_logger()->error("Can't stop the shader watcher");
+    }
+    _thread.join();
+
+    close(_stopPipe[0]);
+    close(_stopPipe[1]);
+    close(_inotifyFd);
+    _stopPipe[0] = _stopPipe[1] = _inotifyFd = -1;
+  }
+
+  void ShaderWatcher::thread_loop() {
+    std::set<std::string> changed;
+    alignas(inotify_event) char buffer[4096];
+
+    while (true) {
+      pollfd fds[2] = {{_inotifyFd, POLLIN, 0}, {_stopPipe[0], POLLIN, 0}};
+
+      // sleep until something changes, then until the burst of events is
+      // over
+      int ready = poll(fds, 2, changed.empty() ? -1 : SETTLE_DELAY_MS);
+      if (ready < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        spdlog::default_logger()->error("Shader watcher stopped: {}",
+                                        std::strerror(errno));
+        return;
+      }
+      if (fds[1].revents != 0) {
+        return;
+      }
+
+      if (ready == 0) {
+        for (const std::string &name : changed) {
+          if (compile(name)) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _recompiled.push_back(name);
+          }
+        }
+        changed.clear();
+        continue;
+      }
+
+      ssize_t length;
+      while ((length = read(_inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char *ptr = buffer; ptr < buffer + length;) {
+          const inotify_event *event =
+              reinterpret_cast<const inotify_event *>(ptr);
+          // the .spv files written by compile() are ignored here
+          if (event->len > 0 && is_shader_source(event->name)) {
+            changed.insert(event->name);
+          }
+          ptr += sizeof(inotify_event) + event->len;
+        }
+      }
+    }
+  }
+
+  bool ShaderWatcher::compile(const std::string &name) {
+    std::string source = (_shaderDirectory / name).string();
+    std::string output = (_shaderDirectory / (name + ".spv")).string();
+
+    // compile next to the module and move it over, so the engine never maps
+    // a half written module and the last good one stays when this fails
+    std::string tmpOutput = output + ".tmp";
+
+    int outputPipe[2];
+    if (pipe2(outputPipe, O_CLOEXEC) != 0) {
+      spdlog::default_logger()->error("Can't compile {}: {}", name,
+                                      std::strerror(errno));
+      return false;
+    }
+
+    // glslangValidator reports the errors on stdout
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, outputPipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, outputPipe[1], STDERR_FILENO);
+
+    std::string validator = ALTE_GLSL_VALIDATOR;
+    std::string vulkanFlag = "-V";
+    std::string outputFlag = "-o";
+    char *argv[] = {validator.data(), vulkanFlag.data(), source.data(),
+                    outputFlag.data(), tmpOutput.data(), nullptr};
+
+    pid_t pid;
+    int spawnError = posix_spawn(&pid, validator.c_str(), &actions, nullptr,
+                                 argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(outputPipe[1]);
+
+    if (spawnError != 0) {
+      close(outputPipe[0]);
+      spdlog::default_logger()->error("Can't run {}: {}", validator,
+                                      std::strerror(spawnError));
+      return false;
+    }
+
+    std::string log;
+    char chunk[512];
+    while (true) {
+      ssize_t length = read(outputPipe[0], chunk, sizeof(chunk));
+      if (length > 0) {
+        log.append(chunk, length);
+      } else if (length == 0 || errno != EINTR) {
+        break;
+      }
+    }
+    close(outputPipe[0]);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+
+    std::error_code error;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      spdlog::default_logger()->error("Failed to compile {}:\n{}", name, log);
+      std::filesystem::remove(tmpOutput, error);
+      return false;
+    }
+
+    std::filesystem::rename(tmpOutput, output, error);
+    if (error) {
+      spdlog::default_logger()->error("Failed to replace {}: {}", output,
+                                      error.message());
+      std::filesystem::remove(tmpOutput, error);
+      return false;
+    }
+
+    spdlog::default_logger()->info("Shader {} recompiled", name);
+    return true;
+  }
+#else
+  bool ShaderWatcher::start(std::filesystem::path shaderDirectory) {
+    _shaderDirectory = std::move(shaderDirectory);
+    spdlog::default_logger()->info(
+        "Shader hot reloading isn't available in this build");
+    return false;
+  }
+
+  void ShaderWatcher::stop() {}
+
+  void ShaderWatcher::thread_loop() {}
+
+  bool ShaderWatcher::compile(const std::string &) { return false; }
+#endif
+
+  std::vector<std::string> ShaderWatcher::take_recompiled() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::string> recompiled;
+    recompiled.swap(_recompiled);
+    return recompiled;
+  }
+} // namespace AltE
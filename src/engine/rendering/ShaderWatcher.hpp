@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace AltE {
+  // recompiles the GLSL sources of a directory as soon as they are saved, so
+  // the shaders can be edited while the engine runs. Relies on inotify and
+  // glslangValidator, so it only does something on Linux
+  class ShaderWatcher {
+    public:
+      // watches shaderDirectory, where both the sources and the .spv files
+      // written by the Shaders target live. Returns false when hot reloading
+      // isn't available
+      bool start(std::filesystem::path shaderDirectory);
+      void stop();
+
+      // names of the sources (e.g. "triangle.vert") successfully recompiled
+      // since the last call
+      std::vector<std::string> take_recompiled();
+
+    private:
+      std::filesystem::path _shaderDirectory;
+      int _inotifyFd = -1;
+      // written to wake the thread up when stopping
+      int _stopPipe[2] = {-1, -1};
+      std::thread _thread;
+
+      std::mutex _mutex;
+      std::vector<std::string> _recompiled;
+
+      void thread_loop();
+      // runs glslangValidator on a source, true when the .spv was replaced
+      bool compile(const std::string &name);
+  };
+} // namespace AltE
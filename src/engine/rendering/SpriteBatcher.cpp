@@ -0,0 +1,139 @@
+#include "SpriteBatcher.hpp"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  namespace {
+    // vertex stage push constants of sprite.vert
+    struct SpritePushConstants {
+        float _screenScale[2];
+    };
+
+    // two triangles per quad, generated from gl_VertexIndex
+    constexpr uint32_t QUAD_VERTICES = 6;
+  } // namespace
+
+  void SpriteBatcher::init(TextureAtlas &atlas, BindlessHeap &heap,
+                           LinearAllocator &frameAllocator) {
+    _atlas = &atlas;
+    _heap = &heap;
+    _frameAllocator = &frameAllocator;
+  }
+
+  VertexInputDescription SpriteBatcher::instance_description() {
+    VertexInputDescription description;
+    description._bindings.push_back(
+        {0, sizeof(SpriteInstance), VK_VERTEX_INPUT_RATE_INSTANCE});
+
+    // location, binding, format, offset
+    description._attributes.push_back(
+        {0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(SpriteInstance, _position)});
+    description._attributes.push_back(
+        {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(SpriteInstance, _size)});
+    description._attributes.push_back({2, 0, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                       offsetof(SpriteInstance, _uvRect)});
+    description._attributes.push_back(
+        {3, 0, VK_FORMAT_R32_SFLOAT, offsetof(SpriteInstance, _rotation)});
+    description._attributes.push_back(
+        {4, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(SpriteInstance, _color)});
+    description._attributes.push_back(
+        {5, 0, VK_FORMAT_R32_UINT, offsetof(SpriteInstance, _texture)});
+    return description;
+  }
+
+  void SpriteBatcher::begin(VkExtent2D extent) {
+    _extent = extent;
+    _instances.clear();
+    _entries.clear();
+    _pipelines.clear();
+  }
+
+  void SpriteBatcher::add(VkPipeline pipeline, const AtlasRegion &region,
+                          const Sprite &sprite) {
+    if (!region.valid() || region._page >= _atlas->page_count() ||
+        _atlas->page_texture(region._page) == INVALID_BINDLESS_INDEX) {
+      // not uploaded yet, or the heap is full
+      return;
+    }
+
+    // a frame only uses a few pipelines, a linear search is enough
+    auto found = std::find(_pipelines.begin(), _pipelines.end(), pipeline);
+    uint64_t pipelineIndex = found - _pipelines.begin();
+    if (found == _pipelines.end()) {
+      _pipelines.push_back(pipeline);
+    }
+
+    // the layer is biased so negative layers sort first
+    uint64_t layer = (uint64_t)((int64_t)sprite._layer + INT32_MAX + 1);
+    Entry entry;
+    entry._key = (layer << 32) | (pipelineIndex & 0xffffffff);
+    entry._index = (uint32_t)_instances.size();
+    entry._pipeline = pipeline;
+    _entries.push_back(entry);
+
+    SpriteInstance instance;
+    std::memcpy(instance._position, sprite._position,
+                sizeof(instance._position));
+    std::memcpy(instance._size, sprite._size, sizeof(instance._size));
+    instance._uvRect[0] = region._uvMin[0];
+    instance._uvRect[1] = region._uvMin[1];
+    instance._uvRect[2] = region._uvMax[0];
+    instance._uvRect[3] = region._uvMax[1];
+    instance._rotation = sprite._rotation;
+    std::memcpy(instance._color, sprite._color, sizeof(instance._color));
+    instance._texture = _atlas->page_texture(region._page);
+    _instances.push_back(instance);
+  }
+
+  void SpriteBatcher::flush(DrawList &drawList) {
+    _drawCount = 0;
+    if (_entries.empty()) {
+      return;
+    }
+
+    LinearAllocation allocation = _frameAllocator->allocate(
+        _instances.size() * sizeof(SpriteInstance));
+    if (allocation._mapped == nullptr) {
+      spdlog::default_logger()->warn(
+          "No room for {} sprites in the frame buffer", _instances.size());
+      return;
+    }
+
+    // the index breaks the ties, so the order within a batch is the order
+    // the sprites were added in
+    std::sort(_entries.begin(), _entries.end(),
+              [](const Entry &a, const Entry &b) {
+                return a._key != b._key ? a._key < b._key
+                                        : a._index < b._index;
+              });
+
+    SpriteInstance *instances =
+        static_cast<SpriteInstance *>(allocation._mapped);
+    for (size_t i = 0; i < _entries.size(); i++) {
+      instances[i] = _instances[_entries[i]._index];
+    }
+
+    SpritePushConstants constants;
+    constants._screenScale[0] = 2.f / (float)_extent.width;
+    constants._screenScale[1] = 2.f / (float)_extent.height;
+
+    // one draw per run of sprites sharing a pipeline. The runs index the
+    // same buffer binding through their first instance
+    size_t runStart = 0;
+    for (size_t i = 1; i <= _entries.size(); i++) {
+      if (i < _entries.size() &&
+          _entries[i]._pipeline == _entries[runStart]._pipeline) {
+        continue;
+      }
+
+      drawList.add_instances(
+          _entries[runStart]._pipeline, _heap->pipeline_layout(),
+          _heap->set(), allocation._buffer, allocation._offset,
+          QUAD_VERTICES, (uint32_t)(i - runStart), (uint32_t)runStart,
+          &constants, sizeof(constants), BindlessHeap::PUSH_CONSTANT_STAGES);
+      _drawCount++;
+      runStart = i;
+    }
+  }
+} // namespace AltE
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "BindlessHeap.hpp"
+#include "DrawList.hpp"
+#include "LinearAllocator.hpp"
+#include "PipelineBuilder.hpp"
+#include "TextureAtlas.hpp"
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // a textured quad on screen, in pixels from the top left corner
+  struct Sprite {
+      float _position[2] = {0.f, 0.f};
+      float _size[2] = {0.f, 0.f};
+      // radians, around the center
+      float _rotation = 0.f;
+      // multiplies the texels, RGBA
+      uint8_t _color[4] = {255, 255, 255, 255};
+      // sprites are drawn from the lowest layer up. Within a layer they are
+      // grouped by pipeline, only the sprites sharing a pipeline keep their
+      // submission order. Overlapping sprites that must stay in order go in
+      // different layers
+      int32_t _layer = 0;
+  };
+
+  // per instance data of sprite.vert
+  struct SpriteInstance {
+      // center
+      float _position[2];
+      float _size[2];
+      // uvMin then uvMax
+      float _uvRect[4];
+      float _rotation;
+      uint8_t _color[4];
+      // atlas page in the bindless heap
+      uint32_t _texture;
+  };
+
+  static_assert(sizeof(SpriteInstance) == 44,
+                "SpriteInstance is read as vertex attributes");
+
+  // collects the sprites of a frame and draws them in a handful of
+  // instanced draws: the sprites are sorted by layer and pipeline, written
+  // once into the per-frame buffer, and each run sharing a pipeline becomes
+  // a single draw of 6 vertices per instance. Each instance carries the
+  // bindless index of its atlas page, so the page doesn't split the runs.
+  // Only used from the render thread
+  class SpriteBatcher {
+    public:
+      void init(TextureAtlas &atlas, BindlessHeap &heap,
+                LinearAllocator &frameAllocator);
+
+      // the layout of the bindless heap, the push constants start with the
+      // scale from pixels to clip space
+      VkPipelineLayout pipeline_layout() const {
+        return _heap->pipeline_layout();
+      }
+
+      // SpriteInstance as read by sprite.vert, one per instance
+      static VertexInputDescription instance_description();
+
+      // forgets the sprites of the previous frame. extent is the size of
+      // the target in pixels
+      void begin(VkExtent2D extent);
+
+      void add(VkPipeline pipeline, const AtlasRegion &region,
+               const Sprite &sprite);
+
+      // sorts the sprites, writes them to the per-frame buffer and adds
+      // their draws to drawList
+      void flush(DrawList &drawList);
+
+      size_t size() const { return _instances.size(); }
+      // draws made by the last flush()
+      uint32_t draw_count() const { return _drawCount; }
+
+    private:
+      struct Entry {
+          // layer then pipeline
+          uint64_t _key;
+          // into _instances, keeps the submission order among equal keys
+          uint32_t _index;
+          VkPipeline _pipeline;
+      };
+
+      TextureAtlas *_atlas = nullptr;
+      BindlessHeap *_heap = nullptr;
+      LinearAllocator *_frameAllocator = nullptr;
+
+      VkExtent2D _extent = {};
+      std::vector<SpriteInstance> _instances;
+      std::vector<Entry> _entries;
+      // pipelines seen this frame, their index is part of the sort key
+      std::vector<VkPipeline> _pipelines;
+      uint32_t _drawCount = 0;
+  };
+} // namespace AltE
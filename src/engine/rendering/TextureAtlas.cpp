@@ -0,0 +1,276 @@
+#include "TextureAtlas.hpp"
+#include "vk_check.hpp"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  void TextureAtlas::init(VkDevice device, GpuAllocator &allocator,
+                          UploadQueue &uploads, BindlessHeap &heap,
+                          LinearAllocator &frameAllocator, uint32_t pageSize) {
+    _device = device;
+    _allocator = &allocator;
+    _uploads = &uploads;
+    _heap = &heap;
+    _frameAllocator = &frameAllocator;
+    _pageSize = pageSize;
+
+    // linear filtering, the gutter keeps the neighbours out
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.pNext = nullptr;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.f;
+    VK_CHECK(vkCreateSampler(_device, &samplerInfo, nullptr, &_sampler));
+  }
+
+  void TextureAtlas::cleanup() {
+    for (Page &page : _pages) {
+      if (page._view != VK_NULL_HANDLE) {
+        vkDestroyImageView(_device, page._view, nullptr);
+        _allocator->destroy_image(page._image);
+      }
+    }
+    _pages.clear();
+    _uploadedPages = 0;
+    vkDestroySampler(_device, _sampler, nullptr);
+  }
+
+  void TextureAtlas::open_page() {
+    Page &page = _pages.emplace_back();
+    page._packer.init(_pageSize, _pageSize);
+  }
+
+  AtlasRegion TextureAtlas::add(const uint8_t *pixels, uint32_t width,
+                                uint32_t height) {
+    AtlasRegion region;
+    uint32_t paddedWidth = width + 2 * GUTTER;
+    uint32_t paddedHeight = height + 2 * GUTTER;
+    if (width == 0 || height == 0 || paddedWidth > _pageSize ||
+        paddedHeight > _pageSize) {
+      spdlog::default_logger()->error(
+          "Image of {}x{} doesn't fit in an atlas page of {}x{}", width,
+          height, _pageSize, _pageSize);
+      return region;
+    }
+
+    // an uploaded page is updated through the frame allocator, an image
+    // too large for it goes to a new page instead
+    size_t paddedSize = (size_t)paddedWidth * paddedHeight * 4;
+    bool fitsUpdate = _pages.size() > _uploadedPages ||
+                      paddedSize <= _frameAllocator->frame_size();
+
+    uint32_t x, y;
+    if (_pages.empty() || !fitsUpdate ||
+        !_pages.back()._packer.pack(paddedWidth, paddedHeight, x, y)) {
+      // only the last page is filled, a full one is left as it is
+      open_page();
+      _pages.back()._packer.pack(paddedWidth, paddedHeight, x, y);
+    }
+    Page &page = _pages.back();
+
+    VkBufferImageCopy copy = {};
+    copy.bufferOffset = page._added._pixels.size();
+    copy.bufferRowLength = 0;
+    copy.bufferImageHeight = 0;
+    copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.imageSubresource.mipLevel = 0;
+    copy.imageSubresource.baseArrayLayer = 0;
+    copy.imageSubresource.layerCount = 1;
+    copy.imageOffset = {(int32_t)x, (int32_t)y, 0};
+    copy.imageExtent = {paddedWidth, paddedHeight, 1};
+    page._added._regions.push_back(copy);
+    page._added._pixels.resize(copy.bufferOffset + paddedSize);
+
+    // the rows of the image, then the gutter repeats its edges
+    size_t pitch = (size_t)paddedWidth * 4;
+    uint8_t *origin = page._added._pixels.data() + copy.bufferOffset +
+                      GUTTER * pitch + GUTTER * 4;
+    for (uint32_t row = 0; row < height; row++) {
+      uint8_t *dst = origin + row * pitch;
+      const uint8_t *src = pixels + (size_t)row * width * 4;
+      std::memcpy(dst, src, (size_t)width * 4);
+      for (uint32_t i = 1; i <= GUTTER; i++) {
+        std::memcpy(dst - i * 4, src, 4);
+        std::memcpy(dst + (size_t)(width - 1 + i) * 4,
+                    src + (size_t)(width - 1) * 4, 4);
+      }
+    }
+    for (uint32_t i = 1; i <= GUTTER; i++) {
+      std::memcpy(origin - i * pitch - GUTTER * 4, origin - GUTTER * 4,
+                  pitch);
+      std::memcpy(origin + (height - 1 + i) * pitch - GUTTER * 4,
+                  origin + (height - 1) * pitch - GUTTER * 4, pitch);
+    }
+
+    region._page = (uint32_t)_pages.size() - 1;
+    region._uvMin[0] = (float)(x + GUTTER) / (float)_pageSize;
+    region._uvMin[1] = (float)(y + GUTTER) / (float)_pageSize;
+    region._uvMax[0] = (float)(x + GUTTER + width) / (float)_pageSize;
+    region._uvMax[1] = (float)(y + GUTTER + height) / (float)_pageSize;
+    region._width = width;
+    region._height = height;
+    return region;
+  }
+
+  uint64_t TextureAtlas::upload() {
+    uint64_t value = 0;
+
+    // the GPU may be sampling the uploaded pages, their new images are
+    // copied by the graphics queue
+    for (uint32_t i = 0; i < _uploadedPages; i++) {
+      Page &page = _pages[i];
+      VkDeviceSize base = page._updates._pixels.size();
+      for (VkBufferImageCopy copy : page._added._regions) {
+        copy.bufferOffset += base;
+        page._updates._regions.push_back(copy);
+      }
+      page._updates._pixels.insert(page._updates._pixels.end(),
+                                   page._added._pixels.begin(),
+                                   page._added._pixels.end());
+      page._added = {};
+    }
+
+    for (uint32_t i = _uploadedPages; i < _pages.size(); i++) {
+      Page &page = _pages[i];
+
+      VkImageCreateInfo imageInfo = {};
+      imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+      imageInfo.pNext = nullptr;
+
+      imageInfo.imageType = VK_IMAGE_TYPE_2D;
+      imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+      imageInfo.extent = {_pageSize, _pageSize, 1};
+      imageInfo.mipLevels = 1;
+      imageInfo.arrayLayers = 1;
+      imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+      imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+      imageInfo.usage =
+          VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+      imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      page._image = _allocator->create_image(imageInfo);
+
+      VkImageViewCreateInfo viewInfo = {};
+      viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      viewInfo.pNext = nullptr;
+
+      viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+      viewInfo.image = page._image._image;
+      viewInfo.format = imageInfo.format;
+      viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      viewInfo.subresourceRange.baseMipLevel = 0;
+      viewInfo.subresourceRange.levelCount = 1;
+      viewInfo.subresourceRange.baseArrayLayer = 0;
+      viewInfo.subresourceRange.layerCount = 1;
+      VK_CHECK(vkCreateImageView(_device, &viewInfo, nullptr, &page._view));
+      page._texture = _heap->add_texture(page._view, _sampler);
+
+      // nothing samples the texels between the images, they are left
+      // undefined
+      const PendingCopies &added = page._added;
+      value = std::max(value, _uploads->upload_image(
+                                  page._image._image, added._regions,
+                                  added._pixels.data(), added._pixels.size()));
+
+      SPDLOG_DEBUG("Atlas page {} uploaded, {:.0f}% used", i,
+                   page._packer.occupancy() * 100.f);
+
+      // the staging ring has its own copy
+      page._added = {};
+    }
+
+    _uploadedPages = (uint32_t)_pages.size();
+    return value;
+  }
+
+  void TextureAtlas::record_updates(VkCommandBuffer cmd) {
+    std::vector<VkImageMemoryBarrier> barriers;
+    std::vector<uint32_t> pages;
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    for (uint32_t i = 0; i < _uploadedPages; i++) {
+      if (_pages[i]._updates._regions.empty()) {
+        continue;
+      }
+      // the texels already in the page are kept, the previous frames only
+      // read them so there is nothing to make available
+      barrier.srcAccessMask = 0;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.image = _pages[i]._image._image;
+      barriers.push_back(barrier);
+      pages.push_back(i);
+    }
+    if (pages.empty()) {
+      return;
+    }
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, barriers.size(), barriers.data());
+
+    std::vector<VkBufferImageCopy> copies;
+    for (uint32_t i : pages) {
+      PendingCopies &updates = _pages[i]._updates;
+
+      // as many images as the frame has room for, in the order they were
+      // added
+      size_t done = 0;
+      copies.clear();
+      for (const VkBufferImageCopy &region : updates._regions) {
+        VkDeviceSize size = (VkDeviceSize)region.imageExtent.width *
+                            region.imageExtent.height * 4;
+        if (size > _frameAllocator->available()) {
+          break;
+        }
+        LinearAllocation staging = _frameAllocator->allocate(size);
+        std::memcpy(staging._mapped,
+                    updates._pixels.data() + region.bufferOffset, size);
+
+        VkBufferImageCopy copy = region;
+        copy.bufferOffset = staging._offset;
+        copies.push_back(copy);
+        done++;
+      }
+      if (!copies.empty()) {
+        vkCmdCopyBufferToImage(cmd, _frameAllocator->buffer(),
+                               _pages[i]._image._image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               copies.size(), copies.data());
+      }
+
+      if (done == updates._regions.size()) {
+        updates = {};
+      } else {
+        updates._regions.erase(updates._regions.begin(),
+                               updates._regions.begin() + done);
+      }
+    }
+
+    for (VkImageMemoryBarrier &pageBarrier : barriers) {
+      pageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      pageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      pageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      pageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0,
+                         nullptr, barriers.size(), barriers.data());
+  }
+} // namespace AltE
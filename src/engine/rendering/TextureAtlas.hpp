@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../core/SkylinePacker.hpp"
+#include "BindlessHeap.hpp"
+#include "GpuAllocator.hpp"
+#include "LinearAllocator.hpp"
+#include "UploadQueue.hpp"
+#include "vk_types.hpp"
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // where an image ended up in the atlas
+  struct AtlasRegion {
+      uint32_t _page = UINT32_MAX;
+      float _uvMin[2] = {0.f, 0.f};
+      float _uvMax[2] = {0.f, 0.f};
+      // size of the image in pixels
+      uint32_t _width = 0;
+      uint32_t _height = 0;
+
+      bool valid() const { return _page != UINT32_MAX; }
+  };
+
+  // folds small RGBA images into a few large textures, the pages, so the
+  // sprites using them can be drawn together. Images are packed with a
+  // SkylinePacker into the last page and kept on the CPU until upload().
+  // A new page is only opened when the last one is full. Uploaded pages are
+  // added to the bindless heap. Only used from the render thread.
+  //
+  // Only the images themselves are copied, not the whole page. The first
+  // upload of a page goes through the upload queue. Images added to a page
+  // the GPU may already be sampling are copied by the graphics queue in
+  // record_updates(): the copies are ordered after the frames still reading
+  // the page, and the page goes from SHADER_READ_ONLY to TRANSFER_DST and
+  // back without losing what it holds
+  class TextureAtlas {
+    public:
+      // the copies into uploaded pages are staged in frameAllocator, which
+      // needs VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+      void init(VkDevice device, GpuAllocator &allocator, UploadQueue &uploads,
+                BindlessHeap &heap, LinearAllocator &frameAllocator,
+                uint32_t pageSize = 2048);
+      void cleanup();
+
+      // copies width x height RGBA pixels into a page. The region is
+      // invalid when the image is larger than a page
+      AtlasRegion add(const uint8_t *pixels, uint32_t width, uint32_t height);
+
+      // creates the images of the pages opened since the last call and
+      // queues their uploads. The images added to uploaded pages wait for
+      // record_updates(). Returns the upload timeline value to wait on, 0
+      // when nothing went through the upload queue
+      uint64_t upload();
+
+      // copies the images added to uploaded pages before the last upload(),
+      // to be recorded before anything samples the atlas in the frame. The
+      // images that don't fit in the frame allocator wait for the next frame
+      void record_updates(VkCommandBuffer cmd);
+
+      // uploaded pages are 0 to page_count() - 1
+      uint32_t page_count() const { return _uploadedPages; }
+      VkImageView page_view(uint32_t page) const {
+        return _pages[page]._view;
+      }
+      // slot of the page in the bindless heap
+      BindlessIndex page_texture(uint32_t page) const {
+        return _pages[page]._texture;
+      }
+
+    private:
+      // images with their gutter, one after the other, and where each of
+      // them goes in the page
+      struct PendingCopies {
+          std::vector<uint8_t> _pixels;
+          std::vector<VkBufferImageCopy> _regions;
+      };
+
+      struct Page {
+          SkylinePacker _packer;
+          // added since the last upload()
+          PendingCopies _added;
+          // added to the page once uploaded, waiting for record_updates()
+          PendingCopies _updates;
+          AllocatedImage _image;
+          VkImageView _view = VK_NULL_HANDLE;
+          BindlessIndex _texture = INVALID_BINDLESS_INDEX;
+      };
+
+      // pixels repeated around each image, so linear filtering at its edges
+      // doesn't bleed the neighbours in
+      static constexpr uint32_t GUTTER = 1;
+
+      VkDevice _device = VK_NULL_HANDLE;
+      GpuAllocator *_allocator = nullptr;
+      UploadQueue *_uploads = nullptr;
+      BindlessHeap *_heap = nullptr;
+      LinearAllocator *_frameAllocator = nullptr;
+      // shared by the pages
+      VkSampler _sampler = VK_NULL_HANDLE;
+      uint32_t _pageSize = 0;
+
+      std::vector<Page> _pages;
+      // the pages after these have no image yet
+      uint32_t _uploadedPages = 0;
+
+      void open_page();
+  };
+} // namespace AltE
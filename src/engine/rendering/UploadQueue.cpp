@@ -0,0 +1,459 @@
+#include "UploadQueue.hpp"
+#include "vk_abstract.hpp"
+#include "vk_check.hpp"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+  // satisfies optimalBufferCopyOffsetAlignment and the texel size of every
+  // format we upload
+  constexpr VkDeviceSize STAGING_ALIGNMENT = 256;
+
+  uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+} // namespace
+
+namespace AltE {
+  void UploadQueue::init(VkDevice device, GpuAllocator &allocator,
+                         VkQueue queue, uint32_t queueFamily,
+                         uint32_t graphicsQueueFamily, std::mutex *queueMutex,
+                         VkDeviceSize stagingSize) {
+    _device = device;
+    _allocator = &allocator;
+    _queue = queue;
+    _queueFamily = queueFamily;
+    _graphicsQueueFamily = graphicsQueueFamily;
+    _queueMutex = queueMutex;
+
+    // the command buffers are recycled once their batch is done
+    VkCommandPoolCreateInfo poolInfo = vk_abstract::command_pool_create_info(
+        _queueFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    VK_CHECK(vkCreateCommandPool(_device, &poolInfo, nullptr, &_commandPool));
+
+    VkSemaphoreTypeCreateInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    timelineInfo.pNext = nullptr;
+    timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo = vk_abstract::semaphore_create_info();
+    semaphoreInfo.pNext = &timelineInfo;
+    VK_CHECK(vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_timeline));
+
+    _staging = allocator.create_buffer(align_up(stagingSize, STAGING_ALIGNMENT),
+                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                       MemoryUsage::Upload);
+
+    _stopping = false;
+    _thread = std::thread([this]() { thread_loop(); });
+
+    SPDLOG_DEBUG("Upload queue initialized (queue family {}, {} staging bytes)",
+                 _queueFamily, _staging._size);
+  }
+
+  void UploadQueue::cleanup() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+    _workAvailable.notify_all();
+    _thread.join();
+
+    vkDestroySemaphore(_device, _timeline, nullptr);
+    vkDestroyCommandPool(_device, _commandPool, nullptr);
+    _allocator->destroy_buffer(_staging);
+  }
+
+  bool UploadQueue::allocate_staging(std::unique_lock<std::mutex> &lock,
+                                     VkDeviceSize size, VkDeviceSize &offset) {
+    const uint64_t capacity = _staging._size;
+    if (size > capacity) {
+      spdlog::default_logger()->error(
+          "Upload of {} bytes doesn't fit in the {} bytes staging ring", size,
+          capacity);
+      return false;
+    }
+
+    while (true) {
+      uint64_t position = align_up(_stagingHead, STAGING_ALIGNMENT);
+      // an upload never wraps around the end of the ring, skip to the start
+      if (position % capacity + size > capacity) {
+        position += capacity - position % capacity;
+      }
+
+      if (position + size - _stagingTail <= capacity) {
+        _stagingHead = position + size;
+        offset = position % capacity;
+        return true;
+      }
+
+      // batches the GPU is done with may not have been retired yet
+      retire_completed();
+      if (position + size - _stagingTail <= capacity) {
+        continue;
+      }
+
+      // the ring is full, make sure what is queued gets submitted and wait
+      // for the upload thread to retire batches
+      _spaceWaiters++;
+      _workAvailable.notify_one();
+      _spaceAvailable.wait(lock);
+      _spaceWaiters--;
+    }
+  }
+
+  uint64_t UploadQueue::upload_buffer(VkBuffer buffer, VkDeviceSize offset,
+                                      const void *data, VkDeviceSize size) {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    PendingCopy copy = {};
+    if (!allocate_staging(lock, size, copy._stagingOffset)) {
+      return 0;
+    }
+    copy._size = size;
+    copy._buffer = buffer;
+    copy._bufferOffset = offset;
+
+    std::memcpy(static_cast<uint8_t *>(_staging._mapped) + copy._stagingOffset,
+                data, size);
+    vmaFlushAllocation(_allocator->get(), _staging._allocation,
+                       copy._stagingOffset, size);
+
+    _pending.push_back(copy);
+    uint64_t value = _pendingValue;
+    lock.unlock();
+
+    _workAvailable.notify_one();
+    return value;
+  }
+
+  uint64_t UploadQueue::upload_image(VkImage image, VkExtent3D extent,
+                                     const void *data, VkDeviceSize size,
+                                     VkImageLayout finalLayout) {
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = extent;
+    return upload_image(image, {&region, 1}, data, size, finalLayout);
+  }
+
+  uint64_t UploadQueue::upload_image(VkImage image,
+                                     std::span<const VkBufferImageCopy> regions,
+                                     const void *data, VkDeviceSize size,
+                                     VkImageLayout finalLayout) {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    PendingCopy copy = {};
+    if (!allocate_staging(lock, size, copy._stagingOffset)) {
+      return 0;
+    }
+    copy._size = size;
+    copy._image = image;
+    copy._regions.assign(regions.begin(), regions.end());
+    copy._finalLayout = finalLayout;
+
+    std::memcpy(static_cast<uint8_t *>(_staging._mapped) + copy._stagingOffset,
+                data, size);
+    vmaFlushAllocation(_allocator->get(), _staging._allocation,
+                       copy._stagingOffset, size);
+
+    _pending.push_back(copy);
+    uint64_t value = _pendingValue;
+    lock.unlock();
+
+    _workAvailable.notify_one();
+    return value;
+  }
+
+  void UploadQueue::wait(uint64_t value) {
+    if (value == 0) {
+      return;
+    }
+
+    // a wait on a value nothing has been submitted to signal yet could
+    // hang, so the batch goes out first
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      wait_submitted(lock, value);
+    }
+
+    VkSemaphoreWaitInfo waitInfo = {};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.pNext = nullptr;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &_timeline;
+    waitInfo.pValues = &value;
+    VK_CHECK(vkWaitSemaphores(_device, &waitInfo, UINT64_MAX));
+  }
+
+  void UploadQueue::wait_submitted(std::unique_lock<std::mutex> &lock,
+                                   uint64_t value) {
+    if (_submittedValue >= value) {
+      return;
+    }
+    _workAvailable.notify_one();
+    _batchSubmitted.wait(lock,
+                         [this, value]() { return _submittedValue >= value; });
+  }
+
+  uint64_t UploadQueue::completed_value() const {
+    uint64_t value = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(_device, _timeline, &value));
+    return value;
+  }
+
+  uint64_t UploadQueue::record_acquire_barriers(VkCommandBuffer cmd) {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // copies queued before this frame must be on the transfer queue before
+    // the frame waits on them. The batch being filled is flushed now instead
+    // of being picked up by a later frame, and the one the upload thread may
+    // be recording right now is waited for
+    wait_submitted(lock, _pending.empty() ? _pendingValue - 1 : _pendingValue);
+
+    if (_submittedValue == _graphicsWaitedValue) {
+      return 0;
+    }
+
+    // the release half of these barriers has been recorded on the transfer
+    // queue, the semaphore wait orders the two
+    if (!_bufferAcquires.empty() || !_imageAcquires.empty()) {
+      vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+                           _bufferAcquires.size(), _bufferAcquires.data(),
+                           _imageAcquires.size(), _imageAcquires.data());
+      _bufferAcquires.clear();
+      _imageAcquires.clear();
+    }
+
+    _graphicsWaitedValue = _submittedValue;
+    return _submittedValue;
+  }
+
+  void UploadQueue::thread_loop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true) {
+      // batches are only waited on by the thread when a producer needs
+      // their staging space back, or on the way out
+      _workAvailable.wait(lock, [this]() {
+        return _stopping || !_pending.empty() ||
+               (_spaceWaiters > 0 && !_inFlight.empty());
+      });
+
+      if (!_pending.empty()) {
+        submit_pending(lock);
+        retire_completed();
+        continue;
+      }
+
+      if (_inFlight.empty()) {
+        // stopping with nothing left on the GPU
+        return;
+      }
+
+      uint64_t value = _inFlight.front()._value;
+      lock.unlock();
+
+      VkSemaphoreWaitInfo waitInfo = {};
+      waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+      waitInfo.pNext = nullptr;
+      waitInfo.semaphoreCount = 1;
+      waitInfo.pSemaphores = &_timeline;
+      waitInfo.pValues = &value;
+      VK_CHECK(vkWaitSemaphores(_device, &waitInfo, UINT64_MAX));
+
+      lock.lock();
+      retire_completed();
+    }
+  }
+
+  void UploadQueue::submit_pending(std::unique_lock<std::mutex> &lock) {
+    std::vector<PendingCopy> copies;
+    copies.swap(_pending);
+    uint64_t value = _pendingValue++;
+    uint64_t stagingEnd = _stagingHead;
+
+    VkCommandBuffer cmd;
+    if (_freeCommandBuffers.empty()) {
+      VkCommandBufferAllocateInfo allocInfo =
+          vk_abstract::command_buffer_allocate_info(_commandPool, 1);
+      VK_CHECK(vkAllocateCommandBuffers(_device, &allocInfo, &cmd));
+    } else {
+      cmd = _freeCommandBuffers.back();
+      _freeCommandBuffers.pop_back();
+    }
+
+    // the copies are recorded without holding the lock, producers can keep
+    // filling the next batch
+    lock.unlock();
+
+    VK_CHECK(vkResetCommandBuffer(cmd, 0));
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pNext = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+    const uint32_t srcFamily =
+        ownership_transfer() ? _queueFamily : VK_QUEUE_FAMILY_IGNORED;
+    const uint32_t dstFamily =
+        ownership_transfer() ? _graphicsQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+
+    std::vector<VkBufferMemoryBarrier> bufferReleases;
+    std::vector<VkImageMemoryBarrier> imageReleases;
+    std::vector<VkImageMemoryBarrier> imageTransitions;
+
+    VkImageSubresourceRange range = {};
+    range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel = 0;
+    range.levelCount = 1;
+    range.baseArrayLayer = 0;
+    range.layerCount = 1;
+
+    // images must be in TRANSFER_DST before copying into them
+    for (const PendingCopy &copy : copies) {
+      if (copy._image == VK_NULL_HANDLE) {
+        continue;
+      }
+      VkImageMemoryBarrier barrier = {};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.pNext = nullptr;
+      barrier.srcAccessMask = 0;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = copy._image;
+      barrier.subresourceRange = range;
+      imageTransitions.push_back(barrier);
+    }
+    if (!imageTransitions.empty()) {
+      vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                           nullptr, imageTransitions.size(),
+                           imageTransitions.data());
+    }
+
+    for (PendingCopy &copy : copies) {
+      if (copy._buffer != VK_NULL_HANDLE) {
+        VkBufferCopy region = {};
+        region.srcOffset = copy._stagingOffset;
+        region.dstOffset = copy._bufferOffset;
+        region.size = copy._size;
+        vkCmdCopyBuffer(cmd, _staging._buffer, copy._buffer, 1, &region);
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.pNext = nullptr;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = srcFamily;
+        barrier.dstQueueFamilyIndex = dstFamily;
+        barrier.buffer = copy._buffer;
+        barrier.offset = copy._bufferOffset;
+        barrier.size = copy._size;
+        bufferReleases.push_back(barrier);
+      } else {
+        for (VkBufferImageCopy &region : copy._regions) {
+          region.bufferOffset += copy._stagingOffset;
+        }
+        vkCmdCopyBufferToImage(cmd, _staging._buffer, copy._image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               copy._regions.size(), copy._regions.data());
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.pNext = nullptr;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = copy._finalLayout;
+        barrier.srcQueueFamilyIndex = srcFamily;
+        barrier.dstQueueFamilyIndex = dstFamily;
+        barrier.image = copy._image;
+        barrier.subresourceRange = range;
+        imageReleases.push_back(barrier);
+      }
+    }
+
+    // release the resources to the graphics queue, or just make the writes
+    // available when both use the same family. The semaphore signal makes
+    // them visible to the graphics submit waiting on it
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         bufferReleases.size(), bufferReleases.data(),
+                         imageReleases.size(), imageReleases.data());
+
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.pNext = nullptr;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
+    VkSubmitInfo submit = {};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.pNext = &timelineInfo;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &cmd;
+    submit.signalSemaphoreCount = 1;
+    submit.pSignalSemaphores = &_timeline;
+
+    if (_queueMutex != nullptr) {
+      std::lock_guard<std::mutex> queueLock(*_queueMutex);
+      VK_CHECK(vkQueueSubmit(_queue, 1, &submit, VK_NULL_HANDLE));
+    } else {
+      VK_CHECK(vkQueueSubmit(_queue, 1, &submit, VK_NULL_HANDLE));
+    }
+
+    lock.lock();
+
+    _inFlight.push_back({value, cmd, stagingEnd});
+    _submittedValue = value;
+    _batchSubmitted.notify_all();
+
+    // the graphics queue acquires the same resources with matching barriers
+    if (ownership_transfer()) {
+      for (VkBufferMemoryBarrier barrier : bufferReleases) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        _bufferAcquires.push_back(barrier);
+      }
+      for (VkImageMemoryBarrier barrier : imageReleases) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        _imageAcquires.push_back(barrier);
+      }
+    }
+  }
+
+  void UploadQueue::retire_completed() {
+    if (_inFlight.empty()) {
+      return;
+    }
+
+    uint64_t completed = completed_value();
+    bool retired = false;
+    while (!_inFlight.empty() && _inFlight.front()._value <= completed) {
+      _stagingTail = _inFlight.front()._stagingEnd;
+      _freeCommandBuffers.push_back(_inFlight.front()._cmd);
+      _inFlight.pop_front();
+      retired = true;
+    }
+
+    if (retired) {
+      _spaceAvailable.notify_all();
+    }
+  }
+} // namespace AltE
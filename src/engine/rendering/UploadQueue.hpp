@@ -0,0 +1,146 @@
+#pragma once
+
+#include "GpuAllocator.hpp"
+#include "vk_types.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  // streams data into buffers and images without stalling the render loop.
+  // The data is copied into a staging ring, and the copies are batched and
+  // submitted by a background thread on the transfer queue. Every batch
+  // signals the next value of a timeline semaphore, which the graphics
+  // submit waits on before using the uploaded resources
+  class UploadQueue {
+    public:
+      // queueMutex guards the queue when it is shared with the graphics
+      // submits, nullptr when the queue is only used by the upload thread
+      void init(VkDevice device, GpuAllocator &allocator, VkQueue queue,
+                uint32_t queueFamily, uint32_t graphicsQueueFamily,
+                std::mutex *queueMutex, VkDeviceSize stagingSize);
+
+      // submits what is still queued, waits for it and stops the thread
+      void cleanup();
+
+      // queue a copy of size bytes of data into the buffer. Returns the
+      // timeline value signaled once the copy is done, 0 if it couldn't be
+      // queued. Can be called from any thread
+      uint64_t upload_buffer(VkBuffer buffer, VkDeviceSize offset,
+                             const void *data, VkDeviceSize size);
+
+      // queue a copy of tightly packed texels into the first mip level of the
+      // image, which ends up in finalLayout
+      uint64_t upload_image(VkImage image, VkExtent3D extent, const void *data,
+                            VkDeviceSize size,
+                            VkImageLayout finalLayout =
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+      // same for parts of the first mip level, the bufferOffset of the
+      // regions are from the start of data. The rest of the image is
+      // undefined afterwards, it must hold nothing yet
+      uint64_t upload_image(VkImage image,
+                            std::span<const VkBufferImageCopy> regions,
+                            const void *data, VkDeviceSize size,
+                            VkImageLayout finalLayout =
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+      // blocks until the copies up to value are done
+      void wait(uint64_t value);
+
+      uint64_t completed_value() const;
+
+      // submits the uploads still queued and records the queue family
+      // ownership acquire of every upload since the last call. Returns the
+      // timeline value of the newest of them, which the graphics submit
+      // must wait on, 0 when there is nothing new to wait for
+      uint64_t record_acquire_barriers(VkCommandBuffer cmd);
+
+      VkSemaphore timeline() const { return _timeline; }
+
+    private:
+      struct PendingCopy {
+          VkDeviceSize _stagingOffset;
+          VkDeviceSize _size;
+
+          // either the buffer or the image is set
+          VkBuffer _buffer;
+          VkDeviceSize _bufferOffset;
+
+          VkImage _image;
+          // bufferOffset from _stagingOffset
+          std::vector<VkBufferImageCopy> _regions;
+          VkImageLayout _finalLayout;
+      };
+
+      struct InFlightBatch {
+          uint64_t _value;
+          VkCommandBuffer _cmd;
+          // staging ring position freed once the batch completes
+          uint64_t _stagingEnd;
+      };
+
+      VkDevice _device = VK_NULL_HANDLE;
+      GpuAllocator *_allocator = nullptr;
+
+      VkQueue _queue = VK_NULL_HANDLE;
+      uint32_t _queueFamily = 0;
+      uint32_t _graphicsQueueFamily = 0;
+      std::mutex *_queueMutex = nullptr;
+
+      VkCommandPool _commandPool = VK_NULL_HANDLE;
+      std::vector<VkCommandBuffer> _freeCommandBuffers;
+      VkSemaphore _timeline = VK_NULL_HANDLE;
+
+      // the staging ring, positions grow forever and are wrapped modulo
+      // the capacity
+      AllocatedBuffer _staging;
+      uint64_t _stagingHead = 0;
+      uint64_t _stagingTail = 0;
+
+      std::mutex _mutex;
+      // wakes up the upload thread
+      std::condition_variable _workAvailable;
+      // wakes up producers waiting for staging space
+      std::condition_variable _spaceAvailable;
+      // wakes up callers waiting for their batch to be submitted
+      std::condition_variable _batchSubmitted;
+      // producers blocked in allocate_staging, the upload thread only
+      // waits on the GPU to retire batches while there are some
+      uint32_t _spaceWaiters = 0;
+
+      std::vector<PendingCopy> _pending;
+      // timeline value that the batch being filled will signal
+      uint64_t _pendingValue = 1;
+      std::deque<InFlightBatch> _inFlight;
+
+      // ownership acquires waiting to be recorded on the graphics queue
+      std::vector<VkBufferMemoryBarrier> _bufferAcquires;
+      std::vector<VkImageMemoryBarrier> _imageAcquires;
+      // last value submitted, and last value the graphics queue waited on
+      uint64_t _submittedValue = 0;
+      uint64_t _graphicsWaitedValue = 0;
+
+      bool _stopping = false;
+      std::thread _thread;
+
+      // reserves size bytes of staging memory, blocks while the ring is full
+      bool allocate_staging(std::unique_lock<std::mutex> &lock,
+                            VkDeviceSize size, VkDeviceSize &offset);
+
+      void thread_loop();
+      void submit_pending(std::unique_lock<std::mutex> &lock);
+      // blocks until the batches up to value have been submitted
+      void wait_submitted(std::unique_lock<std::mutex> &lock, uint64_t value);
+      void retire_completed();
+
+      bool ownership_transfer() const {
+        return _queueFamily != _graphicsQueueFamily;
+      }
+  };
+} // namespace AltE
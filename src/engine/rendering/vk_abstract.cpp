@@ -118,6 +118,22 @@ vk_abstract::color_blend_attachment_state() {
   return colorBlendAttachment;
 }
 
+VkPipelineColorBlendAttachmentState
+vk_abstract::alpha_blend_attachment_state() {
+  VkPipelineColorBlendAttachmentState colorBlendAttachment =
+      color_blend_attachment_state();
+  colorBlendAttachment.blendEnable = VK_TRUE;
+  colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  colorBlendAttachment.dstColorBlendFactor =
+      VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+  colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+  colorBlendAttachment.dstAlphaBlendFactor =
+      VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+  return colorBlendAttachment;
+}
+
 VkPipelineLayoutCreateInfo vk_abstract::pipeline_layout_create_info() {
   VkPipelineLayoutCreateInfo info{};
   info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -27,6 +27,9 @@ namespace vk_abstract {
 
   VkPipelineColorBlendAttachmentState color_blend_attachment_state();
 
+  // blends with the alpha of the fragment, for the sprites
+  VkPipelineColorBlendAttachmentState alpha_blend_attachment_state();
+
   VkPipelineLayoutCreateInfo pipeline_layout_create_info();
 
   VkFenceCreateInfo fence_create_info(VkFenceCreateFlags flags = 0);
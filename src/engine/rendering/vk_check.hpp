@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdlib>
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.h>
+
+#define VK_CHECK(x)                                                            \
+  {                                                                            \
+    VkResult err = x;                                                          \
+    if (err != VK_SUCCESS) {                                                   \
+      spdlog::default_logger()->error("Detected Vulkan error: {}", err);       \
+      abort();                                                                 \
+    }                                                                          \
+  }
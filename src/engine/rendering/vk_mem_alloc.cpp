@@ -0,0 +1,4 @@
+// VulkanMemoryAllocator is a single header library, its implementation is
+// compiled in this translation unit only
+#define VMA_IMPLEMENTATION
+#include <vk_mem_alloc.h>
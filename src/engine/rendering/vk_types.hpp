@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+
+namespace AltE {
+  struct AllocatedBuffer {
+      VkBuffer _buffer = VK_NULL_HANDLE;
+      VmaAllocation _allocation = VK_NULL_HANDLE;
+      VkDeviceSize _size = 0;
+      // host address of the buffer when it is persistently mapped
+      void *_mapped = nullptr;
+  };
+
+  // buffer holding _count elements of T
+  template <typename T>
+  struct TypedBuffer : AllocatedBuffer {
+      size_t _count = 0;
+
+      // only valid for persistently mapped buffers
+      T *data() const { return static_cast<T *>(_mapped); }
+  };
+
+  struct AllocatedImage {
+      VkImage _image = VK_NULL_HANDLE;
+      VmaAllocation _allocation = VK_NULL_HANDLE;
+      VkFormat _format = VK_FORMAT_UNDEFINED;
+      VkExtent3D _extent = {0, 0, 0};
+  };
+} // namespace AltE
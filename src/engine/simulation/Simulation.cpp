@@ -0,0 +1,129 @@
+#include "Simulation.hpp"
+#include "../core/Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <spdlog/spdlog.h>
+
+namespace AltE {
+  SimulationState interpolate(const SimulationState &a,
+                              const SimulationState &b, float alpha) {
+    SimulationState state = b;
+    state._time = a._time + (b._time - a._time) * alpha;
+    for (int i = 0; i < 4; i++) {
+      state._clearColor[i] =
+          a._clearColor[i] + (b._clearColor[i] - a._clearColor[i]) * alpha;
+    }
+
+    // the angles wrap at 360, the short way round
+    float delta = b._planeAngle - a._planeAngle;
+    if (delta > 180.f) {
+      delta -= 360.f;
+    } else if (delta < -180.f) {
+      delta += 360.f;
+    }
+    state._planeAngle = std::fmod(a._planeAngle + delta * alpha + 360.f, 360.f);
+    return state;
+  }
+
+  void Simulation::start(uint32_t tickRate) {
+    tickRate = std::max(tickRate, 1u);
+    _tickSeconds = 1.0 / tickRate;
+    _tickPeriod = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(_tickSeconds));
+    _stopping = false;
+    _thread = std::thread([this]() { run(); });
+
+    SPDLOG_DEBUG("Simulation started at {} ticks per second", tickRate);
+  }
+
+  void Simulation::stop() {
+    if (!_thread.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+    _wakeUp.notify_all();
+    _thread.join();
+  }
+
+  void Simulation::set_paused(bool paused) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_paused == paused) {
+        return;
+      }
+      _paused = paused;
+    }
+    _wakeUp.notify_all();
+  }
+
+  SimulationState Simulation::sample(Clock::time_point time) {
+    const Snapshot &snapshot = _snapshots.read();
+    // past the current tick when the next one is late, the state then
+    // stays on the current tick
+    float alpha = std::chrono::duration<float>(time - snapshot._time).count() /
+                  (float)_tickSeconds;
+    return interpolate(snapshot._previous, snapshot._current,
+                       std::clamp(alpha, 0.f, 1.f));
+  }
+
+  void Simulation::run() {
+    Profiler::set_thread_name("simulation");
+
+    SimulationState state;
+    Clock::time_point due = Clock::now();
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_wakeUp.wait_until(lock, due,
+                               [this]() { return _stopping || _paused; })) {
+          // paused, the time until the ticks resume is dropped
+          _wakeUp.wait(lock, [this]() { return _stopping || !_paused; });
+          if (_stopping) {
+            return;
+          }
+          due = Clock::now();
+        }
+      }
+
+      if (Clock::now() - due > _tickPeriod * MAX_TICKS_BEHIND) {
+        SPDLOG_DEBUG("Simulation {} ticks late, skipping them",
+                     (Clock::now() - due) / _tickPeriod);
+        due = Clock::now();
+      }
+
+      Snapshot &snapshot = _snapshots.write_slot();
+      snapshot._previous = state;
+      {
+        ALTE_PROFILE_SCOPE("tick");
+        tick(state);
+      }
+      snapshot._current = state;
+      snapshot._time = due;
+      _snapshots.publish();
+
+      due += _tickPeriod;
+    }
+  }
+
+  void Simulation::tick(SimulationState &state) const {
+    state._tick++;
+    state._time += _tickSeconds;
+
+    // the clear color flashes with a period of 2 pi seconds. The phase is
+    // reduced while it is a double, a float time loses its precision
+    double phase = std::fmod(state._time * 0.5, std::numbers::pi);
+    state._clearColor[0] = 0.f;
+    state._clearColor[1] = 0.f;
+    state._clearColor[2] = std::abs(std::sin((float)phase));
+    state._clearColor[3] = 1.f;
+
+    // the plane turns slowly, 24 degrees per second
+    state._planeAngle =
+        std::fmod(state._planeAngle + 24.f * (float)_tickSeconds, 360.f);
+  }
+} // namespace AltE
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../core/TripleBuffer.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace AltE {
+  // everything the simulation decides that the frames show. Plain values,
+  // so two of them can be interpolated
+  struct SimulationState {
+      uint64_t _tick = 0;
+      // simulated seconds
+      double _time = 0.0;
+      float _clearColor[4] = {0.f, 0.f, 0.f, 1.f};
+      // of the plane under the camera, in degrees in [0, 360)
+      float _planeAngle = 0.f;
+  };
+
+  // the state between a and b, alpha from 0 (a) to 1 (b)
+  SimulationState interpolate(const SimulationState &a,
+                              const SimulationState &b, float alpha);
+
+  // the logic of the engine, ticked at a fixed rate on a thread of its own.
+  // A slow frame doesn't slow the simulation down, and a slow tick doesn't
+  // make the render thread wait: each tick publishes a snapshot through a
+  // triple buffer, the render thread reads the latest one and interpolates
+  // between its two states. The frames show the simulation one tick late,
+  // in exchange for a smooth motion at any frame rate.
+  //
+  // When the ticks fall too far behind the clock they give up on the lost
+  // time instead of running a burst of catch up ticks
+  class Simulation {
+    public:
+      using Clock = std::chrono::steady_clock;
+
+      // starts ticking tickRate times per second
+      void start(uint32_t tickRate);
+      // finishes the current tick and joins the thread
+      void stop();
+
+      // no tick while paused, the thread sleeps. The paused time is
+      // dropped, the simulation resumes where it stopped
+      void set_paused(bool paused);
+
+      // the state at time, interpolated between the two latest ticks.
+      // Render thread only
+      SimulationState sample(Clock::time_point time);
+
+    private:
+      // what a tick publishes, the tick before it and its own
+      struct Snapshot {
+          SimulationState _previous;
+          SimulationState _current;
+          // when the current tick was due
+          Clock::time_point _time;
+      };
+
+      // ticks behind the clock before the time is given up on
+      static constexpr uint32_t MAX_TICKS_BEHIND = 5;
+
+      Clock::duration _tickPeriod{};
+      double _tickSeconds = 0.0;
+      TripleBuffer<Snapshot> _snapshots;
+
+      std::thread _thread;
+      // guards _stopping and _paused
+      std::mutex _mutex;
+      std::condition_variable _wakeUp;
+      bool _stopping = false;
+      bool _paused = false;
+
+      void run();
+      // advances state by one tick
+      void tick(SimulationState &state) const;
+  };
+} // namespace AltE
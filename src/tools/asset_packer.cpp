@@ -0,0 +1,148 @@
+// Packs loose asset files into a single indexed archive, read at runtime by
+// AltE::AssetManager. Usage:
+//
+//   asset-packer <archive> <root> <files...>
+//
+// assets are named by their path relative to root, with '/' separators
+
+#include "../engine/assets/AssetArchive.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+  struct Asset {
+      std::string name;
+      uint64_t hash;
+      std::vector<char> content;
+  };
+
+  uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  bool read_file(const std::filesystem::path &path, std::vector<char> &out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(file),
+               std::istreambuf_iterator<char>());
+    return !file.bad();
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  namespace archive = AltE::asset_archive;
+
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <archive> <root> <files...>"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::filesystem::path output = argv[1];
+  const std::filesystem::path root = std::filesystem::absolute(argv[2]);
+
+  std::vector<Asset> assets;
+  for (int i = 3; i < argc; i++) {
+    std::filesystem::path path = std::filesystem::absolute(argv[i]);
+
+    Asset asset;
+    asset.name = path.lexically_relative(root).generic_string();
+    if (asset.name.empty() || asset.name.starts_with("..")) {
+      std::cerr << path << " is not inside " << root << std::endl;
+      return EXIT_FAILURE;
+    }
+    asset.hash = archive::hash_name(asset.name);
+
+    if (!read_file(path, asset.content)) {
+      std::cerr << "Can't read " << path << std::endl;
+      return EXIT_FAILURE;
+    }
+    assets.push_back(std::move(asset));
+  }
+
+  // the runtime binary searches the entries by hash
+  std::sort(assets.begin(), assets.end(),
+            [](const Asset &a, const Asset &b) { return a.hash < b.hash; });
+  for (size_t i = 1; i < assets.size(); i++) {
+    if (assets[i - 1].hash == assets[i].hash) {
+      std::cerr << "Hash collision between " << assets[i - 1].name << " and "
+                << assets[i].name << ", rename one of them" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  archive::Header header = {};
+  header.magic = archive::MAGIC;
+  header.version = archive::VERSION;
+  header.entryCount = assets.size();
+  header.entriesOffset = sizeof(archive::Header);
+  header.namesOffset =
+      header.entriesOffset + assets.size() * sizeof(archive::Entry);
+
+  std::vector<archive::Entry> entries(assets.size());
+  std::string names;
+  for (size_t i = 0; i < assets.size(); i++) {
+    entries[i].hash = assets[i].hash;
+    entries[i].nameOffset = names.size();
+    entries[i].nameSize = assets[i].name.size();
+    names += assets[i].name;
+  }
+
+  uint64_t offset = header.namesOffset + names.size();
+  for (size_t i = 0; i < assets.size(); i++) {
+    offset = align_up(offset, archive::BLOB_ALIGNMENT);
+    entries[i].offset = offset;
+    entries[i].size = assets[i].content.size();
+    offset += assets[i].content.size();
+  }
+
+  // write next to the destination and rename, so the engine never maps a
+  // half written archive
+  std::filesystem::path tmpOutput = output;
+  tmpOutput += ".tmp";
+  {
+    std::ofstream file(tmpOutput, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      std::cerr << "Can't write " << tmpOutput << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)entries.data(),
+               entries.size() * sizeof(archive::Entry));
+    file.write(names.data(), names.size());
+
+    uint64_t position = header.namesOffset + names.size();
+    const char padding[archive::BLOB_ALIGNMENT] = {};
+    for (size_t i = 0; i < assets.size(); i++) {
+      file.write(padding, entries[i].offset - position);
+      file.write(assets[i].content.data(), assets[i].content.size());
+      position = entries[i].offset + entries[i].size;
+    }
+
+    if (!file) {
+      std::cerr << "Failed to write " << tmpOutput << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tmpOutput, output, error);
+  if (error) {
+    std::cerr << "Can't replace " << output << ": " << error.message()
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Packed " << assets.size() << " assets into " << output
+            << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,314 @@
+// Converts a Wavefront OBJ file into the binary mesh format read by
+// AltE::MeshArena, see MeshFormat.hpp. Usage:
+//
+//   mesh-importer <input.obj> <output.mesh>
+//
+// faces are triangulated as fans, the vertices shared between faces are
+// deduplicated and the normals are computed when the file has none. Vertex
+// colors given after the positions ("v x y z r g b") are kept
+
+#include "../engine/assets/MeshFormat.hpp"
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+  namespace format = AltE::mesh_format;
+
+  using Vec3 = std::array<float, 3>;
+
+  struct ObjData {
+      std::vector<Vec3> positions;
+      std::vector<Vec3> colors;
+      std::vector<std::array<float, 2>> uvs;
+      std::vector<Vec3> normals;
+      // position, uv and normal of each triangle corner, -1 when absent
+      std::vector<std::array<int, 3>> corners;
+  };
+
+  Vec3 sub(const Vec3 &a, const Vec3 &b) {
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+  }
+
+  Vec3 cross(const Vec3 &a, const Vec3 &b) {
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+            a[0] * b[1] - a[1] * b[0]};
+  }
+
+  void normalize(Vec3 &v) {
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length > 0.f) {
+      v = {v[0] / length, v[1] / length, v[2] / length};
+    }
+  }
+
+  // OBJ indices start at 1, negative ones count from the end
+  bool resolve_index(const std::string &token, size_t count, int &out) {
+    if (token.empty()) {
+      out = -1;
+      return true;
+    }
+    long index = std::strtol(token.c_str(), nullptr, 10);
+    if (index < 0) {
+      index += (long)count;
+    } else {
+      index -= 1;
+    }
+    if (index < 0 || index >= (long)count) {
+      return false;
+    }
+    out = (int)index;
+    return true;
+  }
+
+  // "p", "p/t", "p//n" or "p/t/n"
+  bool parse_corner(const std::string &token, const ObjData &obj,
+                    std::array<int, 3> &out) {
+    std::string parts[3];
+    size_t part = 0;
+    for (char c : token) {
+      if (c == '/') {
+        if (++part == 3) {
+          return false;
+        }
+      } else {
+        parts[part] += c;
+      }
+    }
+    return !parts[0].empty() &&
+           resolve_index(parts[0], obj.positions.size(), out[0]) &&
+           resolve_index(parts[1], obj.uvs.size(), out[1]) &&
+           resolve_index(parts[2], obj.normals.size(), out[2]);
+  }
+
+  bool parse_obj(const std::filesystem::path &path, ObjData &obj) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+      std::cerr << "Can't read " << path << std::endl;
+      return false;
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+      lineNumber++;
+      std::istringstream stream(line);
+      std::string keyword;
+      stream >> keyword;
+
+      if (keyword == "v") {
+        Vec3 position = {};
+        Vec3 color = {1.f, 1.f, 1.f};
+        stream >> position[0] >> position[1] >> position[2];
+        if (!stream) {
+          std::cerr << path << ":" << lineNumber << ": bad vertex"
+                    << std::endl;
+          return false;
+        }
+        // the color is optional
+        stream >> color[0] >> color[1] >> color[2];
+        obj.positions.push_back(position);
+        obj.colors.push_back(stream ? color : Vec3{1.f, 1.f, 1.f});
+      } else if (keyword == "vt") {
+        std::array<float, 2> uv = {};
+        stream >> uv[0] >> uv[1];
+        // OBJ has V going up, Vulkan samples with V going down
+        obj.uvs.push_back({uv[0], 1.f - uv[1]});
+      } else if (keyword == "vn") {
+        Vec3 normal = {};
+        stream >> normal[0] >> normal[1] >> normal[2];
+        normalize(normal);
+        obj.normals.push_back(normal);
+      } else if (keyword == "f") {
+        std::vector<std::array<int, 3>> face;
+        std::string token;
+        while (stream >> token) {
+          std::array<int, 3> corner;
+          if (!parse_corner(token, obj, corner)) {
+            std::cerr << path << ":" << lineNumber << ": bad face index "
+                      << token << std::endl;
+            return false;
+          }
+          face.push_back(corner);
+        }
+        for (size_t i = 2; i < face.size(); i++) {
+          obj.corners.push_back(face[0]);
+          obj.corners.push_back(face[i - 1]);
+          obj.corners.push_back(face[i]);
+        }
+      }
+      // groups, materials and smoothing groups are ignored
+    }
+    return true;
+  }
+
+  struct Mesh {
+      std::vector<format::Vertex> vertices;
+      std::vector<uint32_t> indices;
+      Vec3 center;
+      float radius;
+  };
+
+  void build_mesh(const ObjData &obj, Mesh &mesh) {
+    // normals of the positions, for the corners without one: the sum of
+    // the face normals, weighted by their area
+    std::vector<Vec3> smoothNormals(obj.positions.size(), Vec3{});
+    for (size_t i = 0; i < obj.corners.size(); i += 3) {
+      const Vec3 &a = obj.positions[obj.corners[i][0]];
+      const Vec3 &b = obj.positions[obj.corners[i + 1][0]];
+      const Vec3 &c = obj.positions[obj.corners[i + 2][0]];
+      Vec3 faceNormal = cross(sub(b, a), sub(c, a));
+      for (size_t j = 0; j < 3; j++) {
+        Vec3 &normal = smoothNormals[obj.corners[i + j][0]];
+        for (size_t k = 0; k < 3; k++) {
+          normal[k] += faceNormal[k];
+        }
+      }
+    }
+    for (Vec3 &normal : smoothNormals) {
+      normalize(normal);
+    }
+
+    // a vertex per distinct corner
+    std::map<std::array<int, 3>, uint32_t> vertexIndices;
+    for (const std::array<int, 3> &corner : obj.corners) {
+      auto [it, inserted] =
+          vertexIndices.try_emplace(corner, (uint32_t)mesh.vertices.size());
+      mesh.indices.push_back(it->second);
+      if (!inserted) {
+        continue;
+      }
+
+      const Vec3 &position = obj.positions[corner[0]];
+      const Vec3 &color = obj.colors[corner[0]];
+      const Vec3 &normal =
+          corner[2] >= 0 ? obj.normals[corner[2]] : smoothNormals[corner[0]];
+
+      format::Vertex vertex = {};
+      vertex.position[0] = position[0];
+      vertex.position[1] = position[1];
+      vertex.position[2] = position[2];
+      format::encode_octahedral(normal.data(), vertex.normal);
+      if (corner[1] >= 0) {
+        vertex.uv[0] = format::float_to_half(obj.uvs[corner[1]][0]);
+        vertex.uv[1] = format::float_to_half(obj.uvs[corner[1]][1]);
+      }
+      for (size_t k = 0; k < 3; k++) {
+        vertex.color[k] = format::to_unorm8(color[k]);
+      }
+      vertex.color[3] = 255;
+      mesh.vertices.push_back(vertex);
+    }
+
+    // bounding sphere centered on the bounding box, not the smallest one
+    // but close enough for culling
+    Vec3 min = {INFINITY, INFINITY, INFINITY};
+    Vec3 max = {-INFINITY, -INFINITY, -INFINITY};
+    for (const format::Vertex &vertex : mesh.vertices) {
+      for (size_t k = 0; k < 3; k++) {
+        min[k] = std::min(min[k], vertex.position[k]);
+        max[k] = std::max(max[k], vertex.position[k]);
+      }
+    }
+    mesh.center = {(min[0] + max[0]) / 2.f, (min[1] + max[1]) / 2.f,
+                   (min[2] + max[2]) / 2.f};
+    mesh.radius = 0.f;
+    for (const format::Vertex &vertex : mesh.vertices) {
+      Vec3 position = {vertex.position[0], vertex.position[1],
+                       vertex.position[2]};
+      Vec3 offset = sub(position, mesh.center);
+      mesh.radius = std::max(mesh.radius,
+                             std::sqrt(offset[0] * offset[0] +
+                                       offset[1] * offset[1] +
+                                       offset[2] * offset[2]));
+    }
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <input.obj> <output.mesh>"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::filesystem::path input = argv[1];
+  const std::filesystem::path output = argv[2];
+
+  ObjData obj;
+  if (!parse_obj(input, obj)) {
+    return EXIT_FAILURE;
+  }
+  if (obj.corners.empty()) {
+    std::cerr << input << " has no faces" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Mesh mesh;
+  build_mesh(obj, mesh);
+
+  // 16 bits indices halve the index buffer when they are enough
+  uint32_t indexSize =
+      mesh.vertices.size() <= format::MAX_16BIT_VERTICES ? 2 : 4;
+
+  format::Header header = {};
+  header.magic = format::MAGIC;
+  header.version = format::VERSION;
+  header.vertexCount = mesh.vertices.size();
+  header.indexCount = mesh.indices.size();
+  header.indexSize = indexSize;
+  header.center[0] = mesh.center[0];
+  header.center[1] = mesh.center[1];
+  header.center[2] = mesh.center[2];
+  header.radius = mesh.radius;
+
+  // write next to the destination and rename, like the asset packer
+  std::filesystem::path tmpOutput = output;
+  tmpOutput += ".tmp";
+  {
+    std::ofstream file(tmpOutput, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      std::cerr << "Can't write " << tmpOutput << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)mesh.vertices.data(),
+               mesh.vertices.size() * sizeof(format::Vertex));
+    if (indexSize == 2) {
+      std::vector<uint16_t> indices(mesh.indices.begin(),
+                                    mesh.indices.end());
+      file.write((const char *)indices.data(),
+                 indices.size() * sizeof(uint16_t));
+    } else {
+      file.write((const char *)mesh.indices.data(),
+                 mesh.indices.size() * sizeof(uint32_t));
+    }
+
+    if (!file) {
+      std::cerr << "Failed to write " << tmpOutput << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tmpOutput, output, error);
+  if (error) {
+    std::cerr << "Can't replace " << output << ": " << error.message()
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Imported " << input << ": " << header.vertexCount
+            << " vertices, " << header.indexCount << " indices of "
+            << indexSize * 8 << " bits" << std::endl;
+  return EXIT_SUCCESS;
+}